@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WEB_SOCKET_CPP_BENCH_COMMON_H
+#define WEB_SOCKET_CPP_BENCH_COMMON_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CommunicationClientBase.h"
+#include "CommunicationServerBase.h"
+
+namespace Bench
+{
+
+using namespace WebSocketCpp;
+
+// discards everything written, so only the cost of building the data is measured
+class NullServer : public CommunicationServerBase
+{
+public:
+    bool Init() override
+    {
+        return true;
+    }
+    bool Run() override
+    {
+        return true;
+    }
+    bool Close(bool) override
+    {
+        return true;
+    }
+    bool WaitFor() override
+    {
+        return true;
+    }
+    bool Connect(const std::string&, int) override
+    {
+        return true;
+    }
+    void SetPort(int) override
+    {
+    }
+    int GetPort() const override
+    {
+        return 0;
+    }
+    void SetHost(const std::string&) override
+    {
+    }
+    std::string GetHost() const override
+    {
+        return "";
+    }
+    bool Write(int, ByteArray& data) override
+    {
+        m_bytes += data.size();
+        if (m_keep)
+        {
+            m_last = data;
+        }
+        return true;
+    }
+    bool Write(int, ByteArray&, size_t size) override
+    {
+        m_bytes += size;
+        return true;
+    }
+    bool CloseConnection(int) override
+    {
+        return true;
+    }
+    bool SetNewConnectionCallback(NewConnectionCallback) override
+    {
+        return true;
+    }
+    bool SetDataReadyCallback(DataReadyCallback) override
+    {
+        return true;
+    }
+    bool SetCloseConnectionCallback(CloseConnectionCallback) override
+    {
+        return true;
+    }
+
+    size_t    m_bytes = 0;
+    bool      m_keep  = false; // keep the last written data
+    ByteArray m_last;
+};
+
+// keeps the last written frame, used to produce client frames for the parser
+class NullClient : public CommunicationClientBase
+{
+public:
+    bool Init() override
+    {
+        return true;
+    }
+    bool Run() override
+    {
+        return true;
+    }
+    bool Close(bool) override
+    {
+        return true;
+    }
+    bool WaitFor() override
+    {
+        return true;
+    }
+    bool Connect(const std::string&, int) override
+    {
+        return true;
+    }
+    void SetPort(int) override
+    {
+    }
+    int GetPort() const override
+    {
+        return 0;
+    }
+    void SetHost(const std::string&) override
+    {
+    }
+    std::string GetHost() const override
+    {
+        return "";
+    }
+    bool Write(const ByteArray& data) override
+    {
+        m_last = data;
+        return true;
+    }
+    bool SetDataReadyCallback(DataReadyCallback) override
+    {
+        return true;
+    }
+    bool SetCloseConnectionCallback(CloseConnectionCallback) override
+    {
+        return true;
+    }
+
+    ByteArray m_last;
+};
+
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result
+{
+    std::string name;
+    uint64_t    iterations = 0;
+    double      seconds    = 0;
+    uint64_t    bytes      = 0; // processed per iteration, 0 - not a throughput case
+    bool        latency    = false;
+    double      p50        = 0; // ns, valid if latency is set
+    double      p99        = 0;
+    double      p999       = 0;
+
+    double NsPerOp() const
+    {
+        return iterations > 0 ? seconds * 1e9 / iterations : 0;
+    }
+    double OpsPerSec() const
+    {
+        return seconds > 0 ? iterations / seconds : 0;
+    }
+    double BytesPerSec() const
+    {
+        return seconds > 0 ? static_cast<double>(bytes) * iterations / seconds : 0;
+    }
+};
+
+/*
+ * A minimal harness: every case is repeated with a growing iteration count
+ * until one pass takes at least the minimal time, the last pass is reported.
+ */
+class Suite
+{
+public:
+    Suite(const std::string& filter, double minTime)
+        : m_filter(filter),
+          m_minTime(minTime)
+    {
+    }
+
+    bool IsSelected(const std::string& name) const
+    {
+        return m_filter.empty() || name.find(m_filter) != std::string::npos;
+    }
+
+    double GetMinTime() const
+    {
+        return m_minTime;
+    }
+
+    template <typename F>
+    void Run(const std::string& name, size_t bytes, F func)
+    {
+        if (!IsSelected(name))
+        {
+            return;
+        }
+
+        func();
+
+        const uint64_t maxIterations = 1ull << 32;
+        uint64_t       iterations    = 1;
+        double   elapsed    = 0;
+        while (true)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                func();
+            }
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= m_minTime || iterations >= maxIterations)
+            {
+                break;
+            }
+
+            uint64_t next = elapsed > 0 ? static_cast<uint64_t>(iterations * m_minTime * 1.2 / elapsed) : iterations * 100;
+            iterations    = std::min(std::max(next, iterations * 2), std::min(iterations * 100, maxIterations));
+        }
+
+        Result result;
+        result.name       = name;
+        result.iterations = iterations;
+        result.seconds    = elapsed;
+        result.bytes      = bytes;
+        Add(result);
+    }
+
+    // latencies are in ns and get sorted
+    static void SetLatency(Result& result, std::vector<uint64_t>& latencies)
+    {
+        if (latencies.empty())
+        {
+            return;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        auto at = [&latencies](double percent) -> double {
+            size_t index = static_cast<size_t>(percent / 100.0 * (latencies.size() - 1) + 0.5);
+            return static_cast<double>(latencies[index]);
+        };
+        result.latency = true;
+        result.p50     = at(50);
+        result.p99     = at(99);
+        result.p999    = at(99.9);
+    }
+
+    void Add(const Result& result)
+    {
+        m_results.push_back(result);
+        if (m_progress != nullptr)
+        {
+            PrintText(m_progress, result);
+        }
+    }
+
+    void SetProgress(FILE* out)
+    {
+        m_progress = out;
+    }
+
+    const std::vector<Result>& GetResults() const
+    {
+        return m_results;
+    }
+
+    static void PrintText(FILE* out, const Result& result)
+    {
+        fprintf(out, "%-36s %12llu %12.1f ns/op %14.0f ops/s", result.name.c_str(), static_cast<unsigned long long>(result.iterations), result.NsPerOp(), result.OpsPerSec());
+        if (result.bytes > 0)
+        {
+            fprintf(out, " %10.1f MB/s", result.BytesPerSec() / (1024 * 1024));
+        }
+        if (result.latency)
+        {
+            fprintf(out, "  p50 %.1f us p99 %.1f us p99.9 %.1f us", result.p50 / 1000, result.p99 / 1000, result.p999 / 1000);
+        }
+        fprintf(out, "\n");
+    }
+
+    void PrintJson(FILE* out) const
+    {
+        fprintf(out, "[\n");
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            const Result& result = m_results[i];
+            fprintf(out, "  {\"name\": \"%s\", \"iterations\": %llu, \"seconds\": %.6f, \"ns_per_op\": %.3f, \"ops_per_sec\": %.3f",
+                result.name.c_str(),
+                static_cast<unsigned long long>(result.iterations),
+                result.seconds,
+                result.NsPerOp(),
+                result.OpsPerSec());
+            if (result.bytes > 0)
+            {
+                fprintf(out, ", \"bytes_per_op\": %llu, \"bytes_per_sec\": %.3f", static_cast<unsigned long long>(result.bytes), result.BytesPerSec());
+            }
+            if (result.latency)
+            {
+                fprintf(out, ", \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f", result.p50, result.p99, result.p999);
+            }
+            fprintf(out, "}%s\n", i + 1 < m_results.size() ? "," : "");
+        }
+        fprintf(out, "]\n");
+    }
+
+private:
+    std::string         m_filter;
+    double              m_minTime;
+    FILE*               m_progress = nullptr;
+    std::vector<Result> m_results;
+};
+
+} // namespace Bench
+
+#endif // WEB_SOCKET_CPP_BENCH_COMMON_H
@@ -0,0 +1,638 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DebugPrint.h"
+#include "HandshakeResponse.h"
+#include "MemoryPool.h"
+#include "Metrics.h"
+#include "Request.h"
+#include "RequestWebSocket.h"
+#include "ResponseWebSocket.h"
+#include "RouteTable.h"
+#include "StringUtil.h"
+#include "TimerWheel.h"
+#include "WebSocketClient.h"
+#include "WebSocketServer.h"
+#include "bench_common.h"
+
+using namespace WebSocketCpp;
+using namespace Bench;
+
+static const size_t   FRAME_SIZES[]        = {16, 125, 1024, 65536};
+static const size_t   ECHO_SIZES[]         = {16, 1024, 65536};
+static const size_t   ECHO_CONNECTIONS[]   = {1, 4, 16};
+static const int      ECHO_TIMEOUT_MS      = 2000;
+static const char     HANDSHAKE_KEY[]      = "dGhlIHNhbXBsZSBub25jZQ==";
+static const size_t   ROUTE_COUNT          = 64;
+static const size_t   CONNECT_CLIENT_COUNT = 64; // the closed connections may linger a bit
+static const size_t   STORM_THREADS        = 4;
+static const size_t   TIMER_COUNT          = 1000000;
+static const uint64_t TIMER_TICK_MS        = 10;
+static const uint64_t TIMER_INTERVAL_MS    = 30000;
+
+static ByteArray Payload(size_t size)
+{
+    ByteArray payload(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        payload[i] = static_cast<uint8_t>('a' + i % 26);
+    }
+    return payload;
+}
+
+static bool BenchFrames(Suite& suite)
+{
+    for (size_t size : FRAME_SIZES)
+    {
+        std::string suffix  = "/" + std::to_string(size);
+        ByteArray   payload = Payload(size);
+
+        NullServer        server;
+        ResponseWebSocket response(0);
+        response.WriteBinary(payload);
+        suite.Run("frame/serialize" + suffix, size, [&]() {
+            response.Send(&server);
+        });
+
+        // a client frame is masked, so building it measures the masking
+        NullClient       client;
+        RequestWebSocket request;
+        request.SetType(MessageType::Binary);
+        request.SetData(payload);
+        suite.Run("frame/mask" + suffix, size, [&]() {
+            request.Send(&client);
+        });
+
+        // the server side parsing unmasks the payload
+        request.Send(&client);
+        ByteArray masked = client.m_last;
+        suite.Run("frame/parse_unmask" + suffix, size, [&]() {
+            RequestWebSocket frame;
+            DoNotOptimize(frame.Parse(masked));
+        });
+
+        server.m_keep = true;
+        response.Send(&server);
+        server.m_keep = false;
+
+        ByteArray         unmasked = server.m_last;
+        ResponseWebSocket check(0);
+        if (!check.Parse(unmasked) || check.GetData().size() != size)
+        {
+            fprintf(stderr, "frame/parse%s: the frame is not parsed back\n", suffix.c_str());
+            return false;
+        }
+        suite.Run("frame/parse" + suffix, size, [&]() {
+            ResponseWebSocket frame(0);
+            DoNotOptimize(frame.Parse(unmasked));
+        });
+    }
+
+    return true;
+}
+
+static void BenchHandshake(Suite& suite)
+{
+    std::string text = "GET /ws/chat HTTP/1.1\r\n"
+                       "Host: server.example.com\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: " +
+        std::string(HANDSHAKE_KEY) +
+        "\r\n"
+        "Origin: http://example.com\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "\r\n";
+    ByteArray data(text.begin(), text.end());
+
+    suite.Run("handshake/parse_request", data.size(), [&]() {
+        Request request;
+        DoNotOptimize(request.Parse(data));
+    });
+
+    NullServer        server;
+    HandshakeResponse handshake;
+    handshake.Init(Config::Instance().GetServerName());
+    suite.Run("handshake/response", 0, [&]() {
+        handshake.Build(HANDSHAKE_KEY);
+        server.Write(0, handshake.GetData());
+    });
+}
+
+static void BenchMemoryPool(Suite& suite)
+{
+    MemoryPool pool(1024 * 1024);
+
+    for (size_t size : {64, 4096})
+    {
+        suite.Run("memorypool/allocate_free/" + std::to_string(size), 0, [&]() {
+            uint8_t* ptr = pool.allocate(size);
+            DoNotOptimize(ptr);
+            pool.free(ptr);
+        });
+    }
+
+    // a ring of live allocations, so every call has to search among the regions
+    const size_t          live = 64;
+    std::vector<uint8_t*> ring(live, nullptr);
+    size_t                index = 0;
+    for (auto& ptr : ring)
+    {
+        ptr = pool.allocate(512);
+    }
+    suite.Run("memorypool/fragmented/64", 0, [&]() {
+        pool.free(ring[index]);
+        ring[index] = pool.allocate(512);
+        index       = (index + 1) % live;
+    });
+    for (auto ptr : ring)
+    {
+        pool.free(ptr);
+    }
+}
+
+// a million connections with a heartbeat each, spread evenly over the interval:
+// a reschedule among them, and one tick of the reactor where every expired
+// timer arms itself again like the ping does
+static void BenchTimers(Suite& suite)
+{
+    if (!suite.IsSelected("timerwheel/reschedule/1M") && !suite.IsSelected("timerwheel/tick/1M"))
+    {
+        return;
+    }
+
+    uint64_t   now = 0;
+    TimerWheel wheel(TIMER_COUNT, TIMER_TICK_MS, now);
+    for (uint32_t id = 0; id < TIMER_COUNT; id++)
+    {
+        wheel.Schedule(id, now + 1 + (static_cast<uint64_t>(id) * 7919) % TIMER_INTERVAL_MS);
+    }
+
+    uint32_t id = 0;
+    suite.Run("timerwheel/reschedule/1M", 0, [&]() {
+        wheel.Schedule(id, now + 1 + (static_cast<uint64_t>(id) * 104729) % TIMER_INTERVAL_MS);
+        id = (id + 1) % TIMER_COUNT;
+    });
+
+    suite.Run("timerwheel/tick/1M", 0, [&]() {
+        now += TIMER_TICK_MS;
+        wheel.Advance(now, [&](uint32_t expired) { wheel.Schedule(expired, now + TIMER_INTERVAL_MS); });
+    });
+}
+
+static void BenchStringUtil(Suite& suite)
+{
+    const ByteArray separator = {'\r', '\n', '\r', '\n'};
+    const ByteArray delimiter = {'\r', '\n'};
+
+    for (size_t size : {256, 4096})
+    {
+        std::string text;
+        for (size_t i = 0; text.size() + 32 < size; i++)
+        {
+            text += "X-Header-" + std::to_string(i) + ": value\r\n";
+        }
+        text += "\r\n";
+        ByteArray data(text.begin(), text.end());
+
+        suite.Run("stringutil/search/" + std::to_string(size), data.size(), [&]() {
+            DoNotOptimize(StringUtil::Search(data.data(), data.size(), separator.data(), separator.size()));
+        });
+        suite.Run("stringutil/split/" + std::to_string(size), data.size(), [&]() {
+            auto ranges = StringUtil::Split(data, delimiter);
+            DoNotOptimize(ranges.size());
+        });
+    }
+}
+
+static void BenchRoutes(Suite& suite)
+{
+    RouteTable table;
+    for (size_t i = 0; i < ROUTE_COUNT; i++)
+    {
+        std::string path = "/api/v1/resource" + std::to_string(i);
+        table.Add(std::make_shared<RouteWebSocket>(path, nullptr));
+        table.Add(std::make_shared<RouteWebSocket>(path + "/{id:numeric}", nullptr));
+    }
+    table.Add(std::make_shared<RouteWebSocket>("/ws/chat/{room}", nullptr));
+
+    auto match = [&suite, &table](const std::string& name, const std::string& path) {
+        Request request;
+        request.SetMethod(Method::WEBSOCKET);
+        request.GetUrl().Parse(path, false);
+        suite.Run("route/match/" + name, 0, [&]() {
+            RouteTable::Matches matches;
+            DoNotOptimize(table.Match(request, matches));
+        });
+    };
+    match("literal", "/api/v1/resource42");
+    match("variable", "/api/v1/resource42/12345");
+    match("wide", "/ws/chat/lobby");
+    match("miss", "/static/file.css");
+}
+
+static int FindFreePort()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+    int port = ntohs(addr.sin_port);
+    ::close(fd);
+    return port;
+}
+
+struct EchoConnection
+{
+    WebSocketClient         client;
+    std::mutex              mutex;
+    std::condition_variable signal;
+    uint64_t                received = 0;
+    std::vector<uint64_t>   latencies;
+};
+
+struct EchoTls
+{
+    std::string cert;
+    std::string key;
+    bool        ktls = false;
+};
+
+// every connection keeps one message in flight, the round trip is the latency,
+// with tls the same loopback goes over WSS so the two can be compared.
+// The storm threads meanwhile open and close new WSS connections with full
+// handshakes, the latency of the established ones shouldn't suffer from that
+static bool BenchEcho(Suite& suite, size_t size, size_t connections, const EchoTls* tls = nullptr, bool storm = false)
+{
+    std::string name = std::string(tls ? (storm ? "echo_wss_storm/" : "echo_wss/") : "echo/") + std::to_string(size) + "b/" + std::to_string(connections) + "c";
+    if (!suite.IsSelected(name))
+    {
+        return true;
+    }
+
+    int      port      = FindFreePort();
+    Config&  config    = Config::Instance();
+    size_t   cacheSize = config.GetSslSessionCacheSize();
+    uint64_t lifetime  = config.GetSslTicketKeyLifetimeSec();
+    config.SetWsProtocol(tls ? Protocol::WSS : Protocol::WS);
+    config.SetWsServerPort(port);
+    config.SetMaxClientCount(storm ? connections + CONNECT_CLIENT_COUNT : connections);
+    if (tls)
+    {
+        config.SetSslSertificate(tls->cert);
+        config.SetSslKey(tls->key);
+        config.SetSslKtls(tls->ktls);
+        config.SetSslSessionCacheSize(storm ? 0 : cacheSize);
+        config.SetSslTicketKeyLifetimeSec(storm ? 0 : lifetime);
+    }
+    uint64_t kernelBefore = Metrics::Instance().GetSnapshot().Get(Metrics::Counter::TlsKernelConnections);
+
+    WebSocketServer server;
+    bool            initialized = server.Init();
+    config.SetSslSessionCacheSize(cacheSize);
+    config.SetSslTicketKeyLifetimeSec(lifetime);
+    if (!initialized)
+    {
+        fprintf(stderr, "%s: %s\n", name.c_str(), server.GetLastError().c_str());
+        return false;
+    }
+    server.OnMessage("/echo", [](const Request&, ResponseWebSocket& response, const ByteArray& data) -> bool {
+        response.WriteBinary(data);
+        return true;
+    });
+    if (!server.Run())
+    {
+        fprintf(stderr, "%s: %s\n", name.c_str(), server.GetLastError().c_str());
+        return false;
+    }
+
+    bool                                         retval = true;
+    std::string                                  url    = std::string(tls ? "wss" : "ws") + "://127.0.0.1:" + std::to_string(port) + "/echo";
+    std::vector<std::unique_ptr<EchoConnection>> pool;
+    for (size_t i = 0; i < connections && retval; i++)
+    {
+        pool.emplace_back(new EchoConnection());
+        EchoConnection* connection = pool.back().get();
+        connection->client.SetOnMessage([connection](ResponseWebSocket&) {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->received++;
+            connection->signal.notify_one();
+        });
+        if (!connection->client.Init() || !connection->client.Open(url))
+        {
+            fprintf(stderr, "%s: %s\n", name.c_str(), connection->client.GetLastError().c_str());
+            retval = false;
+        }
+    }
+
+    if (retval)
+    {
+        ByteArray         payload = Payload(size);
+        std::atomic<bool> failed{false};
+        auto              start    = std::chrono::steady_clock::now();
+        auto              deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(suite.GetMinTime()));
+
+        std::vector<std::thread> threads;
+        std::atomic<bool>        stop{false};
+        for (size_t i = 0; i < (storm ? STORM_THREADS : 0); i++)
+        {
+            threads.emplace_back([&url, &stop]() {
+                while (!stop)
+                {
+                    WebSocketClient client;
+                    if (client.Init())
+                    {
+                        client.Open(url);
+                    }
+                    client.Close();
+                }
+            });
+        }
+        for (auto& ptr : pool)
+        {
+            EchoConnection* connection = ptr.get();
+            threads.emplace_back([connection, &payload, &failed, deadline]() {
+                uint64_t sent = 0;
+                while (!failed && std::chrono::steady_clock::now() < deadline)
+                {
+                    auto sendTime = std::chrono::steady_clock::now();
+                    if (!connection->client.SendBinary(payload))
+                    {
+                        failed = true;
+                        break;
+                    }
+                    sent++;
+
+                    std::unique_lock<std::mutex> lock(connection->mutex);
+                    if (!connection->signal.wait_for(lock, std::chrono::milliseconds(ECHO_TIMEOUT_MS), [connection, sent]() { return connection->received >= sent; }))
+                    {
+                        failed = true;
+                        break;
+                    }
+                    connection->latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sendTime).count());
+                }
+            });
+        }
+        for (size_t i = (storm ? STORM_THREADS : 0); i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stop           = true;
+        for (size_t i = 0; i < (storm ? STORM_THREADS : 0); i++)
+        {
+            threads[i].join();
+        }
+
+        if (failed)
+        {
+            fprintf(stderr, "%s: the echo has failed or timed out\n", name.c_str());
+            retval = false;
+        }
+        else
+        {
+            std::vector<uint64_t> latencies;
+            for (auto& connection : pool)
+            {
+                latencies.insert(latencies.end(), connection->latencies.begin(), connection->latencies.end());
+            }
+
+            Result result;
+            result.name       = name;
+            result.iterations = latencies.size();
+            result.seconds    = elapsed;
+            result.bytes      = size * 2; // there and back
+            Suite::SetLatency(result, latencies);
+            suite.Add(result);
+        }
+
+        if (tls && tls->ktls && Metrics::Instance().GetSnapshot().Get(Metrics::Counter::TlsKernelConnections) == kernelBefore)
+        {
+            fprintf(stderr, "%s: kernel TLS wasn't available, the records were encrypted by OpenSSL\n", name.c_str());
+        }
+    }
+
+    for (auto& connection : pool)
+    {
+        connection->client.Close();
+    }
+    server.Close();
+
+    return retval;
+}
+
+// a reconnect storm in small: every iteration is a new WSS connection, with the
+// session resumption on the server or without it
+static bool BenchConnect(Suite& suite, const EchoTls& tls, bool resume)
+{
+    std::string name = std::string("connect_wss/") + (resume ? "resumed" : "full");
+    if (!suite.IsSelected(name))
+    {
+        return true;
+    }
+
+    int      port      = FindFreePort();
+    Config&  config    = Config::Instance();
+    size_t   cacheSize = config.GetSslSessionCacheSize();
+    uint64_t lifetime  = config.GetSslTicketKeyLifetimeSec();
+    config.SetWsProtocol(Protocol::WSS);
+    config.SetWsServerPort(port);
+    config.SetMaxClientCount(CONNECT_CLIENT_COUNT);
+    config.SetSslSertificate(tls.cert);
+    config.SetSslKey(tls.key);
+    config.SetSslKtls(false);
+    config.SetSslSessionCacheSize(resume ? cacheSize : 0);
+    config.SetSslTicketKeyLifetimeSec(resume ? lifetime : 0);
+
+    WebSocketServer server;
+    server.OnMessage("/echo", [](const Request&, ResponseWebSocket&, const ByteArray&) -> bool {
+        return true;
+    });
+    bool retval = server.Init() && server.Run();
+    config.SetSslSessionCacheSize(cacheSize);
+    config.SetSslTicketKeyLifetimeSec(lifetime);
+    if (!retval)
+    {
+        fprintf(stderr, "%s: %s\n", name.c_str(), server.GetLastError().c_str());
+        return false;
+    }
+
+    std::string url = "wss://127.0.0.1:" + std::to_string(port) + "/echo";
+    suite.Run(name, 0, [&]() {
+        WebSocketClient client;
+        if (!client.Init() || !client.Open(url))
+        {
+            retval = false;
+        }
+        client.Close();
+    });
+    server.Close();
+
+    if (!retval)
+    {
+        fprintf(stderr, "%s: the connection has failed\n", name.c_str());
+    }
+    return retval;
+}
+
+static void PrintUsage(const char* exe)
+{
+    printf("Usage: %s [options]\n", exe);
+    printf("where [options] are:\n");
+    printf("\t--filter <text>: run only the cases which name contains the text\n");
+    printf("\t--min-time <sec>: minimal time of a case, default 0.5\n");
+    printf("\t--json: print the results as a JSON array to stdout, the progress goes to stderr\n");
+    printf("\t--out <file>: write the results as a JSON array to the file\n");
+    printf("\t--no-echo: skip the loopback server/client cases\n");
+#ifdef WITH_OPENSSL
+    printf("\t--cert <file> --key <file>: also run the echo, handshake storm and connect cases over WSS with these PEM files\n");
+    printf("\t--ktls: let the WSS server send through kernel TLS\n");
+#endif
+    printf("\t-h: print this message and exit\n");
+}
+
+int main(int argc, char** argv)
+{
+    DebugPrint::AllowPrint = false;
+
+    std::string filter;
+    std::string out;
+    double      minTime = 0.5;
+    bool        json    = false;
+    bool        echo    = true;
+    EchoTls     tls;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--min-time" && i + 1 < argc)
+        {
+            minTime = strtod(argv[++i], nullptr);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            out = argv[++i];
+        }
+        else if (arg == "--json")
+        {
+            json = true;
+        }
+        else if (arg == "--no-echo")
+        {
+            echo = false;
+        }
+#ifdef WITH_OPENSSL
+        else if (arg == "--cert" && i + 1 < argc)
+        {
+            tls.cert = argv[++i];
+        }
+        else if (arg == "--key" && i + 1 < argc)
+        {
+            tls.key = argv[++i];
+        }
+        else if (arg == "--ktls")
+        {
+            tls.ktls = true;
+        }
+#endif
+        else
+        {
+            PrintUsage(argv[0]);
+            return arg == "-h" ? 0 : 1;
+        }
+    }
+
+    Suite suite(filter, minTime);
+    suite.SetProgress(json ? stderr : stdout);
+
+    bool ok = BenchFrames(suite);
+    BenchHandshake(suite);
+    BenchMemoryPool(suite);
+    BenchTimers(suite);
+    BenchStringUtil(suite);
+    BenchRoutes(suite);
+
+    if (echo)
+    {
+        for (size_t size : ECHO_SIZES)
+        {
+            for (size_t connections : ECHO_CONNECTIONS)
+            {
+                ok = BenchEcho(suite, size, connections) && ok;
+                if (!tls.cert.empty() && !tls.key.empty())
+                {
+                    ok = BenchEcho(suite, size, connections, &tls) && ok;
+                    ok = BenchEcho(suite, size, connections, &tls, true) && ok;
+                }
+            }
+        }
+        if (!tls.cert.empty() && !tls.key.empty())
+        {
+            ok = BenchConnect(suite, tls, false) && ok;
+            ok = BenchConnect(suite, tls, true) && ok;
+        }
+    }
+
+    if (json)
+    {
+        suite.PrintJson(stdout);
+    }
+    if (!out.empty())
+    {
+        FILE* file = fopen(out.c_str(), "w");
+        if (file == nullptr)
+        {
+            fprintf(stderr, "can't open %s: %s\n", out.c_str(), strerror(errno));
+            return 1;
+        }
+        suite.PrintJson(file);
+        fclose(file);
+    }
+
+    return ok ? 0 : 1;
+}
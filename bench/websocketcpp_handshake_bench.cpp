@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Data.h"
+#include "DebugPrint.h"
+#include "FileSystem.h"
+#include "HandshakeResponse.h"
+#include "Response.h"
+#include "Sha1.h"
+#include "bench_common.h"
+#include "common_ws.h"
+
+using namespace WebSocketCpp;
+
+using Bench::NullServer;
+
+static const std::string key = "dGhlIHNhbXBsZSBub25jZQ==";
+
+// the upgrade path as it was before the prebuilt template
+static void BuildResponse(NullServer& server, const Config& config)
+{
+    Response    response(0, config);
+    std::string accept = key + WEBSOCKET_KEY_TOKEN;
+    auto        buffer = Data::Sha1Digest(accept);
+    accept             = Data::Base64Encode(buffer.data(), Data::SHA1_DIGEST_LENGTH);
+
+    response.SetResponseCode(101);
+    response.AddHeader(Header::HeaderType::Date, FileSystem::GetDateTime());
+    response.AddHeader(Header::HeaderType::Upgrade, "websocket");
+    response.AddHeader(Header::HeaderType::Connection, "Upgrade");
+    response.AddHeader("Sec-WebSocket-Accept", accept);
+    response.AddHeader("Sec-WebSocket-Version", WS_VERSION);
+    response.Send(&server);
+}
+
+static void BuildTemplate(NullServer& server, HandshakeResponse& handshake)
+{
+    handshake.Build(key);
+    server.Write(0, handshake.GetData());
+}
+
+template <typename F>
+static void Run(const char* name, size_t iterations, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        func();
+    }
+    auto   elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate    = iterations / elapsed;
+    printf("%-20s %10zu iterations %12.0f handshakes/sec %8.1f ns/op\n", name, iterations, rate, elapsed * 1e9 / iterations);
+}
+
+int main(int argc, char** argv)
+{
+    DebugPrint::AllowPrint = false;
+
+    size_t iterations = 1000000;
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], nullptr, 10);
+    }
+
+    Config&    config = Config::Instance();
+    NullServer server;
+
+    HandshakeResponse handshake;
+    handshake.Init(config.GetServerName());
+
+    Run("response", iterations, [&]() { BuildResponse(server, config); });
+    Run("template", iterations, [&]() { BuildTemplate(server, handshake); });
+
+    if (SHA1::hardware_accelerated())
+    {
+        SHA1::enable_hardware(false);
+        Run("template/portable", iterations, [&]() { BuildTemplate(server, handshake); });
+        SHA1::enable_hardware(true);
+    }
+
+    return 0;
+}
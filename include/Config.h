@@ -72,6 +72,10 @@ private:
     PROPERTY(std::string, IndexFile, "index.html")
     PROPERTY(std::string, SslSertificate, "cert.pem")
     PROPERTY(std::string, SslKey, "key.pem")
+    PROPERTY(bool, SslKtls, false) // kernel TLS for WSS connections, OpenSSL keeps encrypting where it's unavailable
+    PROPERTY(size_t, SslSessionCacheSize, 20480) // server side sessions for the clients without tickets, 0 - no cache
+    PROPERTY(uint64_t, SslTicketKeyLifetimeSec, 3600) // the ticket key is replaced this often, 0 - no tickets
+    PROPERTY(size_t, SslHandshakeThreads, 2) // the server runs the TLS handshakes on these, not on the epoll thread
     PROPERTY(bool, WsProcessDefault, true)
     PROPERTY(int, WsServerPort, 8081)
     PROPERTY(Protocol, WsProtocol, Protocol::WS)
@@ -81,7 +85,23 @@ private:
     PROPERTY(size_t, MaxFrameSize, 1_Mb)
     PROPERTY(size_t, MaxConnectionMemory, 20_Mb)
     PROPERTY(size_t, MaxClientCount, 2)
+    PROPERTY(uint64_t, WsHandshakeTimeoutMs, 0) // accepted connection must finish the upgrade in this time, 0 - no limit
+    PROPERTY(uint64_t, WsPingIntervalMs, 0)     // a connection silent this long is pinged, 0 - no pings
+    PROPERTY(uint64_t, WsPongTimeoutMs, 0)      // closed when nothing comes back this long after the ping, 0 - never
+    PROPERTY(uint64_t, WsIdleTimeoutMs, 0)      // closed when nothing is received this long, pongs included, 0 - never
     PROPERTY(uint64_t, ClientConnectTimeoutMs, 1000)
+    PROPERTY(size_t, ClientReactorThreads, 1)   // threads of ClientReactor::Default() driving all the clients
+    PROPERTY(bool, ClientReconnect, false)      // WebSocketClient reopens a dropped connection
+    PROPERTY(uint64_t, ClientReconnectMinMs, 100) // first backoff delay, doubled on every failed attempt
+    PROPERTY(uint64_t, ClientReconnectMaxMs, 30000) // backoff limit
+    PROPERTY(size_t, ClientSendQueueSize, 1024) // messages kept while reconnecting, 0 - refuse
+    PROPERTY(std::string, LogFolder, "/var/log/webcpp")
+    PROPERTY(size_t, LogMaxFileSize, 10_Mb)      // 0 - never rotate by size
+    PROPERTY(uint64_t, LogRotateIntervalSec, 0) // 0 - never rotate by time
+    PROPERTY(size_t, LogMaxFiles, 5)            // rotated files to keep
+    PROPERTY(bool, LogBinaryAccess, false)      // access log as AccessLog records
+    PROPERTY(std::string, MetricsRoute, "")     // HTTP path serving Metrics in Prometheus format, empty - off
+    PROPERTY(uint32_t, TraceSampleRate, 64)     // WITH_TRACING: trace every N-th read, 0 - off
 };
 
 } // namespace WebSocketCpp
@@ -0,0 +1,56 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_HANDSHAKERESPONSE_H
+#define WEB_SOCKET_CPP_HANDSHAKERESPONSE_H
+
+#include <string>
+
+#include "common.h"
+
+namespace WebSocketCpp
+{
+
+/* Prebuilt "101 Switching Protocols" response. The static part is rendered once,
+ * only the Date and Sec-WebSocket-Accept values are patched per handshake. */
+class HandshakeResponse
+{
+public:
+    HandshakeResponse() = default;
+
+    void       Init(const std::string& serverName);
+    bool       Build(const char* key, size_t length);
+    bool       Build(const std::string& key);
+    ByteArray& GetData();
+
+    static bool ComputeAcceptKey(const char* key, size_t length, char* out);
+
+    static constexpr size_t ACCEPT_KEY_LENGTH = 28;
+    static constexpr size_t MAX_KEY_LENGTH    = 64;
+
+private:
+    ByteArray m_data;
+    size_t    m_datePos{0};
+    size_t    m_acceptPos{0};
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_HANDSHAKERESPONSE_H
@@ -21,6 +21,7 @@
 #ifndef HEADER_H
 #define HEADER_H
 
+#include <cstddef>
 #include <string>
 
 namespace WebSocketCpp
@@ -113,16 +114,25 @@ public:
         Vary,
         WWWAuthenticate,
         XFrameOptions,
+
+        SecWebSocketKey,
+        SecWebSocketAccept,
+        SecWebSocketVersion,
+        SecWebSocketProtocol,
+        SecWebSocketExtensions,
     };
 
+    static constexpr size_t HEADER_TYPE_COUNT = static_cast<size_t>(HeaderType::SecWebSocketExtensions) + 1;
+
     Header();
     ~Header();
     Header(Header::HeaderType type, const std::string& name, const std::string& value);
 
     Header::HeaderType getType() const;
-    std::string        getName() const;
-    std::string        getValue() const;
+    const std::string& getName() const;
+    const std::string& getValue() const;
 
+    static Header::HeaderType Intern(const char* name, size_t length);
     static Header::HeaderType String2HeaderType(const std::string& str);
     static std::string        HeaderType2String(Header::HeaderType headerType);
 
@@ -21,6 +21,7 @@
 #ifndef WEB_SOCKET_CPP_HTTPHEADER_H
 #define WEB_SOCKET_CPP_HTTPHEADER_H
 
+#include <array>
 #include <string>
 #include <vector>
 
@@ -58,14 +59,17 @@ public:
     std::string GetRemoteAddress() const;
     int         GetRemotePort() const;
 
-    size_t                     GetCount() const;
-    std::string                GetHeader(Header::HeaderType headerType) const;
-    std::string                GetHeader(const std::string& headerType) const;
-    std::vector<std::string>   GetAllHeaders(const std::string& headerType) const;
-    const std::vector<Header>& GetHeaders() const;
-    void                       SetHeader(Header::HeaderType type, const std::string& value);
-    void                       SetHeader(const std::string& name, const std::string& value);
-    void                       Clear();
+    size_t                   GetCount() const;
+    std::string              GetHeader(Header::HeaderType headerType) const;
+    std::string              GetHeader(const std::string& headerType) const;
+    const char*              FindHeader(Header::HeaderType headerType, size_t& size) const;
+    bool                     HasHeader(Header::HeaderType headerType) const;
+    bool                     CompareHeader(Header::HeaderType headerType, const std::string& value) const;
+    std::vector<std::string> GetAllHeaders(const std::string& headerType) const;
+    std::vector<Header>      GetHeaders() const;
+    void                     SetHeader(Header::HeaderType type, const std::string& value);
+    void                     SetHeader(const std::string& name, const std::string& value);
+    void                     Clear();
 
     std::string ToString() const;
 
@@ -73,14 +77,33 @@ protected:
     bool ParseHeaders(const ByteArray& data, const StringUtil::Ranges& ranges);
 
 private:
-    Header::HeaderRole  m_role{Header::HeaderRole::Undefined};
-    bool                m_complete{false};
-    std::vector<Header> m_headers{};
-    std::string         m_version{"HTTP/1.1"};
-    size_t              m_headerSize{};
-    std::string         m_remoteAddress;
-    int                 m_remotePort{-1};
-    size_t              m_chunkedSize{0};
+    struct Field
+    {
+        Header::HeaderType type;
+        size_t             nameStart;
+        size_t             nameLength;
+        size_t             valueStart;
+        size_t             valueLength;
+    };
+
+    int  FindField(Header::HeaderType type, const char* name, size_t length) const;
+    void AddField(Header::HeaderType type, const char* name, size_t nameLength, const char* value, size_t valueLength);
+    void SetField(Header::HeaderType type, const char* name, size_t nameLength, const char* value, size_t valueLength);
+
+    Header::HeaderRole                         m_role{Header::HeaderRole::Undefined};
+    bool                                       m_complete{false};
+    std::string                                m_raw; // names and values of all the fields back to back
+    std::vector<Field>                         m_fields;
+    std::array<int, Header::HEADER_TYPE_COUNT> m_index; // the last field of every known type or -1
+    std::string                                m_version{"HTTP/1.1"};
+    size_t                                     m_headerSize{};
+    std::string                                m_remoteAddress;
+    int                                        m_remotePort{-1};
+    size_t                                     m_chunkedSize{0};
+    StringUtil::LineTokenizer                  m_tokenizer;
+    StringUtil::Ranges                         m_lines;
+    size_t                                     m_parseStart{SIZE_MAX};
+    size_t                                     m_lineCount{0};
 };
 
 } // namespace WebSocketCpp
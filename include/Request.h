@@ -33,9 +33,18 @@ namespace WebSocketCpp
 {
 
 class Session;
+struct RouteArgs;
 class Request : public IErrorable
 {
 public:
+    enum class ParseState
+    {
+        RequestLine = 0,
+        Header,
+        Complete,
+        Error,
+    };
+
     Request();
     Request(const Request& other)            = delete;
     Request& operator=(const Request& other) = delete;
@@ -43,6 +52,7 @@ public:
     Request& operator=(Request&& other)      = delete;
 
     bool              Parse(const ByteArray& data);
+    ParseState        GetParseState() const;
     int               GetConnectionID() const;
     void              SetConnectionID(int connID);
     const Url&        GetUrl() const;
@@ -54,6 +64,7 @@ public:
     std::string       GetHttpVersion() const;
     std::string       GetArg(const std::string& name) const;
     void              SetArg(const std::string& name, const std::string& value);
+    void              SetRouteArgs(const std::string* path, const RouteArgs* args);
     bool              IsKeepAlive() const;
     Protocol          GetProtocol() const;
     size_t            GetRequestLineLength() const;
@@ -67,7 +78,7 @@ public:
     std::string       ToString() const;
 
 protected:
-    bool      ParseRequestLine(const ByteArray& data, size_t& pos);
+    bool      ParseRequestLine(const ByteArray& data, size_t pos);
     ByteArray BuildRequestLine() const;
     ByteArray BuildHeaders() const;
 
@@ -78,7 +89,11 @@ private:
     Method                             m_method      = Method::Undefined;
     std::string                        m_httpVersion = "HTTP/1.1";
     size_t                             m_requestLineLength{};
+    ParseState                         m_parseState = ParseState::RequestLine;
+    size_t                             m_scanPos{};
     std::map<std::string, std::string> m_args;
+    const std::string*                 m_routePath = nullptr; // the arguments of the route being dispatched
+    const RouteArgs*                   m_routeArgs = nullptr;
     std::string                        m_remote;
     Session*                           m_session = nullptr;
 };
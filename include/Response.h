@@ -44,6 +44,15 @@ public:
 
     };
 
+    enum class ParseState
+    {
+        StatusLine = 0,
+        Header,
+        Body,
+        Complete,
+        Error,
+    };
+
     Response(int connID, const Config& config);
     Response(const Response& other)            = delete;
     Response& operator=(const Response& other) = delete;
@@ -72,6 +81,7 @@ public:
     void SetShouldSend(bool value);
     bool Send(CommunicationServerBase* communication);
     bool Parse(const ByteArray& data, size_t* all = nullptr, size_t* downoaded = nullptr);
+    ParseState GetParseState() const;
 
     void     SetSession(Session* session);
     Session* GetSession() const;
@@ -95,7 +105,7 @@ protected:
     void                InitDefault();
     ByteArray           BuildStatusLine() const;
     ByteArray           BuildHeaders() const;
-    bool                ParseStatusLine(const ByteArray& data, size_t& pos);
+    bool                ParseStatusLine(const ByteArray& data, size_t pos);
     bool                DecodeBody(EncodingType type, const ByteArray& data, size_t pos);
     static EncodingType String2EncodingType(const std::string& str);
 
@@ -112,6 +122,9 @@ private:
     bool          m_shouldSend = true;
     Session*      m_session    = nullptr;
     size_t        m_response_size{};
+    ParseState    m_parseState = ParseState::StatusLine;
+    size_t        m_statusLineLength{};
+    size_t        m_scanPos{};
 };
 
 } // namespace WebSocketCpp
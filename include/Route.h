@@ -32,6 +32,22 @@
 namespace WebSocketCpp
 {
 
+// Variables captured by Route::Match, kept as positions in the matched path
+struct RouteArgs
+{
+    static constexpr size_t MAX_COUNT = 8; // a path that fills more variables does not match
+
+    struct Arg
+    {
+        const std::string* name;
+        size_t             start;
+        size_t             length;
+    };
+
+    Arg    args[MAX_COUNT];
+    size_t count{0};
+};
+
 class Route
 {
 public:
@@ -42,8 +58,12 @@ public:
     Route& operator=(Route&& other)      = default;
 
     const std::string& GetPath() const;
+    Method             GetMethod() const;
     bool               IsMatch(Request& request);
+    bool               Match(const std::string& path, Method method, RouteArgs& args) const;
     bool               IsUseAuth() const;
+    bool               IsLiteral() const;
+    std::string        GetLiteralPrefix() const;
 
     std::string ToString() const;
 
@@ -103,7 +123,7 @@ protected:
             });
         }
 
-        bool IsMatch(const char* ch, size_t length, size_t& pos);
+        bool IsMatch(const char* ch, size_t length, size_t& pos) const;
         bool IsAny(char ch) const;
         bool IsString(char ch) const;
         bool IsAlpha(char ch) const;
@@ -115,7 +135,8 @@ protected:
         bool        Compare(const char* ch1, const char* ch2, size_t size);
     };
 
-    bool AddToken(Token& token, const std::string& str);
+    bool        AddToken(Token& token, const std::string& str);
+    static bool Capture(const Token& token, size_t start, size_t length, RouteArgs& args);
 
 private:
     enum class State
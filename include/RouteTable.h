@@ -0,0 +1,90 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_ROUTETABLE_H
+#define WEB_SOCKET_CPP_ROUTETABLE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Request.h"
+#include "RouteWebSocket.h"
+
+namespace WebSocketCpp
+{
+
+/*
+ * Routes compiled into a trie on their literal prefixes. A lookup walks the
+ * request path once and checks only the routes which prefix matches the path,
+ * a route without variables is matched by the walk itself. The result is bound
+ * to a connection once, so dispatching a message doesn't touch the path.
+ * The routes are immutable and shared, so a copy of the table is cheap and a new
+ * version can be built aside while the current one is still in use.
+ */
+class RouteTable
+{
+public:
+    using RoutePtr = std::shared_ptr<const RouteWebSocket>;
+
+    struct Binding
+    {
+        size_t    route; // index of the route in the table
+        RouteArgs args;
+    };
+
+    struct Matches
+    {
+        std::string          path; // the arguments of the bindings point into it
+        std::vector<Binding> bindings;
+    };
+
+    RouteTable();
+    RouteTable(const RouteTable& other)            = default;
+    RouteTable& operator=(const RouteTable& other) = default;
+    RouteTable(RouteTable&& other)                 = default;
+    RouteTable& operator=(RouteTable&& other)      = default;
+
+    void                  Add(RoutePtr route);
+    bool                  Replace(RoutePtr route);
+    RoutePtr              Find(const std::string& path) const;
+    const RouteWebSocket& Get(size_t index) const;
+    size_t                GetCount() const;
+    bool                  Match(const Request& request, Matches& matches) const;
+    void                  Clear();
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<char, size_t>> children; // sorted by the char
+        std::vector<size_t>                  routes;
+    };
+
+    size_t FindChild(size_t node, char ch) const;
+    size_t AddChild(size_t node, char ch);
+
+    std::vector<RoutePtr> m_routes;
+    std::vector<Node>     m_nodes;
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_ROUTETABLE_H
@@ -23,21 +23,31 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 
+#include "ClientReactor.h"
 #include "CommunicationClientBase.h"
 #include "Config.h"
 #include "IErrorable.h"
 #include "IRunnable.h"
+#include "Resolver.h"
 #include "Request.h"
+#include "Response.h"
 #include "ResponseWebSocket.h"
 
 namespace WebSocketCpp
 {
 
+/*
+ * With Config::ClientReconnect a connection opened by address and dropped by the
+ * peer is opened again after a jittered exponential backoff. The messages sent
+ * meanwhile are kept in a bounded queue and go out right after the new handshake,
+ * before the OnConnect callback is called.
+ */
 class WebSocketClient : public IErrorable, public IRunnable
 {
 public:
@@ -62,11 +72,14 @@ public:
     bool WaitFor() override;
     bool Open(Request& request);
     bool Open(const std::string& address);
+    bool OpenAsync(const std::string& address); // returns immediately, the result is reported by the OnConnect callback
     bool SendText(const ByteArray& data);
     bool SendText(const std::string& data);
     bool SendBinary(const ByteArray& data);
     bool SendBinary(const std::string& data);
     bool SendPing();
+    void SetReactor(std::shared_ptr<ClientReactor> reactor); // before Open(), ClientReactor::Default() if not set
+    void SetResolver(std::shared_ptr<IResolver> resolver);   // before OpenAsync(), ThreadPoolResolver::Default() if not set
 
     using OnConnectCallback      = std::function<void(bool)>;
     using OnCloseCallback        = std::function<void()>;
@@ -86,10 +99,41 @@ protected:
     void OnDataReady(ByteArray&& data);
     void OnClosed();
     bool InitConnection(const Url& url);
+    bool SendHandshake(Request& request);
+    bool StartOpen(const std::string& address);
+    void OnAsyncConnected(bool connected);
+    void FinishHandshake(bool ok);
+    bool Send(MessageType type, const ByteArray& data);
+    bool SendFrame(MessageType type, const ByteArray& data);
+    bool EnableReconnect(const std::string& address);
+    bool ScheduleReconnect();
+    void Reconnect();
+    uint64_t ReconnectDelay(uint32_t attempt) const;
     void SetState(State state);
 
 private:
-    std::shared_ptr<CommunicationClientBase> m_connection = nullptr;
+    class ReconnectTimer : public ClientReactor::Handler
+    {
+    public:
+        explicit ReconnectTimer(WebSocketClient& client)
+            : m_client(client)
+        {
+        }
+        void OnEvent(uint32_t) override
+        {
+        }
+        void OnTimer() override
+        {
+            m_client.Reconnect();
+        }
+
+    private:
+        WebSocketClient& m_client;
+    };
+
+    std::shared_ptr<CommunicationClientBase> m_connection = nullptr; // replaced by Reconnect(), read with std::atomic_load
+    std::shared_ptr<ClientReactor>           m_reactor    = nullptr;
+    std::shared_ptr<IResolver>               m_resolver   = nullptr;
     Config&                                  m_config;
     OnConnectCallback                        m_connectCallback  = nullptr;
     OnCloseCallback                          m_closeCallback    = nullptr;
@@ -104,6 +148,16 @@ private:
     std::condition_variable                  m_handshake_cv;
     bool                                     m_handshake_done{false};
     std::mutex                               m_read_mtx;
+    std::unique_ptr<Response>                m_handshakeResponse;
+    std::unique_ptr<Request>                 m_openRequest;
+    std::string                              m_address;
+    ReconnectTimer                           m_reconnectTimer{*this};
+    std::atomic<bool>                        m_closing{false};
+    std::atomic<bool>                        m_reconnecting{false};
+    std::atomic<uint32_t>                    m_reconnectAttempt{0};
+    std::atomic<uint64_t>                    m_disconnectedAt{0};
+    std::mutex                               m_sendMutex; // m_connection replacement and m_sendQueue
+    std::deque<std::pair<MessageType, ByteArray>> m_sendQueue;
 };
 
 } // namespace WebSocketCpp
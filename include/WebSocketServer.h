@@ -29,13 +29,16 @@
 
 #include "CommunicationServerBase.h"
 #include "Config.h"
+#include "HandshakeResponse.h"
 #include "IErrorable.h"
 #include "IRunnable.h"
 #include "Request.h"
 #include "RequestWebSocket.h"
 #include "ResponseWebSocket.h"
+#include "RouteTable.h"
 #include "RouteWebSocket.h"
 #include "ThreadWorker.h"
+#include "Trace.h"
 
 namespace WebSocketCpp
 {
@@ -81,12 +84,17 @@ protected:
             request.GetHeader().SetRemote(remote);
         }
 
-        int                           connID{-1};
-        Request                       request;
-        ByteArray                     data{};
-        std::vector<RequestWebSocket> requestList;
-        bool                          handshake{false};
-        bool                          readyForDispatch{false};
+        int                               connID{-1};
+        Request                           request;
+        ByteArray                         data{};
+        std::vector<RequestWebSocket>     requestList;
+        bool                              handshake{false};
+        bool                              readyForDispatch{false};
+        bool                              rejected{false};  // a 400 is sent, the connection is on its way out
+        std::shared_ptr<const RouteTable> routeTable;       // the snapshot `routes` were matched against
+        RouteTable::Matches               routes;           // bound once on the handshake
+        size_t                            routesVersion{0}; // the registry version of `routeTable`
+        Trace::Context                    trace;            // the sampled message in flight, WITH_TRACING only
 
         RequestData(const RequestData&)            = delete;
         RequestData& operator=(const RequestData&) = delete;
@@ -105,19 +113,21 @@ protected:
     void SendSignal();
     void WaitForSignal();
     void InitConnection(int connID, const std::string& remote);
-    void PutToQueue(int connID, ByteArray&& data);
-
-    bool            IsQueueEmpty();
-    bool            CheckData();
-    void            ProcessRequests();
-    bool            HasData();
-    void            RemoveFromQueue(int connID);
-    bool            ProcessRequest(Request& request);
-    bool            CheckWsHeader(RequestData& requestData);
-    bool            CheckWsFrame(RequestData& requestData);
-    bool            ProcessWsRequest(Request& request, const RequestWebSocket& wsRequest);
-    RouteWebSocket* GetRoute(const std::string& path);
-    RequestData*    getRequest(int connID);
+    void PutToQueue(int connID, ByteArray&& data, const Trace::Context& trace);
+
+    bool                 IsQueueEmpty();
+    bool                 CheckData();
+    void                 ProcessRequests();
+    bool                 HasData();
+    void                 RemoveFromQueue(int connID);
+    bool                 ProcessRequest(RequestData& requestData);
+    bool                 CheckWsHeader(RequestData& requestData);
+    bool                 CheckWsFrame(RequestData& requestData);
+    bool                 ProcessWsRequest(RequestData& requestData, const RequestWebSocket& wsRequest);
+    bool                 IsMetricsRequest(const Request& request) const;
+    bool                 ServeMetrics(RequestData& requestData);
+    RouteTable::RoutePtr GetRoute(const std::string& path);
+    RequestData*         getRequest(int connID);
 
 private:
     std::unique_ptr<CommunicationServerBase> m_server   = nullptr;
@@ -130,8 +140,10 @@ private:
     bool                                     m_pending_signal{false};
     std::list<RequestData>                   m_requestQueue;
     const Config&                            m_config;
-    std::vector<RouteWebSocket>              m_routes;
-    std::mutex                               m_routeMutex;
+    HandshakeResponse                        m_handshake;
+    std::shared_ptr<const RouteTable>        m_routes;           // replaced as a whole, read with std::atomic_load
+    std::atomic<size_t>                      m_routesVersion{0}; // bumped after every replacement of m_routes
+    std::mutex                               m_routeMutex;       // serializes the writers only
     OnConnectCallback                        m_connect_callback;
     OnDisconnectCallback                     m_disconnect_callback;
 };
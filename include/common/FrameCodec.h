@@ -0,0 +1,228 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_FRAME_CODEC_H
+#define WEB_SOCKET_CPP_FRAME_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "StringUtil.h"
+#include "common.h"
+#include "common_ws.h"
+
+namespace WebSocketCpp
+{
+
+enum class Role
+{
+    Client,
+    Server,
+};
+
+struct FrameHeader
+{
+    bool     fin         = false;
+    uint8_t  rsv         = 0; // RSV1..RSV3 as bits 2..0
+    uint8_t  opcode      = 0;
+    bool     masked      = false;
+    uint32_t maskKey     = 0; // in memory order, as StringUtil::MaskCopy() takes it
+    uint64_t payloadSize = 0;
+    size_t   headerSize  = 0;
+};
+
+/*
+ * RFC 6455 frame encoding and decoding for one side of the connection: a client
+ * masks what it sends, a server doesn't. The role is a template parameter, so the
+ * masking branches are folded away at compile time. Headers are built in a fixed
+ * MAX_HEADER_SIZE buffer, lengths are always in network byte order.
+ * Parsing takes a pointer and a size and never reads past them, it accepts both
+ * masked and unmasked frames whatever the role.
+ */
+template <Role ROLE>
+class FrameCodec
+{
+public:
+    enum class Result
+    {
+        Ok,
+        Incomplete,
+        Error,
+    };
+
+    static constexpr bool   MASKED          = (ROLE == Role::Client);
+    static constexpr size_t MAX_HEADER_SIZE = 2 + 8 + 4;
+
+    static size_t HeaderSize(uint64_t payloadSize)
+    {
+        return 2 + (payloadSize < 126 ? 0 : (payloadSize <= 0xFFFF ? 2 : 8)) + (MASKED ? 4 : 0);
+    }
+
+    // returns the header size
+    static size_t WriteHeader(uint8_t* out, MessageType type, uint64_t payloadSize, uint32_t maskKey, bool fin = true)
+    {
+        size_t pos = 0;
+        out[pos++] = static_cast<uint8_t>((fin ? 0x80 : 0x00) | (static_cast<uint8_t>(type) & 0x0F));
+
+        uint8_t maskBit = MASKED ? 0x80 : 0x00;
+        if (payloadSize < 126)
+        {
+            out[pos++] = static_cast<uint8_t>(maskBit | payloadSize);
+        }
+        else if (payloadSize <= 0xFFFF)
+        {
+            out[pos++] = static_cast<uint8_t>(maskBit | 126);
+            out[pos++] = static_cast<uint8_t>(payloadSize >> 8);
+            out[pos++] = static_cast<uint8_t>(payloadSize);
+        }
+        else
+        {
+            out[pos++] = static_cast<uint8_t>(maskBit | 127);
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                out[pos++] = static_cast<uint8_t>(payloadSize >> shift);
+            }
+        }
+
+        if (MASKED)
+        {
+            std::memcpy(out + pos, &maskKey, sizeof(maskKey));
+            pos += sizeof(maskKey);
+        }
+
+        return pos;
+    }
+
+    // the whole frame, the client one masked with a fresh key
+    static void Encode(ByteArray& out, MessageType type, const uint8_t* payload, size_t size, bool fin = true)
+    {
+        uint8_t  header[MAX_HEADER_SIZE];
+        uint32_t maskKey    = MASKED ? StringUtil::MaskKey() : 0;
+        size_t   headerSize = WriteHeader(header, type, size, maskKey, fin);
+
+        out.resize(headerSize + size);
+        std::memcpy(out.data(), header, headerSize);
+        if (size == 0)
+        {
+            return;
+        }
+
+        if (MASKED)
+        {
+            StringUtil::MaskCopy(out.data() + headerSize, payload, size, maskKey);
+        }
+        else
+        {
+            std::memcpy(out.data() + headerSize, payload, size);
+        }
+    }
+
+    static Result ParseHeader(const uint8_t* data, size_t size, FrameHeader& header)
+    {
+        if (size < 2)
+        {
+            return Result::Incomplete;
+        }
+
+        header.fin    = (data[0] & 0x80) != 0;
+        header.rsv    = static_cast<uint8_t>((data[0] >> 4) & 0x07);
+        header.opcode = static_cast<uint8_t>(data[0] & 0x0F);
+        header.masked = (data[1] & 0x80) != 0;
+
+        size_t  pos    = 2;
+        uint8_t length = data[1] & 0x7F;
+        if (length < 126)
+        {
+            header.payloadSize = length;
+        }
+        else
+        {
+            size_t lengthSize = (length == 126) ? 2 : 8;
+            if (size < pos + lengthSize)
+            {
+                return Result::Incomplete;
+            }
+
+            header.payloadSize = 0;
+            for (size_t i = 0; i < lengthSize; i++)
+            {
+                header.payloadSize = (header.payloadSize << 8) | data[pos + i];
+            }
+            pos += lengthSize;
+
+            // the most significant bit of the 64-bit length must be 0
+            if (header.payloadSize >> 63)
+            {
+                return Result::Error;
+            }
+        }
+
+        header.maskKey = 0;
+        if (header.masked)
+        {
+            if (size < pos + sizeof(header.maskKey))
+            {
+                return Result::Incomplete;
+            }
+            std::memcpy(&header.maskKey, data + pos, sizeof(header.maskKey));
+            pos += sizeof(header.maskKey);
+        }
+
+        header.headerSize = pos;
+        return Result::Ok;
+    }
+
+    // the frame is complete if it holds FrameSize() bytes
+    static uint64_t FrameSize(const FrameHeader& header)
+    {
+        return header.headerSize + header.payloadSize;
+    }
+
+    // copies the payload of a complete frame to out, unmasked
+    static void DecodePayload(const FrameHeader& header, const uint8_t* frame, uint8_t* out)
+    {
+        size_t size = static_cast<size_t>(header.payloadSize);
+        if (size == 0)
+        {
+            return;
+        }
+
+        if (header.masked)
+        {
+            StringUtil::MaskCopy(out, frame + header.headerSize, size, header.maskKey);
+        }
+        else
+        {
+            std::memcpy(out, frame + header.headerSize, size);
+        }
+    }
+};
+
+template <Role ROLE>
+constexpr bool FrameCodec<ROLE>::MASKED;
+template <Role ROLE>
+constexpr size_t FrameCodec<ROLE>::MAX_HEADER_SIZE;
+
+using ClientFrameCodec = FrameCodec<Role::Client>;
+using ServerFrameCodec = FrameCodec<Role::Server>;
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_FRAME_CODEC_H
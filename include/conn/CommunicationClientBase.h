@@ -20,6 +20,7 @@
 #ifndef WEB_SOCKET_CPP_COMMUNICATION_CLIENT_BASE_H
 #define WEB_SOCKET_CPP_COMMUNICATION_CLIENT_BASE_H
 
+#include <cstdint>
 #include <functional>
 
 #include "ICommunication.h"
@@ -35,9 +36,33 @@ public:
 
     using DataReadyCallback       = std::function<void(ByteArray&&)>;
     using CloseConnectionCallback = std::function<void()>;
+    using ConnectCallback         = std::function<void(bool)>;
+    using TimeoutCallback         = std::function<void()>;
 
     virtual bool Write(const ByteArray& data) = 0;
 
+    // the callback reports the result of connecting, the data callbacks are active once it succeeded
+    virtual bool ConnectAsync(const std::string& host, int port, ConnectCallback callback)
+    {
+        if (!Connect(host, port) || !Run())
+        {
+            return false;
+        }
+        if (callback)
+        {
+            callback(true);
+        }
+        return true;
+    }
+
+    // one-shot timer on the connection's event loop, 0 cancels
+    virtual bool SetTimeout(uint64_t timeoutMs, TimeoutCallback callback)
+    {
+        (void)timeoutMs;
+        (void)callback;
+        return false;
+    }
+
     virtual bool SetDataReadyCallback(DataReadyCallback callback)       = 0;
     virtual bool SetCloseConnectionCallback(CloseConnectionCallback callback) = 0;
 
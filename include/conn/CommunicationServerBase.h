@@ -45,6 +45,15 @@ public:
     virtual bool SetDataReadyCallback(DataReadyCallback callback)           = 0;
     virtual bool SetCloseConnectionCallback(CloseConnectionCallback callback) = 0;
 
+    // the connection timers, before Init(), in ms, 0 - off
+    virtual void SetTimeouts(uint64_t /*handshakeMs*/, uint64_t /*pingMs*/, uint64_t /*pongMs*/, uint64_t /*idleMs*/)
+    {
+    }
+    // the connection speaks WebSocket now, the handshake deadline gives way to the pings
+    virtual void SetUpgraded(int /*connID*/)
+    {
+    }
+
     bool IsConnected() const override
     {
         return m_connected;
@@ -14,7 +14,7 @@ namespace WebSocketCpp
 class CommunicationSslClient : public CommunicationClientBase
 {
 public:
-    CommunicationSslClient(const std::string& cert, const std::string& key) noexcept;
+    CommunicationSslClient(const std::string& cert, const std::string& key, std::shared_ptr<ClientReactor> reactor = nullptr, std::shared_ptr<IResolver> resolver = nullptr) noexcept;
     ~CommunicationSslClient() override;
 
     CommunicationSslClient(const CommunicationSslClient&)            = delete;
@@ -31,12 +31,17 @@ public:
     bool Close(bool wait = true) override;
     bool WaitFor() override;
 
+    bool ConnectAsync(const std::string& host, int port, ConnectCallback callback) override;
+    bool SetTimeout(uint64_t timeoutMs, TimeoutCallback callback) override;
+
     bool Write(const ByteArray& data) override;
 
     bool SetDataReadyCallback(DataReadyCallback callback) override;
     bool SetCloseConnectionCallback(CloseConnectionCallback callback) override;
 
 private:
+    void BindSocket();
+
     ClientSocket            m_client;
     std::string             m_host{};
     int                     m_port{443};
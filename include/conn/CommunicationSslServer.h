@@ -14,7 +14,7 @@ namespace WebSocketCpp
 class CommunicationSslServer : public CommunicationServerBase
 {
 public:
-    CommunicationSslServer(const std::string& cert, const std::string& key) noexcept;
+    CommunicationSslServer(const std::string& cert, const std::string& key, bool ktls = false) noexcept;
     ~CommunicationSslServer() override;
 
     CommunicationSslServer(const CommunicationSslServer&)            = delete;
@@ -34,6 +34,8 @@ public:
     bool Write(int connID, ByteArray& data) override;
     bool Write(int connID, ByteArray& data, size_t size) override;
     bool CloseConnection(int connID) override;
+    void SetTimeouts(uint64_t handshakeMs, uint64_t pingMs, uint64_t pongMs, uint64_t idleMs) override;
+    void SetUpgraded(int connID) override;
 
     bool SetNewConnectionCallback(NewConnectionCallback callback) override;
     bool SetDataReadyCallback(DataReadyCallback callback) override;
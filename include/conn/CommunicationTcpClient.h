@@ -29,7 +29,7 @@ namespace WebSocketCpp
 class CommunicationTcpClient : public CommunicationClientBase
 {
 public:
-    CommunicationTcpClient();
+    explicit CommunicationTcpClient(std::shared_ptr<ClientReactor> reactor = nullptr, std::shared_ptr<IResolver> resolver = nullptr);
     ~CommunicationTcpClient() override;
 
     CommunicationTcpClient(const CommunicationTcpClient&)            = delete;
@@ -46,12 +46,17 @@ public:
     bool Close(bool wait = true) override;
     bool WaitFor() override;
 
+    bool ConnectAsync(const std::string& host, int port, ConnectCallback callback) override;
+    bool SetTimeout(uint64_t timeoutMs, TimeoutCallback callback) override;
+
     bool Write(const ByteArray& data) override;
 
     bool SetDataReadyCallback(DataReadyCallback callback) override;
     bool SetCloseConnectionCallback(CloseConnectionCallback callback) override;
 
 private:
+    void BindSocket();
+
     ClientSocket            m_client;
     std::string             m_host{};
     int                     m_port{80};
@@ -49,6 +49,8 @@ public:
     bool Write(int connID, ByteArray& data) override;
     bool Write(int connID, ByteArray& data, size_t size) override;
     bool CloseConnection(int connID) override;
+    void SetTimeouts(uint64_t handshakeMs, uint64_t pingMs, uint64_t pongMs, uint64_t idleMs) override;
+    void SetUpgraded(int connID) override;
 
     bool SetNewConnectionCallback(NewConnectionCallback callback) override;
     bool SetDataReadyCallback(DataReadyCallback callback) override;
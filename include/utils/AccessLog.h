@@ -0,0 +1,99 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_ACCESS_LOG_H
+#define WEB_SOCKET_CPP_ACCESS_LOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "IErrorable.h"
+
+namespace WebSocketCpp
+{
+
+/*
+ * Append-only binary access log. The file is a 32 bytes header followed by
+ * fixed size records and is written through a shared memory mapping, so a record
+ * costs one memcpy and survives a crash of the process. The header keeps the
+ * number of valid records, Load() reads them back.
+ */
+class AccessLog : public IErrorable
+{
+public:
+    enum class Event : uint8_t
+    {
+        Connect    = 1,
+        Disconnect = 2,
+    };
+
+    struct Record
+    {
+        uint64_t timeUs;      // microseconds since the epoch
+        uint32_t connID;
+        uint8_t  event;       // Event
+        uint8_t  family;      // AF_INET, AF_INET6 or 0 if the address is unknown
+        uint16_t port;
+        uint8_t  address[16]; // network byte order
+    };
+
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t reserved;
+    };
+
+    static constexpr uint32_t VERSION      = 1;
+    static constexpr size_t   DEFAULT_SIZE = 16 * 1024 * 1024;
+
+    AccessLog() = default;
+    ~AccessLog();
+    AccessLog(const AccessLog&)            = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    bool   Open(const std::string& file, size_t capacity = DEFAULT_SIZE);
+    void   Close();
+    bool   IsOpen() const;
+    bool   IsFull() const;
+    bool   Append(const Record& record);
+    size_t GetSize() const;
+    size_t GetCount() const;
+
+    static Record      MakeRecord(Event event, int connID, const std::string& remote);
+    static bool        Load(const std::string& file, std::vector<Record>& records);
+    static std::string ToString(const Record& record);
+
+private:
+    int         m_fd       = (-1);
+    uint8_t*    m_data     = nullptr;
+    size_t      m_capacity = 0;
+    FileHeader* m_header   = nullptr;
+};
+
+static_assert(sizeof(AccessLog::Record) == 32, "access log record must be 32 bytes");
+static_assert(sizeof(AccessLog::FileHeader) == 32, "access log header must be 32 bytes");
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_ACCESS_LOG_H
@@ -0,0 +1,141 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_CLIENT_REACTOR_H
+#define WEB_SOCKET_CPP_CLIENT_REACTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+
+#include "IErrorable.h"
+#include "IRunnable.h"
+
+namespace WebSocketCpp
+{
+
+/*
+ * Event loop shared by many client sockets: a few threads, each one with its own
+ * epoll, drive all the attached connections instead of a thread per connection.
+ * A socket is attached to the least loaded thread, so all its callbacks are called
+ * from that thread and never run concurrently. A callback blocks the other sockets
+ * of the thread, so it must not wait for anything served by the same reactor,
+ * e.g. open another client synchronously.
+ * Besides the socket events a handler gets one-shot timers and tasks posted from
+ * other threads, both are run on its thread and dropped once it is detached.
+ * Default() is the process wide reactor with Config::ClientReactorThreads threads,
+ * it lives while any socket holds it.
+ */
+class ClientReactor : public IErrorable, public IRunnable
+{
+public:
+    class Handler
+    {
+    public:
+        virtual ~Handler()                    = default;
+        virtual void OnEvent(uint32_t events) = 0;
+        virtual void OnTimer()
+        {
+        }
+
+        uint64_t GetReactorId() const
+        {
+            return m_reactorId;
+        }
+
+    private:
+        friend class ClientReactor;
+        std::atomic<uint64_t> m_reactorId{0}; // set before the first event can arrive
+        std::atomic<uint64_t> m_lastId{0};    // kept after Detach(), a concurrent Detach() waits on it
+        uint64_t              m_deadline{0};  // of the timer, guarded by the loop mutex
+    };
+
+    static constexpr uint32_t DEFAULT_EVENTS = EPOLLIN | EPOLLERR | EPOLLHUP;
+    using Task                               = std::function<void()>;
+
+    explicit ClientReactor(size_t threads = 1);
+    ~ClientReactor();
+
+    ClientReactor(const ClientReactor&)            = delete;
+    ClientReactor& operator=(const ClientReactor&) = delete;
+    ClientReactor(ClientReactor&&)                 = delete;
+    ClientReactor& operator=(ClientReactor&&)      = delete;
+
+    bool Init() override;
+    bool Run() override;
+    bool Close(bool wait = true) override;
+    bool WaitFor() override;
+
+    bool   Attach(int32_t fd, Handler* handler, uint32_t events = DEFAULT_EVENTS);
+    bool   Modify(Handler* handler, int32_t fd, uint32_t events);
+    bool   Detach(Handler* handler, int32_t fd); // no callback of the handler runs after it returns
+    bool   SetTimer(Handler* handler, uint64_t timeoutMs); // replaces the previous timer, 0 - cancel
+    bool   Post(uint64_t id, Task task);                    // id is Handler::GetReactorId()
+    size_t GetThreadCount() const;
+    size_t GetHandlerCount() const;
+
+    static std::shared_ptr<ClientReactor> Default();
+
+private:
+    struct Loop
+    {
+        int32_t                                epollFd{-1};
+        int32_t                                wakeFd{-1}; // eventfd, registered with WAKE_ID
+        std::thread                            thread;
+        std::mutex                             mutex;
+        std::condition_variable                cv;
+        std::unordered_map<uint64_t, Handler*> handlers;
+        uint64_t                               current{0}; // handler being called
+        std::multimap<uint64_t, uint64_t>      timers;     // deadline -> handler id
+        std::vector<std::pair<uint64_t, Task>> posted;
+    };
+
+    Loop& GetLoop(uint64_t id) const;
+    void  Wake(Loop& loop);
+    int   NextTimeout(Loop& loop);
+    void  RunLoop(Loop& loop);
+    void  RunTimers(Loop& loop);
+
+    template <typename F>
+    void Dispatch(Loop& loop, uint64_t id, F func);
+
+    static constexpr uint64_t WAKE_ID          = 0;
+    static constexpr size_t   LOOP_BITS        = 8;
+    static constexpr size_t   MAX_THREADS      = 1 << LOOP_BITS;
+    static constexpr size_t   MAX_EVENT_COUNT  = 64;
+    static constexpr int      EPOLL_TIMEOUT_MS = 500;
+
+    std::vector<std::unique_ptr<Loop>> m_loops;
+    std::atomic<bool>                  m_loopsRunning{false};
+    std::atomic<uint64_t>              m_sequence{0};
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_CLIENT_REACTOR_H
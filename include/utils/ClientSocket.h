@@ -2,13 +2,17 @@
 #define WEB_SOCKET_CPP_CLIENT_SOCKET_H
 
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
 
+#include "ClientReactor.h"
 #include "IErrorable.h"
 #include "IRunnable.h"
+#include "Resolver.h"
+#include "SslContext.h"
 #include "common.h"
 
 #ifdef WITH_OPENSSL
@@ -19,7 +23,14 @@
 namespace WebSocketCpp
 {
 
-class ClientSocket : public IErrorable, public IRunnable
+/*
+ * Connect() blocks the caller until the connection (and TLS) is established, Run()
+ * then attaches the socket to the reactor. ConnectAsync() returns at once: the name
+ * is resolved by the resolver and the connect and the TLS handshake are driven by the
+ * reactor, the callback is called from the reactor thread once the socket is ready
+ * to use or has failed. The socket is running from the start, so Run() isn't needed.
+ */
+class ClientSocket : public IErrorable, public IRunnable, private ClientReactor::Handler
 {
 public:
     ClientSocket();
@@ -35,13 +46,19 @@ public:
     bool Close(bool wait = true) override;
     bool WaitFor() override;
 
+    using OnDataCallback    = std::function<void(ByteArray&&)>;
+    using OnCloseCallback   = std::function<void()>;
+    using OnConnectCallback = std::function<void(bool)>;
+    using OnTimeoutCallback = std::function<void()>;
+
+    void SetReactor(std::shared_ptr<ClientReactor> reactor); // before Run(), Default() if not set
+    void SetResolver(std::shared_ptr<IResolver> resolver);   // before ConnectAsync(), ThreadPoolResolver::Default() if not set
     bool Connect(const std::string& host, int32_t port);
+    bool ConnectAsync(const std::string& host, int32_t port, OnConnectCallback callback, uint64_t timeoutMs = CONNECT_TIMEOUT_MS);
+    bool SetTimeout(uint64_t timeoutMs, OnTimeoutCallback callback); // one-shot, once connected, 0 - cancel
     bool Write(const uint8_t* data, size_t size);
     bool IsConnected() const;
 
-    using OnDataCallback  = std::function<void(ByteArray&&)>;
-    using OnCloseCallback = std::function<void()>;
-
     void SetOnData(OnDataCallback callback);
     void SetOnClose(OnCloseCallback callback);
 
@@ -52,37 +69,67 @@ public:
 protected:
     bool SetNonblocking(int32_t fd);
     bool WaitConnect();
-    void ReadLoop();
+    bool WaitEvent(short events, const char* what);
+    bool WaitWritable(std::unique_lock<std::mutex>& lock, short events);
+    void OnEvent(uint32_t events) override;
+    void OnTimer() override;
     void HandleClose();
 
+    void OnResolved(bool ok, const sockaddr_in& address, const std::string& error);
+    void OnTcpConnected();
+    void ConnectDone(bool ok, const std::string& error);
+
 private:
     void Shutdown();
+    void Detach();
     void FreeSsl();
 
 #ifdef WITH_OPENSSL
     bool InitSsl();
     bool ConnectSsl();
+    void ContinueSsl();
+    void ReadSsl();
 #endif
 
 private:
+    enum class ConnectState
+    {
+        Idle,
+        Resolving,
+        Connecting,
+        SslHandshake,
+        Connected,
+    };
+
     static constexpr size_t BUFFER_SIZE        = 1024;
-    static constexpr int    EPOLL_TIMEOUT_MS   = 500;
     static constexpr int    CONNECT_TIMEOUT_MS = 5000;
+    static constexpr int    WRITE_TIMEOUT_MS   = 1000; // a full socket buffer must drain in this time
+#ifdef WITH_OPENSSL
+    static constexpr size_t SSL_BUFFER_SIZE = 16 * 1024; // the largest TLS record payload
+#endif
 
-    int32_t           m_fd{-1};
-    int32_t           m_epoll_fd{-1};
-    std::thread       m_read_thread;
-    std::atomic<bool> m_read_running{false};
-    std::atomic<bool> m_connected{false};
-    OnDataCallback    m_data_callback;
-    OnCloseCallback   m_close_callback;
-    std::mutex        m_write_mutex;
+    int32_t                        m_fd{-1};
+    std::shared_ptr<ClientReactor> m_reactor;
+    std::shared_ptr<IResolver>     m_resolver;
+    ConnectState                   m_connect_state{ConnectState::Idle}; // changed on the reactor thread once attached
+    OnConnectCallback              m_connect_callback;
+    OnTimeoutCallback              m_timeout_callback;
+    std::mutex                     m_run_mutex;
+    std::condition_variable        m_run_cv;
+    std::atomic<bool>              m_connected{false};
+    OnDataCallback                 m_data_callback;
+    OnCloseCallback                m_close_callback;
+    std::mutex                     m_send_mutex;  // one Write() at a time, held while waiting
+    std::mutex                     m_write_mutex; // the socket writes and everything done on the SSL, never held while waiting
 
 #ifdef WITH_OPENSSL
-    std::string m_cert;
-    std::string m_key;
-    SSL_CTX*    m_ssl_ctx{nullptr};
-    SSL*        m_ssl{nullptr};
+    std::string                       m_cert;
+    std::string                       m_key;
+    std::string                       m_ssl_host;
+    std::string                       m_ssl_peer; // host:port, the session cache key
+    std::shared_ptr<SslClientContext> m_ssl_context;
+    SSL*                              m_ssl{nullptr};
+    ByteArray                         m_read_buffer; // reused by ReadSsl()
 #endif
 };
 
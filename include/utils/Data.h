@@ -29,11 +29,17 @@ class Data
 public:
     static std::string             Base64Encode(const unsigned char* bytes_to_encode, size_t in_len);
     static std::string             Base64Encode(const std::string& str);
+    static size_t                  Base64Encode(const uint8_t* in, size_t in_len, char* out);
     static std::string             Base64Decode(const std::string& str);
     static std::array<uint8_t, 20> Sha1Digest(const std::string& string);
 
     static constexpr size_t SHA1_DIGEST_LENGTH = 20;
 
+    static constexpr size_t Base64EncodedLength(size_t size)
+    {
+        return ((size + 2) / 3) * 4;
+    }
+
 #ifdef WITH_ZLIB
     static ByteArray Compress(const ByteArray& data);
     static ByteArray Uncompress(const ByteArray& data);
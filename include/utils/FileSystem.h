@@ -25,6 +25,7 @@
 #ifndef WEB_SOCKET_CPP_FILESYSTEM_H
 #define WEB_SOCKET_CPP_FILESYSTEM_H
 
+#include <ctime>
 #include <string>
 #include <vector>
 
@@ -45,7 +46,10 @@ public:
     static char        PathDelimiter();
     static bool        CreateFolder(const std::string& path);
     static bool        DeleteFolder(const std::string& path);
+    static bool        RotateFile(const std::string& path, size_t keep);
     static std::string GetDateTime();
+    static size_t      GetDateTime(char* buffer, size_t size);
+    static size_t      FormatDateTime(time_t time, char* buffer, size_t size);
     static std::string GetFileModifiedTime(const std::string& file);
     static std::string TempFolder();
     static std::string HomeFolder();
@@ -61,6 +65,8 @@ public:
     };
 
     static std::vector<FileInfo> GetFolder(const std::string& path);
+
+    static constexpr size_t DATE_TIME_LENGTH = 29; // "Sun, 06 Nov 1994 08:49:37 GMT"
 };
 
 } // namespace WebSocketCpp
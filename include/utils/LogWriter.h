@@ -15,15 +15,48 @@
  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
- *  */
+ *
+ */
 
 #ifndef WEB_SOCKET_CPP_LOGWRITER_H
 #define WEB_SOCKET_CPP_LOGWRITER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
 #include <fstream>
+#include <mutex>
 #include <string>
 
-#define LOG(S, T) LogWriter::Instance().Write(S, T)
+#include "AccessLog.h"
+#include "MpscQueue.h"
+#include "ThreadWorker.h"
+
+// mask of the log types compiled in: 1 - Info, 2 - Error, 4 - Access
+#ifndef WEBSOCKETCPP_LOG_TYPES
+#define WEBSOCKETCPP_LOG_TYPES 0x7
+#endif
+
+// the message is built only if the type is both compiled in and enabled
+#define LOG(S, T)                                                           \
+    do                                                                      \
+    {                                                                       \
+        if (LogWriter::IsCompiled(T) && LogWriter::Instance().IsEnabled(T)) \
+        {                                                                   \
+            LogWriter::Instance().Write(S, T);                              \
+        }                                                                   \
+    } while (0)
+
+#define LOG_ACCESS(E, ID, R)                                             \
+    do                                                                   \
+    {                                                                    \
+        if (LogWriter::IsCompiled(LogWriter::LogType::Access) &&         \
+            LogWriter::Instance().IsEnabled(LogWriter::LogType::Access)) \
+        {                                                                \
+            LogWriter::Instance().WriteAccess(E, ID, R);                 \
+        }                                                                \
+    } while (0)
 
 class LogWriter
 {
@@ -35,20 +68,78 @@ public:
         Access = 2,
     };
 
+    static constexpr size_t LOG_TYPE_COUNT    = 3;
+    static constexpr size_t QUEUE_CAPACITY    = 8192;
+    static constexpr size_t BATCH_SIZE        = 512;
+    static constexpr int    FLUSH_INTERVAL_MS = 100;
+
     ~LogWriter();
     static LogWriter& Instance();
-    void              Write(const std::string& text, LogType type = LogType::Info);
+    void              Write(std::string text, LogType type = LogType::Info);
+    void              WriteAccess(WebSocketCpp::AccessLog::Event event, int connID, const std::string& remote = "");
+    void              Flush();
+    void              Reopen();
+    bool              IsEnabled(LogType type) const;
+    void              SetEnabled(LogType type, bool enabled);
+    uint64_t          GetDropped(LogType type) const;
+
+    static constexpr bool IsCompiled(LogType type)
+    {
+        return (WEBSOCKETCPP_LOG_TYPES & (1 << static_cast<int>(type))) != 0;
+    }
 
 protected:
     LogWriter();
 
     bool               Open();
     bool               Close();
+    void*              WriterThread(std::atomic<bool>& running);
+    size_t             WriteBatch();
+    void               WriteRecord(const WebSocketCpp::AccessLog::Record& record, time_t now);
+    bool               NeedRotate(size_t index, size_t pending, time_t now) const;
+    void               Rotate(size_t index, time_t now);
+    std::string        GetFileName(size_t index) const;
     static std::string LogType2String(LogType type);
 
 private:
-    bool          m_opened = false;
-    std::ofstream m_streams[3];
+    struct Entry
+    {
+        LogType     type = LogType::Info;
+        time_t      time = 0;
+        std::string text;
+    };
+
+    using AccessRecord = WebSocketCpp::AccessLog::Record;
+
+    bool                                  m_opened = false;
+    std::ofstream                         m_streams[LOG_TYPE_COUNT];
+    WebSocketCpp::MpscQueue<Entry>        m_queue{QUEUE_CAPACITY};
+    WebSocketCpp::MpscQueue<AccessRecord> m_accessQueue{QUEUE_CAPACITY};
+    WebSocketCpp::ThreadWorker            m_thread;
+    std::atomic<bool>                     m_enabled[LOG_TYPE_COUNT];
+    std::atomic<uint64_t>                 m_dropped[LOG_TYPE_COUNT];
+    std::atomic<uint64_t>                 m_pushed{0};
+    std::atomic<uint64_t>                 m_written{0};
+    std::atomic<bool>                     m_sleeping{false};
+    std::atomic<bool>                     m_binaryAccess{false};
+    std::atomic<bool>                     m_reopen{false};
+    std::mutex                            m_mutex;
+    std::condition_variable               m_condition;
+
+    // used by the writer thread only
+    std::string             m_buffers[LOG_TYPE_COUNT];
+    std::string             m_console;
+    time_t                  m_stampTime = 0;
+    char                    m_stamp[32];
+    size_t                  m_stampSize = 0;
+    std::string             m_folder;
+    size_t                  m_maxFileSize    = 0;
+    uint64_t                m_rotateInterval = 0;
+    size_t                  m_maxFiles       = 0;
+    size_t                  m_sizes[LOG_TYPE_COUNT];
+    time_t                  m_openTimes[LOG_TYPE_COUNT];
+    WebSocketCpp::AccessLog m_accessLog;
+    time_t                  m_accessOpenTime = 0;
 };
 
 #endif // WEB_SOCKET_CPP_LOGWRITER_H
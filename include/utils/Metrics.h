@@ -0,0 +1,223 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_METRICS_H
+#define WEB_SOCKET_CPP_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common_ws.h"
+
+namespace WebSocketCpp
+{
+
+/*
+ * Process wide metrics registry. Every thread updates its own slot with relaxed
+ * atomics, so the hot paths never share a cache line or take a lock, the slots are
+ * summed up only when a snapshot is taken. Threads over MAX_SLOTS share the slots
+ * round robin, what stays correct since the updates are atomic anyway.
+ * Histograms are log-linear (HDR like): 8 linear sub-buckets per power of two,
+ * i.e. every recorded value is kept with 12.5% precision.
+ */
+class Metrics
+{
+public:
+    enum class Counter
+    {
+        Accepts = 0,
+        AcceptErrors,
+        Handshakes,
+        HandshakeErrors,
+        ParseErrors,
+        BytesIn,
+        BytesOut,
+        FramesInText,
+        FramesInBinary,
+        FramesInClose,
+        FramesInPing,
+        FramesInPong,
+        FramesInOther,
+        FramesOutText,
+        FramesOutBinary,
+        FramesOutClose,
+        FramesOutPing,
+        FramesOutPong,
+        FramesOutOther,
+        MetricsRequests,
+        ClientReconnectAttempts,
+        ClientReconnects,
+        ClientSendQueueDropped, // WebSocketClient messages refused while reconnecting
+        TlsKernelConnections,   // WSS connections encrypting in the kernel (kTLS)
+        TlsUserConnections,     // WSS connections encrypting in OpenSSL
+        TlsResumed,             // WSS handshakes that resumed a session
+        ClientTlsResumed,       // the same on the client side
+        HandshakeTimeouts,      // connections closed by the server timers
+        IdleTimeouts,
+        PongTimeouts,
+    };
+
+    enum class Gauge
+    {
+        Connections = 0,
+        ConnectionQueueDepth, // tasks waiting in ServerSocket::Connection
+        RequestQueueDepth,    // parsed frames waiting in WebSocketServer
+        MemoryPoolUsedBytes,
+        MemoryPoolTotalBytes,
+    };
+
+    enum class Histogram
+    {
+        HandshakeLatencyNs = 0,
+        HandlerLatencyNs,
+        MessageSizeBytes,
+        TraceReadNs,            // epoll_wait returned -> the data is read (see Trace.h)
+        TraceConnectionQueueNs, // -> taken from the Connection task queue
+        TraceDispatchNs,        // -> appended to the WebSocketServer request queue
+        TraceSignalNs,          // -> the request thread is woken up
+        TraceParseNs,           // -> the frame is parsed
+        TraceHandlerQueueNs,    // -> the handler is called
+        TraceHandlerNs,         // -> the handler returned
+        TraceTotalNs,           // epoll_wait returned -> the handler returned
+        ClientReconnectNs,      // WebSocketClient: connection lost -> handshake done again
+    };
+
+    static constexpr size_t COUNTER_COUNT   = static_cast<size_t>(Counter::PongTimeouts) + 1;
+    static constexpr size_t GAUGE_COUNT     = static_cast<size_t>(Gauge::MemoryPoolTotalBytes) + 1;
+    static constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::ClientReconnectNs) + 1;
+    static constexpr size_t SUB_BUCKET_BITS = 3;
+    static constexpr size_t SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT    = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    static constexpr size_t MAX_SLOTS       = 64;
+
+    struct HistogramData
+    {
+        uint64_t              count = 0;
+        uint64_t              sum   = 0;
+        std::vector<uint64_t> buckets;
+
+        uint64_t Percentile(double percent) const;
+        double   Mean() const;
+    };
+
+    struct Snapshot
+    {
+        uint64_t      counters[COUNTER_COUNT];
+        int64_t       gauges[GAUGE_COUNT];
+        HistogramData histograms[HISTOGRAM_COUNT];
+
+        uint64_t             Get(Counter counter) const;
+        int64_t              Get(Gauge gauge) const;
+        const HistogramData& Get(Histogram histogram) const;
+    };
+
+    static Metrics& Instance();
+
+    Metrics(const Metrics&)            = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics(Metrics&&)                 = delete;
+    Metrics& operator=(Metrics&&)      = delete;
+
+    inline void Add(Counter counter, uint64_t value = 1)
+    {
+        LocalSlot().counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline void Add(Gauge gauge, int64_t delta)
+    {
+        LocalSlot().gauges[static_cast<size_t>(gauge)].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    inline void Record(Histogram histogram, uint64_t value)
+    {
+        auto& data = LocalSlot().histograms[static_cast<size_t>(histogram)];
+        data.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        data.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    Snapshot    GetSnapshot() const;
+    std::string ToPrometheus() const;
+
+    static Counter FrameCounter(MessageType type, bool incoming);
+
+    static inline uint64_t Now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    static inline size_t BucketIndex(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return static_cast<size_t>(value);
+        }
+
+        size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+        size_t sub      = static_cast<size_t>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t BucketLowerBound(size_t index);
+    static uint64_t BucketUpperBound(size_t index);
+
+protected:
+    Metrics();
+
+private:
+    struct HistogramSlot
+    {
+        std::atomic<uint64_t> buckets[BUCKET_COUNT];
+        std::atomic<uint64_t> sum;
+    };
+
+    struct alignas(64) Slot
+    {
+        Slot();
+
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+        std::atomic<int64_t>  gauges[GAUGE_COUNT];
+        HistogramSlot         histograms[HISTOGRAM_COUNT];
+    };
+
+    inline Slot& LocalSlot()
+    {
+        static thread_local Slot* slot = nullptr;
+        if (slot == nullptr)
+        {
+            slot = AcquireSlot();
+        }
+
+        return *slot;
+    }
+
+    Slot* AcquireSlot();
+
+    std::atomic<Slot*>  m_slots[MAX_SLOTS];
+    std::atomic<size_t> m_nextSlot{0};
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_METRICS_H
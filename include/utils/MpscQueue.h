@@ -0,0 +1,141 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_MPSC_QUEUE_H
+#define WEB_SOCKET_CPP_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace WebSocketCpp
+{
+
+/*
+ * Bounded lock-free queue for many producers and a single consumer (D. Vyukov's array queue).
+ * Every cell carries a sequence number, a producer claims a cell with one CAS on the tail
+ * and publishes it by bumping the sequence, so neither side ever blocks. A full queue
+ * rejects the value instead of waiting.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(size_t capacity)
+        : m_mask(RoundUp(capacity) - 1),
+          m_cells(new Cell[m_mask + 1])
+    {
+        for (size_t i = 0; i <= m_mask; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&)            = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    MpscQueue(MpscQueue&&)                 = delete;
+    MpscQueue& operator=(MpscQueue&&)      = delete;
+
+    bool TryPush(T&& value)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell*  cell;
+
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+
+            size_t    seq  = cell->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // must be called from the consumer thread only
+    bool TryPop(T& value)
+    {
+        Cell*     cell = &m_cells[m_head & m_mask];
+        size_t    seq  = cell->sequence.load(std::memory_order_acquire);
+        ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(m_head + 1);
+        if (diff < 0)
+        {
+            return false; // empty
+        }
+
+        value = std::move(cell->value);
+        cell->sequence.store(m_head + m_mask + 1, std::memory_order_release);
+        m_head++;
+
+        return true;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T                   value;
+    };
+
+    static size_t RoundUp(size_t value)
+    {
+        size_t result = 2;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t            m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(CACHE_LINE) std::atomic<size_t> m_tail{0};
+    alignas(CACHE_LINE) size_t m_head{0};
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_MPSC_QUEUE_H
@@ -0,0 +1,90 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_RESOLVER_H
+#define WEB_SOCKET_CPP_RESOLVER_H
+
+#include <netinet/in.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "ThreadPool.h"
+
+namespace WebSocketCpp
+{
+
+/*
+ * Host name resolution for the asynchronous client connect. The callback may be
+ * called from any thread, even before Resolve() returns, so the caller must not
+ * hold a lock it takes in the callback.
+ */
+class IResolver
+{
+public:
+    using Callback = std::function<void(bool ok, const sockaddr_in& address, const std::string& error)>;
+
+    virtual ~IResolver() = default;
+
+    virtual void Resolve(const std::string& host, int32_t port, Callback callback) = 0;
+
+    static bool ParseNumeric(const std::string& host, int32_t port, sockaddr_in& address);
+};
+
+// getaddrinfo() on a small pool of threads, numeric addresses are answered in place
+class ThreadPoolResolver : public IResolver
+{
+public:
+    explicit ThreadPoolResolver(size_t threads = DEFAULT_THREADS);
+    ~ThreadPoolResolver() override;
+
+    ThreadPoolResolver(const ThreadPoolResolver&)            = delete;
+    ThreadPoolResolver& operator=(const ThreadPoolResolver&) = delete;
+
+    void Resolve(const std::string& host, int32_t port, Callback callback) override;
+
+    static std::shared_ptr<ThreadPoolResolver> Default();
+
+private:
+    static void Lookup(std::string host, int32_t port, Callback callback);
+
+    static constexpr size_t DEFAULT_THREADS = 2;
+
+    ThreadPool<std::string, int32_t, Callback> m_pool;
+};
+
+// a fixed host table answered in place, for tests and pinned upstreams
+class StaticResolver : public IResolver
+{
+public:
+    void Add(const std::string& host, const std::string& address);
+    void Resolve(const std::string& host, int32_t port, Callback callback) override;
+
+private:
+    std::mutex                                   m_mutex;
+    std::unordered_map<std::string, std::string> m_hosts;
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_RESOLVER_H
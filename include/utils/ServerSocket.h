@@ -5,10 +5,12 @@
 #include <condition_variable>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifdef WITH_OPENSSL
 #include <openssl/err.h>
@@ -18,6 +20,10 @@
 #include "IErrorable.h"
 #include "IRunnable.h"
 #include "MemoryPool.h"
+#include "SslContext.h"
+#include "ThreadPool.h"
+#include "TimerWheel.h"
+#include "Trace.h"
 #include "common.h"
 
 namespace WebSocketCpp
@@ -44,9 +50,17 @@ public:
     void OnDataReady(OnDataReadyCallback callback);
 
     bool Write(int32_t idx, const uint8_t* data, size_t size);
+    bool CloseConnection(int32_t idx); // from any thread, the epoll thread does the rest
+
+    // before Init(), all in ms, 0 - off. A connection has to be upgraded within the
+    // handshake timeout, after that it's pinged when silent for the ping interval and
+    // closed when nothing comes back in the pong timeout or nothing at all in the idle one
+    void SetTimeouts(uint64_t handshakeMs, uint64_t pingMs, uint64_t pongMs, uint64_t idleMs);
+    void SetUpgraded(int32_t idx);
 
 #ifdef WITH_OPENSSL
     void SetSslCredentials(const std::string& cert, const std::string& key);
+    void SetKtls(bool enable); // before Init(), records are sent by the kernel where it supports that
 #endif
 
 protected:
@@ -57,12 +71,13 @@ protected:
     bool    AcceptClient();
     int32_t FindFreeConnection();
     bool    HandleRead(int32_t idx);
-    bool    CloseSocket(int32_t fd);
+    bool    CloseSocket(int32_t idx);
 
     void OnConnect(int32_t idx);
     void OnDisconnect(int32_t idx);
     void OnData(int32_t idx, ByteArray&& data);
     void FreeData(const uint8_t* data);
+    void SendPing(int32_t idx);
 
     class Connection
     {
@@ -73,9 +88,28 @@ protected:
         int32_t GetIdx() const;
         void    Reserve(int32_t fd);
         void    Assign(ServerSocket* server, int32_t fd, int32_t idx);
-        void    Submit(const uint8_t* data, size_t size);
+        void    Submit(const uint8_t* data, size_t size, const Trace::Context& trace);
         void    Disconnect();
         void    Free();
+        void    Ping();
+        void    SetUpgraded(bool upgraded);
+        bool    IsUpgraded() const;
+
+        std::mutex& GetSendMutex();
+        std::mutex& GetWriteMutex();
+        uint32_t    GetGeneration() const;
+        bool        IsClosed() const;
+        void        MarkClosed(); // under GetWriteMutex(), the socket isn't written anymore
+#ifdef WITH_OPENSSL
+        void AttachSsl(SSL* ssl); // the handshake is pending until SslEstablished()
+        void SslEstablished(bool ktls);
+        void SslFailed(); // the handshake worker gives up, the epoll thread closes it
+        bool IsSslFailed() const;
+        SSL* DetachSsl(); // under GetWriteMutex()
+        SSL* GetSsl() const;
+        bool IsSslPending() const;
+        bool IsKtls() const;
+#endif
 
     protected:
         void runThread();
@@ -88,33 +122,61 @@ protected:
             CONNECTION,
             DISCONNECTION,
             DATA,
+            PING,
         };
-        using TaskArg = std::tuple<TaskType, const uint8_t*, size_t>;
+        using TaskArg = std::tuple<TaskType, const uint8_t*, size_t, Trace::Context>;
 
         ServerSocket*           m_server{nullptr};
         std::atomic<int32_t>    m_fd{-1};
         int32_t                 m_idx{-1};
         std::thread             m_process_thread;
         std::atomic_bool        m_running{false};
+        std::atomic_bool        m_upgraded{false};
         std::condition_variable m_cv;
         std::mutex              m_args_mtx;
         std::queue<TaskArg>     m_args_queue;
+        std::mutex              m_send_mutex;  // one Write() at a time, held while it waits for the socket
+        std::mutex              m_write_mutex; // the socket writes and the SSL below, never held while waiting
+        std::atomic<bool>       m_closed{false};
+        std::atomic<uint32_t>   m_generation{0}; // bumped on close, a waiting Write() sees the slot was reused
+#ifdef WITH_OPENSSL
+        SSL*              m_ssl{nullptr};
+        std::atomic<bool> m_ssl_pending{false}; // the handshake is running on the pool
+        std::atomic<bool> m_ssl_failed{false};
+        bool              m_ktls{false};        // records are written with plain send()
+#endif
     };
 
 private:
 #ifdef WITH_OPENSSL
     bool InitSsl();
     bool BeginSslHandshake(int32_t fd, int32_t idx);
-    bool ContinueSslHandshake(int32_t idx);
+    void ContinueSslHandshake(int32_t idx);
+    bool ReadSsl(int32_t idx, SSL* ssl, const Trace::Context& trace);
+    void SslEstablished(int32_t idx);
 #endif
+    void StartTimers(int32_t idx);
+    void CheckTimers(int32_t idx);
+    void Expire(int32_t idx);
+    bool WaitSocket(Connection& conn, std::unique_lock<std::mutex>& lock, uint32_t generation, short events);
 
     static constexpr size_t MAX_CLIENT_COUNT   = 100;
     static constexpr size_t LISTEN_QUEUE_SIZE  = 10;
     static constexpr size_t PROCESS_TIMEOUT_MS = 1000;
     static constexpr size_t BUFFER_SIZE        = 1024;
     static constexpr size_t MAX_EVENT_COUNT    = 64;
+    static constexpr size_t TIMER_TICK_MS      = 10;
+    static constexpr size_t WRITE_TIMEOUT_MS   = 1000; // a full socket buffer must drain in this time
+#ifdef WITH_OPENSSL
+    static constexpr size_t SSL_BUFFER_SIZE = 16 * 1024; // the largest TLS record payload
+    static constexpr size_t POOL_BLOCK_SIZE = SSL_BUFFER_SIZE;
+#else
+    static constexpr size_t POOL_BLOCK_SIZE = BUFFER_SIZE;
+#endif
 
-    std::mutex             m_write_mutex;
+#ifdef WITH_TRACING
+    uint64_t m_epollTime{0}; // when the current batch of events was returned
+#endif
     size_t                 m_client_count{MAX_CLIENT_COUNT};
     std::string            m_host{};
     int32_t                m_port{-1};
@@ -128,12 +190,28 @@ private:
     OnDisconnectedCalback  m_disconnected_callback;
     OnDataReadyCallback    m_data_ready_callback;
 
+    struct Liveness
+    {
+        uint64_t acceptMs{0};
+        uint64_t readMs{0}; // the last read
+        uint64_t pingMs{0}; // the last ping sent
+    };
+    uint64_t                    m_handshake_timeout_ms{0};
+    uint64_t                    m_ping_interval_ms{0};
+    uint64_t                    m_pong_timeout_ms{0};
+    uint64_t                    m_idle_timeout_ms{0};
+    uint64_t                    m_now_ms{0}; // taken once per epoll_wait()
+    std::unique_ptr<TimerWheel> m_timers;    // the epoll thread only, like m_liveness
+    std::vector<Liveness>       m_liveness;
+    std::vector<int32_t>        m_deferred_reads; // the write mutex was busy, read again on the next round
+
 #ifdef WITH_OPENSSL
-    std::string                                        m_cert;
-    std::string                                        m_key;
-    SSL_CTX*                                           m_ssl_ctx{nullptr};
-    std::unordered_map<int32_t, SSL*>                  m_ssl_conns;
-    std::unordered_map<int32_t, std::pair<int32_t, SSL*>> m_pending_ssl;
+    std::string                          m_cert;
+    std::string                          m_key;
+    SSL_CTX*                             m_ssl_ctx{nullptr};
+    bool                                 m_ktls{false};
+    std::unique_ptr<SslTicketKeys>       m_ticket_keys;
+    std::unique_ptr<ThreadPool<int32_t>> m_handshake_pool;
 #endif
 };
 
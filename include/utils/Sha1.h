@@ -31,29 +31,35 @@ public:
     SHA1();
     void                    update(const std::string& s);
     void                    update(std::istream& is);
+    void                    update(const uint8_t* data, size_t size);
     std::string             final();
     std::array<uint8_t, 20> digest();
 
     static std::string from_file(const std::string& filename);
+    static void        digest(const uint8_t* data, size_t size, uint8_t* out); /* one-shot, no heap; out holds 20 bytes */
 
-private:
-    typedef uint64_t uint32; /* just needs to be at least 32bit */
-    typedef uint64_t uint64; /* just needs to be at least 64bit */
+    /* Block-oriented core: hashes `blocks` 64-byte blocks into `state`.
+     * Uses the Intel SHA extensions when the CPU has them */
+    static void process_blocks(uint32_t state[5], const uint8_t* data, size_t blocks);
+    static bool hardware_accelerated();
+    static bool enable_hardware(bool enable); /* for tests and benchmarks */
+
+    static const unsigned int DIGEST_BYTES = 20;
+    static const unsigned int BLOCK_BYTES  = 64;
 
-    static const unsigned int DIGEST_INTS = 5;  /* number of 32bit integers per SHA1 digest */
-    static const unsigned int BLOCK_INTS  = 16; /* number of 32bit integers per SHA1 block */
-    static const unsigned int BLOCK_BYTES = BLOCK_INTS * 4;
+private:
+    static const unsigned int DIGEST_INTS = 5; /* number of 32bit integers per SHA1 digest */
 
-    uint64      m_digest[DIGEST_INTS];
-    std::string m_buffer;
-    uint64      m_transforms;
+    uint32_t m_digest[DIGEST_INTS];
+    uint8_t  m_buffer[BLOCK_BYTES];
+    size_t   m_buffer_size;
+    uint64_t m_total;
 
-    void prepare();
     void reset();
-    void transform(uint32 block[BLOCK_BYTES]);
+    void finish(uint8_t* out);
 
-    static void buffer_to_block(const std::string& buffer, uint32 block[BLOCK_BYTES]);
-    static void read(std::istream& is, std::string& s, int max);
+    static void init_state(uint32_t state[DIGEST_INTS]);
+    static void pad(uint32_t state[DIGEST_INTS], const uint8_t* tail, size_t tail_size, uint64_t total);
 };
 
 std::string sha1(const std::string& string);
@@ -0,0 +1,110 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef WITH_OPENSSL
+#ifndef WEB_SOCKET_CPP_SSL_CONTEXT_H
+#define WEB_SOCKET_CPP_SSL_CONTEXT_H
+
+#include <openssl/ssl.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace WebSocketCpp
+{
+
+/*
+ * Session ticket keys of a server SSL_CTX. The newest key issues the tickets and is
+ * replaced every `lifetime` seconds, the previous one still opens the tickets it
+ * issued, so a ticket is good for one to two lifetimes.
+ */
+class SslTicketKeys
+{
+public:
+    explicit SslTicketKeys(uint64_t lifetimeSec);
+
+    SslTicketKeys(const SslTicketKeys&)            = delete;
+    SslTicketKeys& operator=(const SslTicketKeys&) = delete;
+
+    bool Attach(SSL_CTX* ctx); // the keys must outlive the context
+
+private:
+    struct Key
+    {
+        uint8_t  name[16];
+        uint8_t  aes[32];
+        uint8_t  hmac[32];
+        uint64_t created;
+    };
+
+    static constexpr size_t KEY_COUNT = 2;
+
+    const Key* Current();
+    const Key* Find(const uint8_t* name, bool& current);
+    bool       Rotate(uint64_t now);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static int OnTicket(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int enc);
+#else
+    static int OnTicket(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipher, HMAC_CTX* mac, int enc);
+#endif
+
+    uint64_t        m_lifetime;
+    std::mutex      m_mutex;
+    std::deque<Key> m_keys; // the newest first
+};
+
+/*
+ * The client SSL_CTX shared by all the sockets with the same credentials, it
+ * keeps the last session of every host:port, so a reconnect resumes it with an
+ * abbreviated handshake.
+ */
+class SslClientContext
+{
+public:
+    ~SslClientContext();
+
+    SslClientContext(const SslClientContext&)            = delete;
+    SslClientContext& operator=(const SslClientContext&) = delete;
+
+    // nullptr and the error if the certificate or the key can't be loaded
+    static std::shared_ptr<SslClientContext> Get(const std::string& cert, const std::string& key, std::string& error);
+
+    // a new connection to the peer, the peer string must outlive the SSL
+    SSL* NewSsl(const std::string& host, const std::string* peer);
+
+private:
+    SslClientContext() = default;
+
+    static int OnNewSession(SSL* ssl, SSL_SESSION* session);
+
+    SSL_CTX*                                      m_ctx{nullptr};
+    mutable std::mutex                            m_mutex;
+    std::unordered_map<std::string, SSL_SESSION*> m_sessions;
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_SSL_CONTEXT_H
+#endif // WITH_OPENSSL
@@ -37,7 +37,19 @@ public:
 
     using Ranges = std::vector<Range>;
 
+    // Splits CRLF terminated lines, keeps its position between calls as more data arrives
+    struct LineTokenizer
+    {
+        size_t lineStart{0};
+        size_t scanned{0};
+
+        void   Reset(size_t start);
+        size_t Next(const WebSocketCpp::ByteArray& data, Ranges& lines);
+    };
+
     static size_t                             SearchPosition(const WebSocketCpp::ByteArray& str, const WebSocketCpp::ByteArray& substring, size_t start = 0, size_t end = SIZE_MAX);
+    static const uint8_t*                     Search(const uint8_t* data, size_t size, const uint8_t* needle, size_t needleSize);
+    static size_t                             TokenizeLines(const WebSocketCpp::ByteArray& data, size_t start, Ranges& lines);
     static Ranges                             Split(const WebSocketCpp::ByteArray& str, const WebSocketCpp::ByteArray& delimiter, size_t start = 0, size_t end = SIZE_MAX);
     static size_t                             SearchPositionReverse(const WebSocketCpp::ByteArray& str, const WebSocketCpp::ByteArray& substring, size_t start = 0, size_t end = SIZE_MAX);
     static Ranges                             SplitReverse(const WebSocketCpp::ByteArray& str, const WebSocketCpp::ByteArray& delimiter, size_t start = 0, size_t end = SIZE_MAX);
@@ -62,8 +74,11 @@ public:
     static void                               Replace(std::string& str, const std::string& find, const std::string& replace);
     static void                               RandInit();
     static uint32_t                           GetRand(uint32_t min, uint32_t max);
+    static uint32_t                           MaskKey(); // per thread, drawn in batches from a generator seeded once by std::random_device
+    static void                               MaskCopy(uint8_t* dst, const uint8_t* src, size_t size, uint32_t key); // dst may be src
     static bool                               Compare(const WebSocketCpp::ByteArray& arr1, const WebSocketCpp::ByteArray& arr2);
     static bool                               Compare(const std::string& a, const std::string& b);
+    static bool                               Compare(const char* str1, size_t length1, const char* str2, size_t length2);
     static std::string                        GenerateRandomString(size_t length = 20, bool uppercase = true, bool special = true);
     static std::map<std::string, std::string> ParseParamString(const std::string& str, size_t start = 0);
 
@@ -0,0 +1,93 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#ifndef WEB_SOCKET_CPP_TIMER_WHEEL_H
+#define WEB_SOCKET_CPP_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace WebSocketCpp
+{
+
+/*
+ * Hierarchical hashed timing wheel (Varghese & Lauck), four levels of 64 slots.
+ * The timers are the ids 0..capacity-1 linked into the slots intrusively, so
+ * scheduling, cancelling and expiring one is O(1) and nothing is allocated after
+ * the construction. A timer too far for a level waits in the one above and moves
+ * down when the lower level wraps around. Not thread safe, one thread drives it.
+ */
+class TimerWheel
+{
+public:
+    using ExpiredCallback = std::function<void(uint32_t id)>;
+
+    TimerWheel(size_t capacity, uint64_t tickMs, uint64_t nowMs);
+
+    TimerWheel(const TimerWheel&)            = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    void   Schedule(uint32_t id, uint64_t expireMs); // replaces the pending expiry of the id
+    void   Cancel(uint32_t id);
+    bool   IsScheduled(uint32_t id) const;
+    size_t GetCount() const;
+
+    // calls back every timer that is due by now, the callback may schedule again
+    size_t Advance(uint64_t nowMs, const ExpiredCallback& callback);
+    // how long the caller may sleep before Advance() has some work, UINT64_MAX if none is scheduled
+    uint64_t NextTimeoutMs(uint64_t nowMs) const;
+
+private:
+    static constexpr size_t   LEVEL_BITS = 6;
+    static constexpr size_t   LEVELS     = 4;
+    static constexpr size_t   SLOTS      = 1 << LEVEL_BITS;
+    static constexpr uint64_t SLOT_MASK  = SLOTS - 1;
+    static constexpr uint64_t MAX_TICKS  = (1ULL << (LEVEL_BITS * LEVELS)) - 1;
+    static constexpr uint32_t NIL        = UINT32_MAX;
+    static constexpr uint32_t EXPIRING   = LEVELS * SLOTS; // the slot taken out by Advance()
+
+    struct Node
+    {
+        uint64_t expire{0}; // tick
+        uint32_t prev{NIL};
+        uint32_t next{NIL};
+        uint32_t slot{NIL}; // NIL - not scheduled
+    };
+
+    void Insert(uint32_t id);
+    void Link(uint32_t id, uint32_t slot);
+    void Unlink(uint32_t id);
+    void Cascade(size_t level, size_t index);
+
+    uint64_t m_tick_ms;
+    uint64_t m_start_ms;
+    uint64_t m_tick{0}; // the next tick to expire
+    size_t   m_count{0};
+
+    std::vector<Node>     m_nodes;
+    std::vector<uint32_t> m_heads; // LEVELS * SLOTS + EXPIRING
+};
+
+} // namespace WebSocketCpp
+
+#endif // WEB_SOCKET_CPP_TIMER_WHEEL_H
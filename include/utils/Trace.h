@@ -0,0 +1,167 @@
+/*
+ *  * Copyright (c) 2026 ruslan@muhlinin.com
+ *  * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *  * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef WEB_SOCKET_CPP_TRACE_H
+#define WEB_SOCKET_CPP_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Metrics.h"
+
+namespace WebSocketCpp
+{
+
+/*
+ * Per message latency tracing, built with WITH_TRACING (cmake -DWEBSOCKETCPP_TRACING=ON).
+ * A Context travels with the data from epoll_wait to the message handler and is stamped
+ * at every stage, the differences land in the Metrics::Histogram::Trace* histograms.
+ * Only every N-th read is traced (Config::TraceSampleRate), the rest costs one
+ * thread local decrement. Without WITH_TRACING the Context is empty and the TRACE_*
+ * macros expand to nothing.
+ */
+class Trace
+{
+public:
+    enum class Point
+    {
+        EpollReturn = 0,
+        ReadDone,
+        Dequeued,
+        Queued,
+        Woken,
+        Parsed,
+        HandlerStart,
+        HandlerEnd,
+    };
+
+    static constexpr size_t POINT_COUNT = static_cast<size_t>(Point::HandlerEnd) + 1;
+
+    struct Context
+    {
+#ifdef WITH_TRACING
+        uint64_t stamps[POINT_COUNT];
+        bool     active = false;
+
+        inline void Start(uint64_t epollTime)
+        {
+            active = Trace::Sample();
+            if (active)
+            {
+                for (auto& stamp : stamps)
+                {
+                    stamp = 0;
+                }
+                stamps[static_cast<size_t>(Point::EpollReturn)] = epollTime;
+            }
+        }
+
+        // the first stamp of a point wins, the request thread may pass a point several times
+        inline void Stamp(Point point)
+        {
+            if (active && stamps[static_cast<size_t>(point)] == 0)
+            {
+                stamps[static_cast<size_t>(point)] = Metrics::Now();
+            }
+        }
+
+        // takes `other` over unless a message is traced already
+        inline bool Adopt(const Context& other)
+        {
+            if (active || !other.active)
+            {
+                return false;
+            }
+            *this = other;
+            return true;
+        }
+
+        inline void Reset()
+        {
+            active = false;
+        }
+
+        void Finish();
+#endif
+    };
+
+    static void     SetSampleRate(uint32_t rate);
+    static uint32_t GetSampleRate();
+    static Context& Current(); // hands a context over between calls on the same thread
+
+#ifdef WITH_TRACING
+    static inline bool Sample()
+    {
+        static thread_local uint32_t countdown = 0;
+        if (countdown > 0)
+        {
+            countdown--;
+            return false;
+        }
+
+        uint32_t rate = m_sampleRate.load(std::memory_order_relaxed);
+        if (rate == 0)
+        {
+            return false; // off
+        }
+        countdown = rate - 1;
+
+        return true;
+    }
+#endif
+
+private:
+    static std::atomic<uint32_t> m_sampleRate;
+};
+
+} // namespace WebSocketCpp
+
+#ifdef WITH_TRACING
+#define TRACE_START(CTX, TIME)  (CTX).Start(TIME)
+#define TRACE_STAMP(CTX, POINT) (CTX).Stamp(WebSocketCpp::Trace::Point::POINT)
+#define TRACE_ADOPT(CTX, OTHER, POINT)                      \
+    do                                                      \
+    {                                                       \
+        if ((CTX).Adopt(OTHER))                             \
+        {                                                   \
+            (CTX).Stamp(WebSocketCpp::Trace::Point::POINT); \
+        }                                                   \
+    } while (0)
+#define TRACE_FINISH(CTX)       (CTX).Finish()
+#define TRACE_RESET(CTX)        (CTX).Reset()
+#define TRACE_HANDOFF(CTX)      WebSocketCpp::Trace::Current() = (CTX)
+#define TRACE_TAKE(CTX)                         \
+    do                                          \
+    {                                           \
+        (CTX) = WebSocketCpp::Trace::Current(); \
+        WebSocketCpp::Trace::Current().Reset(); \
+    } while (0)
+#else
+// the arguments are still referenced, no unused warnings when the tracing is compiled out
+#define TRACE_START(CTX, TIME)         ((void)(CTX))
+#define TRACE_STAMP(CTX, POINT)        ((void)(CTX))
+#define TRACE_ADOPT(CTX, OTHER, POINT) ((void)(CTX), (void)(OTHER))
+#define TRACE_FINISH(CTX)              ((void)(CTX))
+#define TRACE_RESET(CTX)               ((void)(CTX))
+#define TRACE_HANDOFF(CTX)             ((void)(CTX))
+#define TRACE_TAKE(CTX)                ((void)(CTX))
+#endif
+
+#endif // WEB_SOCKET_CPP_TRACE_H
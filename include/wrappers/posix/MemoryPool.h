@@ -25,6 +25,8 @@
 #include <mutex>
 #include <vector>
 
+#include "Metrics.h"
+
 namespace WebSocketCpp
 {
 
@@ -42,6 +44,9 @@ public:
 
     void free(const uint8_t* ptr);
 
+    // gives the tail of an allocation back, the block keeps its address
+    void shrink(const uint8_t* ptr, std::size_t size);
+
     inline std::size_t total_size() const noexcept
     {
         return m_total_size;
@@ -80,6 +85,7 @@ public:
     void reset() noexcept
     {
         std::lock_guard<std::mutex> l(m_mutex);
+        Metrics::Instance().Add(Metrics::Gauge::MemoryPoolUsedBytes, -static_cast<int64_t>(m_used_size));
         m_regions.clear();
         m_used_size = 0;
     }
@@ -0,0 +1,87 @@
+#include "HandshakeResponse.h"
+
+#include <cstring>
+
+#include "Data.h"
+#include "FileSystem.h"
+#include "Sha1.h"
+#include "common_ws.h"
+
+using namespace WebSocketCpp;
+
+constexpr size_t HandshakeResponse::ACCEPT_KEY_LENGTH;
+constexpr size_t HandshakeResponse::MAX_KEY_LENGTH;
+
+void HandshakeResponse::Init(const std::string& serverName)
+{
+    std::string data = "HTTP/1.1 101 Switching Protocols\r\n";
+    if (!serverName.empty())
+    {
+        data += "Server: " + serverName + "\r\n";
+    }
+    data += "Date: ";
+    m_datePos = data.size();
+    data += std::string(FileSystem::DATE_TIME_LENGTH, ' ') + "\r\n";
+    data += "Upgrade: websocket\r\n";
+    data += "Connection: Upgrade\r\n";
+    data += "Sec-WebSocket-Accept: ";
+    m_acceptPos = data.size();
+    data += std::string(ACCEPT_KEY_LENGTH, ' ') + "\r\n";
+    data += "Sec-WebSocket-Version: " WS_VERSION "\r\n\r\n";
+
+    m_data.assign(data.begin(), data.end());
+}
+
+bool HandshakeResponse::Build(const char* key, size_t length)
+{
+    if (m_data.empty())
+    {
+        return false;
+    }
+
+    char accept[ACCEPT_KEY_LENGTH];
+    if (ComputeAcceptKey(key, length, accept) == false)
+    {
+        return false;
+    }
+    memcpy(m_data.data() + m_acceptPos, accept, ACCEPT_KEY_LENGTH);
+
+    char date[FileSystem::DATE_TIME_LENGTH + 1];
+    if (FileSystem::GetDateTime(date, sizeof(date)) != FileSystem::DATE_TIME_LENGTH)
+    {
+        return false;
+    }
+    memcpy(m_data.data() + m_datePos, date, FileSystem::DATE_TIME_LENGTH);
+
+    return true;
+}
+
+bool HandshakeResponse::Build(const std::string& key)
+{
+    return Build(key.data(), key.size());
+}
+
+ByteArray& HandshakeResponse::GetData()
+{
+    return m_data;
+}
+
+bool HandshakeResponse::ComputeAcceptKey(const char* key, size_t length, char* out)
+{
+    static const size_t tokenLength = sizeof(WEBSOCKET_KEY_TOKEN) - 1;
+
+    if (length > MAX_KEY_LENGTH)
+    {
+        return false;
+    }
+
+    uint8_t buffer[MAX_KEY_LENGTH + tokenLength];
+    memcpy(buffer, key, length);
+    memcpy(buffer + length, WEBSOCKET_KEY_TOKEN, tokenLength);
+
+    uint8_t digest[Data::SHA1_DIGEST_LENGTH];
+    SHA1::digest(buffer, length + tokenLength, digest);
+    Data::Base64Encode(digest, Data::SHA1_DIGEST_LENGTH, out);
+
+    return true;
+}
@@ -1,9 +1,85 @@
 #include "Header.h"
 
+#include <cstdint>
+
 #include "common.h"
 
 using namespace WebSocketCpp;
 
+constexpr size_t Header::HEADER_TYPE_COUNT;
+
+namespace
+{
+
+constexpr size_t INTERN_TABLE_SIZE = 256; // power of two, well above the count of the known headers
+
+inline char ToLowerAscii(char ch)
+{
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch | 0x20) : ch;
+}
+
+inline uint32_t HashNoCase(const char* str, size_t length)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<uint8_t>(ToLowerAscii(str[i]));
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+inline bool EqualsNoCase(const char* str1, const char* str2, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (ToLowerAscii(str1[i]) != ToLowerAscii(str2[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Open addressing table of the known header names built once on the first use,
+ * so a name coming from the wire is resolved without allocations
+ */
+struct InternTable
+{
+    Header::HeaderType slots[INTERN_TABLE_SIZE];
+    std::string        names[Header::HEADER_TYPE_COUNT];
+
+    InternTable()
+    {
+        for (auto& slot : slots)
+        {
+            slot = Header::HeaderType::Undefined;
+        }
+
+        for (size_t i = 1; i < Header::HEADER_TYPE_COUNT; i++)
+        {
+            names[i]    = Header::HeaderType2String(static_cast<Header::HeaderType>(i));
+            size_t slot = HashNoCase(names[i].data(), names[i].size()) & (INTERN_TABLE_SIZE - 1);
+            while (slots[slot] != Header::HeaderType::Undefined)
+            {
+                slot = (slot + 1) & (INTERN_TABLE_SIZE - 1);
+            }
+            slots[slot] = static_cast<Header::HeaderType>(i);
+        }
+    }
+};
+
+const InternTable& GetInternTable()
+{
+    static const InternTable table;
+    return table;
+}
+
+} // namespace
+
 Header::Header()
 {
 }
@@ -24,177 +100,39 @@ Header::HeaderType Header::getType() const
     return m_type;
 }
 
-std::string Header::getName() const
+const std::string& Header::getName() const
 {
     return m_name;
 }
 
-std::string Header::getValue() const
+const std::string& Header::getValue() const
 {
     return m_value;
 }
 
-Header::HeaderType Header::String2HeaderType(const std::string& str)
+Header::HeaderType Header::Intern(const char* name, size_t length)
 {
-    switch (_(str.c_str()))
-    {
-        case _("Accept"):
-            return Header::HeaderType::Accept;
-        case _("Accept-Charset"):
-            return Header::HeaderType::AcceptCharset;
-        case _("Accept-Encoding"):
-            return Header::HeaderType::AcceptEncoding;
-        case _("Accept-Datetime"):
-            return Header::HeaderType::AcceptDatetime;
-        case _("Accept-Language"):
-            return Header::HeaderType::AcceptLanguage;
-        case _("Authorization"):
-            return Header::HeaderType::Authorization;
-        case _("Cache-Control"):
-            return Header::HeaderType::CacheControl;
-        case _("Connection"):
-            return Header::HeaderType::Connection;
-        case _("Content-Encoding"):
-            return Header::HeaderType::ContentEncoding;
-        case _("Content-Length"):
-            return Header::HeaderType::ContentLength;
-        case _("Content-MD5"):
-            return Header::HeaderType::ContentMD5;
-        case _("Content-Type"):
-            return Header::HeaderType::ContentType;
-        case _("Cookie"):
-            return Header::HeaderType::Cookie;
-        case _("Date"):
-            return Header::HeaderType::Date;
-        case _("Expect"):
-            return Header::HeaderType::Expect;
-        case _("Forwarded"):
-            return Header::HeaderType::Forwarded;
-        case _("From"):
-            return Header::HeaderType::From;
-        case _("HTTP2-Settings"):
-            return Header::HeaderType::HTTP2Settings;
-        case _("Host"):
-            return Header::HeaderType::Host;
-        case _("If-Match"):
-            return Header::HeaderType::IfMatch;
-        case _("If-Modified-Since"):
-            return Header::HeaderType::IfModifiedSince;
-        case _("If-None-Match"):
-            return Header::HeaderType::IfNoneMatch;
-        case _("If-Range"):
-            return Header::HeaderType::IfRange;
-        case _("If-Unmodified-Since"):
-            return Header::HeaderType::IfUnmodifiedSince;
-        case _("Max-Forwards"):
-            return Header::HeaderType::MaxForwards;
-        case _("Origin"):
-            return Header::HeaderType::Origin;
-        case _("Pragma"):
-            return Header::HeaderType::Pragma;
-        case _("Prefer"):
-            return Header::HeaderType::Prefer;
-        case _("Proxy-Authorization"):
-            return Header::HeaderType::ProxyAuthorization;
-        case _("Range"):
-            return Header::HeaderType::Range;
-        case _("Referer"):
-            return Header::HeaderType::Referer;
-        case _("TE"):
-            return Header::HeaderType::TE;
-        case _("Trailer"):
-            return Header::HeaderType::Trailer;
-        case _("TransferEncoding"):
-            return Header::HeaderType::TransferEncoding;
-        case _("User-Agent"):
-            return Header::HeaderType::UserAgent;
-        case _("Upgrade"):
-            return Header::HeaderType::Upgrade;
-        case _("Via"):
-            return Header::HeaderType::Via;
-        case _("Warning"):
-            return Header::HeaderType::Warning;
-
-        case _("Accept-CH"):
-            return HeaderType::AcceptCH;
-        case _("Access-Control-Allow-Origin"):
-            return HeaderType::AccessControlAllowOrigin;
-        case _("Access-Control-Allow-Credential"):
-            return HeaderType::AccessControlAllowCredentials;
-        case _("Access-Control-Expose-Headers"):
-            return HeaderType::AccessControlExposeHeaders;
-        case _("Access-Control-Max-Age"):
-            return HeaderType::AccessControlMaxAge;
-        case _("Access-Control-Allow-Methods"):
-            return HeaderType::AccessControlAllowMethods;
-        case _("Access-Control-Allow-Headers"):
-            return HeaderType::AccessControlAllowHeaders;
-        case _("Accept-Patch"):
-            return HeaderType::AcceptPatch;
-        case _("Accept-Ranges"):
-            return HeaderType::AcceptRanges;
-        case _("Age"):
-            return HeaderType::Age;
-        case _("Allow"):
-            return HeaderType::Allow;
-        case _("Alt-Svc"):
-            return HeaderType::AltSvc;
-        case _("Content-Disposition"):
-            return HeaderType::ContentDisposition;
-        case _("Content-Language"):
-            return HeaderType::ContentLanguage;
-        case _("Content-Location"):
-            return HeaderType::ContentLocation;
-        case _("Content-Range"):
-            return HeaderType::ContentRange;
-        case _("Delta-Base"):
-            return HeaderType::DeltaBase;
-        case _("ETag"):
-            return HeaderType::ETag;
-        case _("Expires"):
-            return HeaderType::Expires;
-        case _("IM"):
-            return HeaderType::IM;
-        case _("Last-Modified"):
-            return HeaderType::LastModified;
-        case _("Link"):
-            return HeaderType::Link;
-        case _("Location"):
-            return HeaderType::Location;
-        case _("P3P"):
-            return HeaderType::P3P;
-        case _("Preference-Applied"):
-            return HeaderType::PreferenceApplied;
-        case _("Proxy-Authenticate"):
-            return HeaderType::ProxyAuthenticate;
-        case _("Public-Key-Pins"):
-            return HeaderType::PublicKeyPins;
-        case _("Retry-After"):
-            return HeaderType::RetryAfter;
-        case _("Server"):
-            return HeaderType::Server;
-        case _("Set-Cookie"):
-            return HeaderType::SetCookie;
-        case _("Strict-Transport-Security"):
-            return HeaderType::StrictTransportSecurity;
-        case _("Transfer-Encoding"):
-            return HeaderType::TransferEncoding;
-        case _("Tk"):
-            return HeaderType::Tk;
-        case _("Vary"):
-            return HeaderType::Vary;
-        case _("WWW-Authenticate"):
-            return HeaderType::WWWAuthenticate;
-        case _("X-Frame-Options"):
-            return HeaderType::XFrameOptions;
+    const InternTable& table = GetInternTable();
 
-        default:
-            break;
+    size_t slot = HashNoCase(name, length) & (INTERN_TABLE_SIZE - 1);
+    while (table.slots[slot] != Header::HeaderType::Undefined)
+    {
+        const std::string& candidate = table.names[static_cast<size_t>(table.slots[slot])];
+        if (candidate.size() == length && EqualsNoCase(candidate.data(), name, length))
+        {
+            return table.slots[slot];
+        }
+        slot = (slot + 1) & (INTERN_TABLE_SIZE - 1);
     }
 
     return Header::HeaderType::Undefined;
 }
 
+Header::HeaderType Header::String2HeaderType(const std::string& str)
+{
+    return Intern(str.data(), str.size());
+}
+
 std::string Header::HeaderType2String(Header::HeaderType headerType)
 {
     switch (headerType)
@@ -346,6 +284,17 @@ std::string Header::HeaderType2String(Header::HeaderType headerType)
             return "WWW-Authenticate";
         case HeaderType::XFrameOptions:
             return "X-Frame-Options";
+
+        case HeaderType::SecWebSocketKey:
+            return "Sec-WebSocket-Key";
+        case HeaderType::SecWebSocketAccept:
+            return "Sec-WebSocket-Accept";
+        case HeaderType::SecWebSocketVersion:
+            return "Sec-WebSocket-Version";
+        case HeaderType::SecWebSocketProtocol:
+            return "Sec-WebSocket-Protocol";
+        case HeaderType::SecWebSocketExtensions:
+            return "Sec-WebSocket-Extensions";
         default:
             break;
     }
@@ -1,28 +1,50 @@
 #include "HttpHeader.h"
 
+#include <cstring>
+
 #include "StringUtil.h"
 #include "common.h"
 
 using namespace WebSocketCpp;
 
+static inline bool IsBlank(char ch)
+{
+    return ch == ' ' || ch == '\t';
+}
+
 HttpHeader::HttpHeader(Header::HeaderRole role)
     : m_role(role)
 {
+    m_index.fill(-1);
 }
 
 bool HttpHeader::Parse(const ByteArray& data, size_t start)
 {
-    m_complete = false;
+    if (m_complete)
+    {
+        return true;
+    }
 
-    size_t pos = StringUtil::SearchPosition(data, {CRLFCRLF}, start);
-    if (pos != SIZE_MAX)
+    // the lines parsed by the previous calls are kept, only the new bytes are scanned
+    if (start != m_parseStart)
     {
-        auto arr = StringUtil::Split(data, {CRLF}, start, pos);
-        if (ParseHeaders(data, arr))
-        {
-            m_headerSize = pos - start;
-            m_complete   = true;
-        }
+        m_tokenizer.Reset(start);
+        m_parseStart = start;
+        m_lineCount  = 0;
+    }
+
+    m_lines.clear();
+    size_t pos = m_tokenizer.Next(data, m_lines);
+    if (!m_lines.empty())
+    {
+        ParseHeaders(data, m_lines);
+        m_lineCount += m_lines.size();
+    }
+
+    if (pos != SIZE_MAX && m_lineCount > 0)
+    {
+        m_headerSize = pos - 2 - start; // up to the CRLFCRLF
+        m_complete   = true;
     }
 
     return m_complete;
@@ -36,13 +58,22 @@ bool HttpHeader::ParseHeader(const ByteArray& data)
 
 ByteArray HttpHeader::ToByteArray() const
 {
-    std::string headers;
-    for (auto const& header : m_headers)
+    ByteArray headers;
+    headers.reserve(m_raw.size() + m_fields.size() * 4); // name + ": " + value + CRLF
+
+    for (auto const& field : m_fields)
     {
-        headers += header.getName() + ": " + header.getValue() + CR + LF;
+        const char* name  = m_raw.data() + field.nameStart;
+        const char* value = m_raw.data() + field.valueStart;
+        headers.insert(headers.end(), name, name + field.nameLength);
+        headers.push_back(':');
+        headers.push_back(' ');
+        headers.insert(headers.end(), value, value + field.valueLength);
+        headers.push_back(CR);
+        headers.push_back(LF);
     }
 
-    return ByteArray(headers.begin(), headers.end());
+    return headers;
 }
 
 bool HttpHeader::IsComplete() const
@@ -101,30 +132,51 @@ void HttpHeader::SetVersion(const std::string& version)
 
 bool HttpHeader::ParseHeaders(const ByteArray& data, const StringUtil::Ranges& ranges)
 {
-    bool statusLineParsed = false;
-
     if (ranges.empty())
     {
         return false;
     }
 
+    const char* begin = reinterpret_cast<const char*>(data.data());
     for (auto& range : ranges)
     {
-        auto headerDelimiter = StringUtil::SearchPosition(data, {':'}, range.start, range.end);
-        if (headerDelimiter != SIZE_MAX)
+        const char* lineStart = begin + range.start;
+        const char* lineEnd   = begin + range.end + 1;
+        const char* delimiter = static_cast<const char*>(memchr(lineStart, ':', lineEnd - lineStart));
+        if (delimiter == nullptr)
         {
-            std::string name  = std::string(data.begin() + range.start, data.begin() + headerDelimiter);
-            std::string value = std::string(data.begin() + headerDelimiter + 1, data.begin() + range.end + 1);
-            StringUtil::Trim(name);
-            StringUtil::Trim(value);
+            continue;
+        }
 
-            if (name.empty())
-            {
-                continue;
-            }
+        const char* nameStart  = lineStart;
+        const char* nameEnd    = delimiter;
+        const char* valueStart = delimiter + 1;
+        const char* valueEnd   = lineEnd;
+        while (nameStart < nameEnd && IsBlank(*nameStart))
+        {
+            nameStart++;
+        }
+        while (nameEnd > nameStart && IsBlank(*(nameEnd - 1)))
+        {
+            nameEnd--;
+        }
+        while (valueStart < valueEnd && IsBlank(*valueStart))
+        {
+            valueStart++;
+        }
+        while (valueEnd > valueStart && IsBlank(*(valueEnd - 1)))
+        {
+            valueEnd--;
+        }
 
-            SetHeader(name, value);
+        if (nameStart == nameEnd)
+        {
+            continue;
         }
+
+        // repeated fields are kept, the lookup by type returns the last one
+        size_t nameLength = nameEnd - nameStart;
+        AddField(Header::Intern(nameStart, nameLength), nameStart, nameLength, valueStart, valueEnd - valueStart);
     }
 
     return true;
@@ -132,71 +184,164 @@ bool HttpHeader::ParseHeaders(const ByteArray& data, const StringUtil::Ranges& r
 
 std::string HttpHeader::ToString() const
 {
-    return "Header (" + std::to_string(m_headers.size()) + " records, ver. " + m_version + ", size: " + std::to_string(m_headerSize) + ")";
+    return "Header (" + std::to_string(m_fields.size()) + " records, ver. " + m_version + ", size: " + std::to_string(m_headerSize) + ")";
 }
 
-const std::vector<Header>& HttpHeader::GetHeaders() const
+std::vector<Header> HttpHeader::GetHeaders() const
 {
-    return m_headers;
+    std::vector<Header> headers;
+    headers.reserve(m_fields.size());
+    for (auto const& field : m_fields)
+    {
+        headers.emplace_back(field.type, m_raw.substr(field.nameStart, field.nameLength), m_raw.substr(field.valueStart, field.valueLength));
+    }
+
+    return headers;
 }
 
 void HttpHeader::SetHeader(Header::HeaderType type, const std::string& value)
 {
-    SetHeader(Header::HeaderType2String(type), value);
+    std::string name = Header::HeaderType2String(type);
+    SetField(type, name.data(), name.size(), value.data(), value.size());
 }
 
 void HttpHeader::SetHeader(const std::string& name, const std::string& value)
 {
-    for (auto& header : m_headers)
+    SetField(Header::Intern(name.data(), name.size()), name.data(), name.size(), value.data(), value.size());
+}
+
+int HttpHeader::FindField(Header::HeaderType type, const char* name, size_t length) const
+{
+    if (type != Header::HeaderType::Undefined)
     {
-        if (StringUtil::Compare(header.getName(), name))
+        return m_index[static_cast<size_t>(type)];
+    }
+
+    for (size_t i = m_fields.size(); i-- > 0;)
+    {
+        const Field& field = m_fields[i];
+        if (field.type == Header::HeaderType::Undefined && StringUtil::Compare(m_raw.data() + field.nameStart, field.nameLength, name, length))
         {
-            header.getValue() = value;
-            return;
+            return static_cast<int>(i);
         }
     }
 
-    m_headers.emplace_back(Header::String2HeaderType(name), name, value);
+    return -1;
+}
+
+void HttpHeader::AddField(Header::HeaderType type, const char* name, size_t nameLength, const char* value, size_t valueLength)
+{
+    Field field;
+    field.type        = type;
+    field.nameStart   = m_raw.size();
+    field.nameLength  = nameLength;
+    field.valueStart  = field.nameStart + nameLength;
+    field.valueLength = valueLength;
+
+    m_raw.append(name, nameLength);
+    m_raw.append(value, valueLength);
+
+    if (type != Header::HeaderType::Undefined)
+    {
+        m_index[static_cast<size_t>(type)] = static_cast<int>(m_fields.size());
+    }
+    m_fields.push_back(field);
+}
+
+void HttpHeader::SetField(Header::HeaderType type, const char* name, size_t nameLength, const char* value, size_t valueLength)
+{
+    int index = FindField(type, name, nameLength);
+    if (index == -1)
+    {
+        AddField(type, name, nameLength, value, valueLength);
+        return;
+    }
+
+    Field& field = m_fields[index];
+    if (valueLength > field.valueLength) // doesn't fit, the old value is left unused in the buffer
+    {
+        field.valueStart = m_raw.size();
+        m_raw.append(value, valueLength);
+    }
+    else
+    {
+        m_raw.replace(field.valueStart, valueLength, value, valueLength);
+    }
+    field.valueLength = valueLength;
 }
 
 void HttpHeader::Clear()
 {
     m_role     = Header::HeaderRole::Undefined;
     m_complete = false;
-    m_headers.clear();
+    m_raw.clear();
+    m_fields.clear();
+    m_index.fill(-1);
     m_version       = "HTTP/1.1";
     m_headerSize    = 0;
     m_remoteAddress = "";
     m_remotePort    = (-1);
     m_chunkedSize   = 0;
+    m_parseStart    = SIZE_MAX;
+    m_lineCount     = 0;
 }
 
 std::string HttpHeader::GetHeader(Header::HeaderType headerType) const
 {
-    return GetHeader(Header::HeaderType2String(headerType));
+    size_t      size;
+    const char* value = FindHeader(headerType, size);
+    return value == nullptr ? std::string() : std::string(value, size);
 }
 
 std::string HttpHeader::GetHeader(const std::string& headerType) const
 {
-    for (auto& header : m_headers)
+    int index = FindField(Header::Intern(headerType.data(), headerType.size()), headerType.data(), headerType.size());
+    if (index == -1)
     {
-        if (StringUtil::Compare(header.getName(), headerType))
-        {
-            return header.getValue();
-        }
+        return "";
+    }
+
+    return m_raw.substr(m_fields[index].valueStart, m_fields[index].valueLength);
+}
+
+const char* HttpHeader::FindHeader(Header::HeaderType headerType, size_t& size) const
+{
+    if (headerType == Header::HeaderType::Undefined)
+    {
+        return nullptr;
     }
 
-    return "";
+    int index = m_index[static_cast<size_t>(headerType)];
+    if (index == -1)
+    {
+        return nullptr;
+    }
+
+    size = m_fields[index].valueLength;
+    return m_raw.data() + m_fields[index].valueStart;
+}
+
+bool HttpHeader::HasHeader(Header::HeaderType headerType) const
+{
+    size_t size;
+    return FindHeader(headerType, size) != nullptr;
+}
+
+bool HttpHeader::CompareHeader(Header::HeaderType headerType, const std::string& value) const
+{
+    size_t      size;
+    const char* str = FindHeader(headerType, size);
+    return str != nullptr && StringUtil::Compare(str, size, value.data(), value.size());
 }
 
 std::vector<std::string> HttpHeader::GetAllHeaders(const std::string& headerType) const
 {
     std::vector<std::string> value;
-    for (auto& header : m_headers)
+    for (auto& field : m_fields)
     {
-        if (header.getName() == headerType)
+        if (StringUtil::Compare(m_raw.data() + field.nameStart, field.nameLength, headerType.data(), headerType.size()))
         {
-            value.push_back(header.getValue());
+            value.push_back(m_raw.substr(field.valueStart, field.valueLength));
         }
     }
 
@@ -244,5 +389,5 @@ int HttpHeader::GetRemotePort() const
 
 size_t HttpHeader::GetCount() const
 {
-    return m_headers.size();
+    return m_fields.size();
 }
@@ -1,5 +1,7 @@
 #include "Request.h"
 
+#include "Route.h"
+
 #define EOL_LENGTH             2
 #define ENTRY_DELIMITER_LENGTH 4
 
@@ -14,53 +16,76 @@ bool Request::Parse(const ByteArray& data)
 {
     ClearError();
 
-    if (m_requestLineLength == 0)
+    // the data is expected to grow between the calls, every stage continues from where it stopped
+    if (m_parseState == ParseState::RequestLine)
     {
-        if (ParseRequestLine(data, m_requestLineLength) == false)
+        size_t pos = StringUtil::SearchPosition(data, {CR, LF}, m_scanPos > 0 ? m_scanPos - 1 : 0);
+        if (pos == SIZE_MAX)
+        {
+            m_scanPos = data.size();
+            SetLastError("Request: request line is incomplete");
+            return false;
+        }
+
+        if (ParseRequestLine(data, pos) == false)
         {
-            m_requestLineLength = 0; // reset so the next call retries
+            m_parseState = ParseState::Error;
             SetLastError("Request: error parsing request line: " + GetLastError());
             return false;
         }
+
+        m_requestLineLength = pos;
+        m_parseState        = ParseState::Header;
     }
-    if (m_header.IsComplete() == false)
+
+    if (m_parseState == ParseState::Header)
     {
         if (m_header.Parse(data, m_requestLineLength + EOL_LENGTH) == false)
         {
             SetLastError("Request: error parsing header: " + GetLastError());
             return false;
         }
+
+        m_parseState = ParseState::Complete;
+    }
+
+    if (m_parseState == ParseState::Error)
+    {
+        SetLastError("Request: request is malformed");
+        return false;
     }
 
     return true;
 }
 
-bool Request::ParseRequestLine(const ByteArray& data, size_t& pos)
+Request::ParseState Request::GetParseState() const
+{
+    return m_parseState;
+}
+
+bool Request::ParseRequestLine(const ByteArray& data, size_t pos)
 {
-    pos = StringUtil::SearchPosition(data, {CR, LF});
-    if (pos != SIZE_MAX) // request line presents
+    auto ranges = StringUtil::Split(data, {' '}, 0, pos);
+    if (ranges.size() == 3)
     {
-        auto ranges = StringUtil::Split(data, {' '}, 0, pos);
-        if (ranges.size() == 3)
+        m_method = String2Method(std::string(data.begin() + ranges[0].start, data.begin() + ranges[0].end + 1));
+        if (m_method == Method::Undefined)
         {
-            m_method = String2Method(std::string(data.begin() + ranges[0].start, data.begin() + ranges[0].end + 1));
-            if (m_method == Method::Undefined)
-            {
-                SetLastError("wrong method");
-                return false;
-            }
-            m_url.Parse(std::string(data.begin() + ranges[1].start, data.begin() + ranges[1].end + 1), false);
-            if (m_url.IsInitiaized() == false)
-            {
-                SetLastError("wrong URL");
-                return false;
-            }
-            m_httpVersion = std::string(data.begin() + ranges[2].start, data.begin() + ranges[2].end + 1);
-            StringUtil::Trim(m_httpVersion);
-            return true;
+            SetLastError("wrong method");
+            return false;
         }
+        m_url.Parse(std::string(data.begin() + ranges[1].start, data.begin() + ranges[1].end + 1), false);
+        if (m_url.IsInitiaized() == false)
+        {
+            SetLastError("wrong URL");
+            return false;
+        }
+        m_httpVersion = std::string(data.begin() + ranges[2].start, data.begin() + ranges[2].end + 1);
+        StringUtil::Trim(m_httpVersion);
+        return true;
     }
 
+    SetLastError("wrong request line");
     return false;
 }
 
@@ -114,9 +139,15 @@ void Request::SetArg(const std::string& name, const std::string& value)
     m_args[name] = value;
 }
 
+void Request::SetRouteArgs(const std::string* path, const RouteArgs* args)
+{
+    m_routePath = path;
+    m_routeArgs = (path != nullptr) ? args : nullptr;
+}
+
 Protocol Request::GetProtocol() const
 {
-    if (StringUtil::Compare(m_header.GetHeader(Header::HeaderType::Upgrade), "websocket"))
+    if (m_header.CompareHeader(Header::HeaderType::Upgrade, "websocket"))
     {
         return Protocol::WS;
     }
@@ -195,11 +226,15 @@ void Request::Clear()
     m_method            = Method::Undefined;
     m_httpVersion       = "HTTP/1.1";
     m_requestLineLength = 0;
+    m_parseState        = ParseState::RequestLine;
+    m_scanPos           = 0;
     m_remote            = "";
     m_session           = nullptr;
     m_url.Clear();
     m_header.Clear();
     m_args.clear();
+    m_routePath = nullptr;
+    m_routeArgs = nullptr;
 }
 
 void Request::SetSession(Session* session)
@@ -222,15 +257,7 @@ ByteArray Request::BuildRequestLine() const
 
 ByteArray Request::BuildHeaders() const
 {
-    auto& header = GetHeader();
-
-    std::string headers;
-    for (auto& entry : header.GetHeaders())
-    {
-        headers += entry.getName() + ": " + entry.getValue() + CR + LF;
-    }
-
-    return ByteArray(headers.begin(), headers.end());
+    return m_header.ToByteArray();
 }
 
 std::string Request::ToString() const
@@ -240,6 +267,18 @@ std::string Request::ToString() const
 
 std::string Request::GetArg(const std::string& name) const
 {
+    if (m_routeArgs != nullptr)
+    {
+        for (size_t i = 0; i < m_routeArgs->count; i++)
+        {
+            auto& arg = m_routeArgs->args[i];
+            if (*arg.name == name)
+            {
+                return m_routePath->substr(arg.start, arg.length);
+            }
+        }
+    }
+
     auto it = m_args.find(name);
     return (it != m_args.end()) ? it->second : "";
 }
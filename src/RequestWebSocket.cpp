@@ -1,10 +1,7 @@
 #include "RequestWebSocket.h"
 
-#include <cstring>
-#include <limits>
-
 #include "Config.h"
-#include "StringUtil.h"
+#include "FrameCodec.h"
 
 using namespace WebSocketCpp;
 
@@ -14,127 +11,43 @@ RequestWebSocket::RequestWebSocket()
 
 bool RequestWebSocket::Parse(const ByteArray& data)
 {
-    bool retval = false;
+    FrameHeader header;
+    if (ServerFrameCodec::ParseHeader(data.data(), data.size(), header) != ServerFrameCodec::Result::Ok)
+    {
+        return false;
+    }
+    m_messageType = static_cast<MessageType>(header.opcode);
 
-    WebSocketHeader header;
-    size_t          dataSize   = data.size();
-    size_t          headerSize = sizeof(WebSocketHeader);
+    const Config& config = Config::Instance();
+    if (header.payloadSize > config.GetMaxFrameSize())
+    {
+        return false;
+    }
 
-    if (dataSize >= headerSize)
+    if (m_data.size() + header.payloadSize > config.GetMaxMessageSize())
     {
-        std::memcpy(&header, data.data(), headerSize);
-        m_messageType = static_cast<MessageType>(header.flags1.opcode);
-
-        uint64_t payloadSize    = 0;
-        size_t   sizeHeaderSize = 0;
-        switch (header.flags2.PayloadLen)
-        {
-            case 126:
-                sizeHeaderSize = sizeof(WebSocketHeaderLength2);
-                if (dataSize >= headerSize + sizeHeaderSize)
-                {
-                    WebSocketHeaderLength2 length;
-                    const uint8_t*         ptr = data.data() + headerSize;
-                    length.length.bytes[0]     = *(ptr + 1);
-                    length.length.bytes[1]     = *ptr;
-                    payloadSize                = length.length.value;
-                }
-                else
-                {
-                    return false;
-                }
-                break;
-            case 127:
-                sizeHeaderSize = sizeof(WebSocketHeaderLength3);
-                if (dataSize >= headerSize + sizeHeaderSize)
-                {
-                    WebSocketHeaderLength3 length;
-                    const uint8_t*         ptr = data.data() + headerSize;
-                    for (int i = 0; i < 8; i++)
-                    {
-                        length.length.bytes[i] = *(ptr + 7 - i);
-                    }
-                    payloadSize = length.length.value;
-                }
-                else
-                {
-                    return false;
-                }
-                break;
-            default:
-                payloadSize = header.flags2.PayloadLen;
-                break;
-        }
-
-        const Config& config = Config::Instance();
-        if (payloadSize > 0)
-        {
-            if (payloadSize > config.GetMaxFrameSize())
-            {
-                return false;
-            }
-
-            if (m_data.size() + payloadSize > config.GetMaxMessageSize())
-            {
-                return false;
-            }
-
-            size_t              maskHeaderSize = 0;
-            WebSocketHeaderMask mask;
-            size_t              headers_size = headerSize + sizeHeaderSize;
-
-            if (headers_size > SIZE_MAX - payloadSize)
-            {
-                return false;
-            }
-
-            if (header.flags2.Mask == 1)
-            {
-                maskHeaderSize = sizeof(WebSocketHeaderMask);
-                headers_size += maskHeaderSize;
-                if (dataSize >= headers_size)
-                {
-                    std::memcpy(&mask, data.data() + headerSize + sizeHeaderSize, maskHeaderSize);
-                }
-                else
-                {
-                    return false;
-                }
-            }
-
-            size_t messageFullSize = headers_size + payloadSize;
-            if (dataSize >= messageFullSize)
-            {
-                // according to rfc6455#section-5.3 server must ignore unmasked data
-                // but anyway we support such non-standard clients
-                if (header.flags2.Mask == 1)
-                {
-                    ByteArray encoded(payloadSize);
-                    for (size_t i = 0; i < payloadSize; i++)
-                    {
-                        encoded[i] = data[headers_size + i] ^ mask.bytes[i % 4];
-                    }
-                    m_data.insert(m_data.end(), encoded.begin(), encoded.end());
-                }
-                else
-                {
-                    m_data.insert(m_data.end(),
-                        data.begin() + headers_size,
-                        data.begin() + messageFullSize);
-                }
-
-                if (header.flags1.FIN == 1)
-                {
-                    m_final = true;
-                    retval  = true;
-                }
-
-                m_size = messageFullSize;
-            }
-        }
+        return false;
+    }
+
+    if (data.size() < ServerFrameCodec::FrameSize(header))
+    {
+        return false;
+    }
+
+    // according to rfc6455#section-5.3 server must ignore unmasked data
+    // but anyway we support such non-standard clients
+    size_t offset = m_data.size();
+    m_data.resize(offset + static_cast<size_t>(header.payloadSize));
+    ServerFrameCodec::DecodePayload(header, data.data(), m_data.data() + offset);
+
+    m_size = static_cast<size_t>(ServerFrameCodec::FrameSize(header));
+    if (header.fin)
+    {
+        m_final = true;
+        return true;
     }
 
-    return retval;
+    return false;
 }
 
 bool RequestWebSocket::IsFinal() const
@@ -171,74 +84,9 @@ bool RequestWebSocket::Send(CommunicationClientBase* communication) const
 {
     try
     {
-        ByteArray response;
-
-        WebSocketHeader header = {};
-        header.flags1.FIN      = 1;
-        header.flags1.opcode   = static_cast<uint8_t>(m_messageType);
-        header.flags2.Mask     = 1;
-        size_t dataSize        = m_data.size();
-
-        if (dataSize < 126)
-        {
-            header.flags2.PayloadLen = static_cast<uint8_t>(dataSize & 0xFF);
-        }
-        else
-        {
-            if (dataSize <= std::numeric_limits<uint16_t>::max())
-            {
-                header.flags2.PayloadLen = 126;
-            }
-            else
-            {
-                header.flags2.PayloadLen = 127;
-            }
-        }
-
-        auto const ptr = reinterpret_cast<char*>(&header);
-        ByteArray  buffer(ptr, ptr + sizeof(header));
-        response.insert(response.end(), buffer.begin(), buffer.end());
-
-        if (dataSize >= 126 && dataSize <= std::numeric_limits<uint16_t>::max())
-        {
-            WebSocketHeaderLength2 lengthHeader = {};
-            lengthHeader.length.value           = dataSize;
-            ByteArray buffer(sizeof(lengthHeader));
-            buffer[0] = lengthHeader.length.bytes[1];
-            buffer[1] = lengthHeader.length.bytes[0];
-            response.insert(response.end(), buffer.begin(), buffer.end());
-        }
-        else if (dataSize > std::numeric_limits<uint16_t>::max())
-        {
-            WebSocketHeaderLength3 lengthHeader = {};
-            lengthHeader.length.value           = dataSize;
-            ByteArray buffer(sizeof(lengthHeader));
-            for (int i = 0; i < 8; i++)
-            {
-                buffer[i] = lengthHeader.length.bytes[7 - i];
-            }
-            response.insert(response.end(), buffer.begin(), buffer.end());
-        }
-
-        StringUtil::RandInit();
-        WebSocketHeaderMask mask;
-        ByteArray           maskBuffer;
-        for (auto i = 0; i < 4; i++)
-        {
-            mask.bytes[i] = StringUtil::GetRand(0, 0xFF);
-            maskBuffer.push_back(mask.bytes[i]);
-        }
-        response.insert(response.end(), maskBuffer.begin(), maskBuffer.end());
-
-        ByteArray encoded(m_data.size());
-        for (auto i = 0; i < dataSize; i++)
-        {
-            encoded[i] = m_data[i] ^ mask.bytes[i % 4];
-        }
-
-        response.insert(response.end(), encoded.begin(), encoded.end());
-
-        communication->Write(response);
+        ByteArray frame;
+        ClientFrameCodec::Encode(frame, m_messageType, m_data.data(), m_data.size());
+        communication->Write(frame);
 
         return true;
     }
@@ -216,32 +216,44 @@ bool Response::Send(CommunicationServerBase* communication)
 bool Response::Parse(const ByteArray& data, size_t* all, size_t* downoaded)
 {
     ClearError();
-    size_t pos;
 
-    // check the header is completed
-    pos = StringUtil::SearchPosition(data, {CRLFCRLF});
-    if (pos == SIZE_MAX)
+    // the data is expected to grow between the calls, every stage continues from where it stopped
+    if (m_parseState == ParseState::StatusLine)
     {
-        SetLastError("header is incomplete");
-        return false;
-    }
+        size_t pos = StringUtil::SearchPosition(data, {CR, LF}, m_scanPos > 0 ? m_scanPos - 1 : 0);
+        if (pos == SIZE_MAX)
+        {
+            m_scanPos = data.size();
+            SetLastError("status line is incomplete");
+            return false;
+        }
 
-    m_response_size = pos + 4;
+        if (ParseStatusLine(data, pos) == false)
+        {
+            m_parseState = ParseState::Error;
+            SetLastError("error parsing status line: " + GetLastError());
+            return false;
+        }
 
-    if (ParseStatusLine(data, pos) == false)
-    {
-        SetLastError("error parsing status line: " + GetLastError());
-        return false;
+        m_statusLineLength = pos;
+        m_parseState       = ParseState::Header;
     }
 
-    if (m_header.IsComplete() == false)
+    if (m_parseState == ParseState::Header)
     {
-        if (m_header.Parse(data, pos + 2) == false)
+        if (m_header.Parse(data, m_statusLineLength + 2) == false)
         {
-            SetLastError("error parsing headers");
+            SetLastError("header is incomplete");
             return false;
         }
 
+        m_response_size = m_statusLineLength + 2 + m_header.GetHeaderSize() + 4;
+        m_parseState    = ParseState::Body;
+    }
+
+    if (m_parseState == ParseState::Body)
+    {
+        size_t pos     = m_statusLineLength;
         size_t allSize = pos + 2 + m_header.GetRequestSize();
         if (all != nullptr)
         {
@@ -254,13 +266,12 @@ bool Response::Parse(const ByteArray& data, size_t* all, size_t* downoaded)
 
         if (data.size() >= allSize)
         {
-            auto transferEncoding = m_header.GetHeader(Header::HeaderType::TransferEncoding);
-            auto contentEncoding  = String2EncodingType(m_header.GetHeader(Header::HeaderType::ContentEncoding));
+            auto contentEncoding = String2EncodingType(m_header.GetHeader(Header::HeaderType::ContentEncoding));
 
             /* some servers send 'chunked' inside Content-Encoding but according to the
              * https://datatracker.ietf.org/doc/html/rfc2616#section-3.5 it's incorrect
              * and should only be sent in the Transfer-Encoding, so we ignore that here */
-            if (transferEncoding == "chunked")
+            if (m_header.CompareHeader(Header::HeaderType::TransferEncoding, "chunked"))
             {
                 try
                 {
@@ -272,40 +283,50 @@ bool Response::Parse(const ByteArray& data, size_t* all, size_t* downoaded)
                         {
                             if (DecodeBody(contentEncoding, m_body, 0) == false)
                             {
+                                m_parseState = ParseState::Error;
                                 return false;
                             }
                         }
 
                         m_header.SetChunckedSize(m_body.size());
-
-                        return true;
+                        m_parseState = ParseState::Complete;
                     }
                 }
                 catch (...)
                 {
+                    m_parseState = ParseState::Error;
                     return false;
                 }
             }
-
             else
             {
-                if (pos + 2 + m_header.GetRequestSize() == data.size())
+                // anything past the body (e.g. a frame sent right after 101) belongs to the caller
+                if (allSize > m_response_size)
                 {
-                    size_t dataStart = pos + 2 + m_header.GetHeaderSize() + 4;
-                    if (data.size() > dataStart)
+                    ByteArray body(data.begin() + m_response_size, data.begin() + allSize);
+                    if (DecodeBody(contentEncoding, body, 0) == false)
                     {
-                        if (DecodeBody(contentEncoding, data, dataStart) == false)
-                        {
-                            return false;
-                        }
+                        m_parseState = ParseState::Error;
+                        return false;
                     }
-                    return true;
                 }
+                m_parseState = ParseState::Complete;
             }
         }
     }
 
-    return false;
+    if (m_parseState == ParseState::Error)
+    {
+        SetLastError("response is malformed");
+        return false;
+    }
+
+    return m_parseState == ParseState::Complete;
+}
+
+Response::ParseState Response::GetParseState() const
+{
+    return m_parseState;
 }
 
 bool Response::DecodeBody(EncodingType type, const ByteArray& data, size_t pos)
@@ -387,9 +408,8 @@ Response::EncodingType Response::String2EncodingType(const std::string& str)
     return Response::EncodingType::Undefined;
 }
 
-bool Response::ParseStatusLine(const ByteArray& data, size_t& pos)
+bool Response::ParseStatusLine(const ByteArray& data, size_t pos)
 {
-    pos = StringUtil::SearchPosition(data, {CR, LF});
     if (pos != SIZE_MAX) // status line presents
     {
         auto ranges = StringUtil::Split(data, {' '}, 0, pos);
@@ -1,9 +1,7 @@
 #include "ResponseWebSocket.h"
 
-#include <cstring>
-#include <limits>
-
-#include "common_ws.h"
+#include "FrameCodec.h"
+#include "Metrics.h"
 
 using namespace WebSocketCpp;
 
@@ -63,58 +61,10 @@ bool ResponseWebSocket::Send(CommunicationServerBase* communication) const
 {
     try
     {
-        ByteArray response;
-
-        WebSocketHeader header = {};
-        header.flags1.FIN      = 1;
-        header.flags1.opcode   = static_cast<uint8_t>(m_messageType);
-        header.flags2.Mask     = 0;
-        size_t dataSize        = m_data.size();
-
-        if (dataSize < 126)
-        {
-            header.flags2.PayloadLen = static_cast<uint8_t>(m_data.size() & 0xFF);
-        }
-        else
-        {
-            if (dataSize <= std::numeric_limits<uint16_t>::max())
-            {
-                header.flags2.PayloadLen = 126;
-            }
-            else
-            {
-                header.flags2.PayloadLen = 127;
-            }
-        }
-
-        auto const ptr = reinterpret_cast<char*>(&header);
-        ByteArray  buffer(ptr, ptr + sizeof(header));
-        response.insert(response.end(), buffer.begin(), buffer.end());
-
-        if (dataSize >= 126 && dataSize <= std::numeric_limits<uint16_t>::max())
-        {
-            WebSocketHeaderLength2 lengthHeader = {};
-            lengthHeader.length.value           = dataSize;
-            ByteArray buffer(sizeof(lengthHeader));
-            buffer[0] = lengthHeader.length.bytes[1];
-            buffer[1] = lengthHeader.length.bytes[0];
-            response.insert(response.end(), buffer.begin(), buffer.end());
-        }
-        else if (dataSize > std::numeric_limits<uint16_t>::max())
-        {
-            WebSocketHeaderLength3 lengthHeader = {};
-            lengthHeader.length.value           = dataSize;
-            ByteArray buffer(sizeof(lengthHeader));
-            for (int i = 0; i < 8; i++)
-            {
-                buffer[i] = lengthHeader.length.bytes[7 - i];
-            }
-            response.insert(response.end(), buffer.begin(), buffer.end());
-        }
-
-        response.insert(response.end(), m_data.begin(), m_data.end());
-
-        communication->Write(m_connID, response);
+        ByteArray frame;
+        ServerFrameCodec::Encode(frame, m_messageType, m_data.data(), m_data.size());
+        communication->Write(m_connID, frame);
+        Metrics::Instance().Add(Metrics::FrameCounter(m_messageType, false));
 
         return true;
     }
@@ -126,39 +76,23 @@ bool ResponseWebSocket::Send(CommunicationServerBase* communication) const
 
 bool ResponseWebSocket::Parse(const ByteArray& data)
 {
-    WebSocketHeader header;
-    const uint8_t*  ptr = data.data();
-    std::memcpy(&header, ptr, sizeof(header));
-    unsigned long long size       = 0;
-    size_t             headerSize = sizeof(header);
-    if (header.flags2.PayloadLen >= 126)
-    {
-        if (header.flags2.PayloadLen == 126)
-        {
-            WebSocketHeaderLength2 lengthHeader;
-            std::memcpy(&lengthHeader, ptr + sizeof(header), sizeof(lengthHeader));
-            headerSize += sizeof(lengthHeader);
-            size = lengthHeader.length.value;
-        }
-        else
-        {
-            WebSocketHeaderLength3 lengthHeader;
-            std::memcpy(&lengthHeader, ptr + sizeof(header), sizeof(lengthHeader));
-            headerSize += sizeof(lengthHeader);
-            size = lengthHeader.length.value;
-        }
-    }
-    else
+    FrameHeader header;
+    if (ClientFrameCodec::ParseHeader(data.data(), data.size(), header) != ClientFrameCodec::Result::Ok)
     {
-        size = header.flags2.PayloadLen;
+        return false;
     }
 
-    if (data.size() >= size + headerSize)
+    if (data.size() < ClientFrameCodec::FrameSize(header))
     {
-        m_size = headerSize + static_cast<size_t>(size);
-        m_data.insert(m_data.end(), data.begin() + headerSize, data.begin() + headerSize + size);
-        return true;
+        return false;
     }
 
-    return false;
+    m_messageType = static_cast<MessageType>(header.opcode);
+    m_size        = static_cast<size_t>(ClientFrameCodec::FrameSize(header));
+
+    size_t offset = m_data.size();
+    m_data.resize(offset + static_cast<size_t>(header.payloadSize));
+    ClientFrameCodec::DecodePayload(header, data.data(), m_data.data() + offset);
+
+    return true;
 }
@@ -6,6 +6,8 @@
 
 using namespace WebSocketCpp;
 
+constexpr size_t RouteArgs::MAX_COUNT;
+
 Route::Route(const std::string& path, Method method, bool useAuth)
     : m_method(method),
       m_path(path),
@@ -19,13 +21,37 @@ const std::string& Route::GetPath() const
     return m_path;
 }
 
+Method Route::GetMethod() const
+{
+    return m_method;
+}
+
 bool Route::IsMatch(Request& request)
 {
-    const std::string path   = request.GetUrl().GetPath();
-    const char*       ch     = path.data();
-    size_t            length = path.length();
+    const std::string path = request.GetUrl().GetPath();
+    RouteArgs         args;
 
-    if (request.GetMethod() != m_method)
+    if (Match(path, request.GetMethod(), args) == false)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < args.count; i++)
+    {
+        request.SetArg(*args.args[i].name, path.substr(args.args[i].start, args.args[i].length));
+    }
+
+    return true;
+}
+
+bool Route::Match(const std::string& path, Method method, RouteArgs& args) const
+{
+    const char* ch     = path.data();
+    size_t      length = path.length();
+
+    args.count = 0;
+
+    if (method != m_method)
     {
         return false;
     }
@@ -51,9 +77,9 @@ bool Route::IsMatch(Request& request)
             {
                 if (nextToken.IsMatch(ch + searchPos, length - searchPos, offset))
                 {
-                    if (nextToken.type == Token::Type::Variable)
+                    if (!Capture(nextToken, searchPos, offset, args))
                     {
-                        request.SetArg(nextToken.text, std::string(ch + searchPos, offset));
+                        return false;
                     }
                     pos   = searchPos + offset;
                     found = true;
@@ -71,9 +97,9 @@ bool Route::IsMatch(Request& request)
 
         if (token.IsMatch(ch + pos, length - pos, offset))
         {
-            if (token.type == Token::Type::Variable)
+            if (!Capture(token, pos, offset, args))
             {
-                request.SetArg(token.text, std::string(ch + pos, offset));
+                return false;
             }
             pos += offset;
         }
@@ -94,11 +120,44 @@ bool Route::IsMatch(Request& request)
     return true;
 }
 
+bool Route::Capture(const Token& token, size_t start, size_t length, RouteArgs& args)
+{
+    if (token.type != Token::Type::Variable)
+    {
+        return true;
+    }
+    if (args.count >= RouteArgs::MAX_COUNT)
+    {
+        return false;
+    }
+
+    args.args[args.count].name   = &token.text;
+    args.args[args.count].start  = start;
+    args.args[args.count].length = length;
+    args.count++;
+    return true;
+}
+
 bool Route::IsUseAuth() const
 {
     return m_useAuth;
 }
 
+bool Route::IsLiteral() const
+{
+    return m_tokens.size() == 1 && m_tokens[0].type == Token::Type::Default && m_tokens[0].optional == false;
+}
+
+std::string Route::GetLiteralPrefix() const
+{
+    if (!m_tokens.empty() && m_tokens[0].type == Token::Type::Default && m_tokens[0].optional == false)
+    {
+        return m_tokens[0].text;
+    }
+
+    return "";
+}
+
 std::string Route::ToString() const
 {
     std::string result = "Route (method: " + Method2String(m_method) +
@@ -290,7 +349,7 @@ bool Route::AddToken(Token& token, const std::string& str)
     return true;
 }
 
-bool Route::Token::IsMatch(const char* ch, size_t length, size_t& pos)
+bool Route::Token::IsMatch(const char* ch, size_t length, size_t& pos) const
 {
     bool retval = false;
 
@@ -0,0 +1,157 @@
+#include "RouteTable.h"
+
+#include <algorithm>
+
+using namespace WebSocketCpp;
+
+RouteTable::RouteTable()
+    : m_nodes(1)
+{
+}
+
+void RouteTable::Add(RoutePtr route)
+{
+    size_t      index  = m_routes.size();
+    std::string prefix = route->GetLiteralPrefix();
+
+    size_t node = 0;
+    for (char ch : prefix)
+    {
+        size_t child = FindChild(node, ch);
+        node         = (child == SIZE_MAX) ? AddChild(node, ch) : child;
+    }
+    m_nodes[node].routes.push_back(index);
+
+    m_routes.push_back(std::move(route));
+}
+
+/*
+ * Puts the route in place of the one registered with the same path,
+ * the position and so the trie stay the same
+ */
+bool RouteTable::Replace(RoutePtr route)
+{
+    for (auto& entry : m_routes)
+    {
+        if (entry->GetPath() == route->GetPath())
+        {
+            entry = std::move(route);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+RouteTable::RoutePtr RouteTable::Find(const std::string& path) const
+{
+    for (auto& route : m_routes)
+    {
+        if (route->GetPath() == path)
+        {
+            return route;
+        }
+    }
+
+    return nullptr;
+}
+
+const RouteWebSocket& RouteTable::Get(size_t index) const
+{
+    return *m_routes[index];
+}
+
+size_t RouteTable::GetCount() const
+{
+    return m_routes.size();
+}
+
+/*
+ * Fills `matches` with the routes matching the request, in the order of registration,
+ * along with the variables each of them captured.
+ */
+bool RouteTable::Match(const Request& request, Matches& matches) const
+{
+    matches.path = request.GetUrl().GetPath();
+    matches.bindings.clear();
+
+    const std::string& path = matches.path;
+
+    // every node passed by the path holds the routes which literal prefix is a prefix of the path
+    std::vector<size_t> candidates;
+    size_t              node  = 0;
+    size_t              depth = 0;
+    while (true)
+    {
+        candidates.insert(candidates.end(), m_nodes[node].routes.begin(), m_nodes[node].routes.end());
+        if (depth == path.size())
+        {
+            break;
+        }
+
+        node = FindChild(node, path[depth]);
+        if (node == SIZE_MAX)
+        {
+            break;
+        }
+        depth++;
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    for (size_t index : candidates)
+    {
+        const RouteWebSocket& route = *m_routes[index];
+        Binding               binding;
+        binding.route = index;
+
+        if (route.IsLiteral())
+        {
+            if (route.GetMethod() != request.GetMethod() || route.GetPath().size() != path.size())
+            {
+                continue;
+            }
+        }
+        else if (route.Match(path, request.GetMethod(), binding.args) == false)
+        {
+            continue;
+        }
+
+        matches.bindings.push_back(binding);
+    }
+
+    return !matches.bindings.empty();
+}
+
+void RouteTable::Clear()
+{
+    m_routes.clear();
+    m_nodes.clear();
+    m_nodes.resize(1);
+}
+
+size_t RouteTable::FindChild(size_t node, char ch) const
+{
+    auto& children = m_nodes[node].children;
+    auto  it       = std::lower_bound(children.begin(), children.end(), ch,
+                                      [](const std::pair<char, size_t>& child, char value) { return child.first < value; });
+    if (it != children.end() && it->first == ch)
+    {
+        return it->second;
+    }
+
+    return SIZE_MAX;
+}
+
+size_t RouteTable::AddChild(size_t node, char ch)
+{
+    size_t child = m_nodes.size();
+    m_nodes.emplace_back();
+
+    auto& children = m_nodes[node].children;
+    auto  it       = std::lower_bound(children.begin(), children.end(), ch,
+                                      [](const std::pair<char, size_t>& child, char value) { return child.first < value; });
+    children.insert(it, std::make_pair(ch, child));
+
+    return child;
+}
@@ -1,12 +1,17 @@
 #include "WebSocketClient.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <mutex>
+#include <random>
 
 #include "CommunicationSslClient.h"
 #include "CommunicationTcpClient.h"
 #include "Data.h"
+#include "HandshakeResponse.h"
 #include "LogWriter.h"
+#include "Metrics.h"
 #include "RequestWebSocket.h"
 #include "Response.h"
 
@@ -35,12 +40,33 @@ bool WebSocketClient::Run()
 
 bool WebSocketClient::Close(bool wait)
 {
-    return m_connection->Close(wait);
+    m_closing      = true;
+    m_reconnecting = false;
+    if (m_reactor != nullptr)
+    {
+        m_reactor->Detach(&m_reconnectTimer, -1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_sendQueue.clear();
+    }
+
+    auto connection = std::atomic_load(&m_connection);
+    if (connection == nullptr)
+    {
+        return true;
+    }
+    return connection->Close(wait);
 }
 
 bool WebSocketClient::WaitFor()
 {
-    return m_connection->WaitFor();
+    auto connection = std::atomic_load(&m_connection);
+    if (connection == nullptr)
+    {
+        return true;
+    }
+    return connection->WaitFor();
 }
 
 bool WebSocketClient::Open(Request& request)
@@ -48,7 +74,7 @@ bool WebSocketClient::Open(Request& request)
     ClearError();
 
     const Url& url = request.GetUrl();
-    if (m_connection == nullptr)
+    if (std::atomic_load(&m_connection) == nullptr)
     {
         if (InitConnection(url) == false)
         {
@@ -58,11 +84,12 @@ bool WebSocketClient::Open(Request& request)
         }
     }
 
-    if (m_connection->IsConnected() == false)
+    auto connection = std::atomic_load(&m_connection);
+    if (connection->IsConnected() == false)
     {
-        if (m_connection->Connect(url.GetHost(), url.GetPort()) == false)
+        if (connection->Connect(url.GetHost(), url.GetPort()) == false)
         {
-            SetLastError("connection faied: " + m_connection->GetLastError());
+            SetLastError("connection faied: " + connection->GetLastError());
             LOG(GetLastError(), LogWriter::LogType::Error);
             return false;
         }
@@ -70,48 +97,151 @@ bool WebSocketClient::Open(Request& request)
         SetState(State::Connected);
     }
 
-    m_key = Data::Base64Encode(StringUtil::GenerateRandomString(16));
+    if (connection->Run() == false)
+    {
+        SetLastError("read routine failed: " + connection->GetLastError());
+        LOG(GetLastError(), LogWriter::LogType::Error);
+        return false;
+    }
 
-    if (m_connection->Run() == false)
+    if (!SendHandshake(request))
     {
-        SetLastError("read routine failed: " + m_connection->GetLastError());
+        return false;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_handshake_mtx);
+        bool                         ok = m_handshake_cv.wait_for(lock,
+                                    std::chrono::milliseconds(m_config.GetClientConnectTimeoutMs()),
+                                    [this]() { return m_handshake_done; });
+        if (!ok)
+        {
+            SetState(State::HandshakeFailed);
+            SetLastError("handshake timeout");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool WebSocketClient::OpenAsync(const std::string& address)
+{
+    ClearError();
+
+    auto connection = std::atomic_load(&m_connection);
+    if (connection != nullptr && connection->IsConnected())
+    {
+        SetLastError("already connected");
+        return false;
+    }
+
+    if (!StartOpen(address))
+    {
+        return false;
+    }
+
+    return EnableReconnect(address);
+}
+
+bool WebSocketClient::StartOpen(const std::string& address)
+{
+    std::unique_ptr<Request> request(new Request());
+    auto&                    url = request->GetUrl();
+    url.Parse(address);
+    if (!url.IsInitiaized())
+    {
+        SetLastError("Url parsing error");
         LOG(GetLastError(), LogWriter::LogType::Error);
         return false;
     }
+    request->SetMethod(Method::GET);
+
+    if (InitConnection(url) == false)
+    {
+        SetLastError("init failed: " + GetLastError());
+        LOG(GetLastError(), LogWriter::LogType::Error);
+        return false;
+    }
+
+    auto connection = std::atomic_load(&m_connection);
+    m_openRequest   = std::move(request);
+    if (connection->ConnectAsync(url.GetHost(), url.GetPort(), std::bind(&WebSocketClient::OnAsyncConnected, this, std::placeholders::_1)) == false)
+    {
+        m_openRequest.reset();
+        SetLastError("connection faied: " + connection->GetLastError());
+        LOG(GetLastError(), LogWriter::LogType::Error);
+        return false;
+    }
+
+    return true;
+}
+
+void WebSocketClient::OnAsyncConnected(bool connected)
+{
+    std::unique_ptr<Request> request    = std::move(m_openRequest);
+    auto                     connection = std::atomic_load(&m_connection);
+    if (!connected || request == nullptr)
+    {
+        SetLastError("connection faied: " + connection->GetLastError());
+        SetState(State::Closed);
+        if (m_connectCallback != nullptr)
+        {
+            m_connectCallback(false);
+        }
+        if (m_reconnecting)
+        {
+            ScheduleReconnect();
+        }
+        return;
+    }
+
+    SetState(State::Connected);
+    if (!SendHandshake(*request))
+    {
+        FinishHandshake(false);
+        return;
+    }
+
+    connection->SetTimeout(m_config.GetClientConnectTimeoutMs(), [this]() {
+        if (m_state == State::Handshake)
+        {
+            SetLastError("handshake timeout");
+            SetState(State::HandshakeFailed);
+            FinishHandshake(false);
+        }
+    });
+}
+
+bool WebSocketClient::SendHandshake(Request& request)
+{
+    m_key = Data::Base64Encode(StringUtil::GenerateRandomString(16));
 
     auto& header = request.GetHeader();
     header.SetHeader(Header::HeaderType::Host, request.GetUrl().GetHost());
     header.SetHeader(Header::HeaderType::Upgrade, "websocket");
     header.SetHeader(Header::HeaderType::Connection, "Upgrade");
-    header.SetHeader("Sec-WebSocket-Key", m_key);
-    header.SetHeader("Sec-WebSocket-Version", WS_VERSION);
+    header.SetHeader(Header::HeaderType::SecWebSocketKey, m_key);
+    header.SetHeader(Header::HeaderType::SecWebSocketVersion, WS_VERSION);
 
     {
         std::lock_guard<std::mutex> lock(m_handshake_mtx);
         m_handshake_done = false;
     }
+    {
+        std::lock_guard<std::mutex> lock(m_read_mtx);
+        m_data.clear();
+        m_handshakeResponse.reset(new Response(0, m_config));
+    }
     SetState(State::Handshake);
 
-    if (request.Send(m_connection) == false)
+    if (request.Send(std::atomic_load(&m_connection)) == false)
     {
         SetLastError("request sending error: " + request.GetLastError());
         LOG(GetLastError(), LogWriter::LogType::Error);
         return false;
     }
 
-    {
-        std::unique_lock<std::mutex> lock(m_handshake_mtx);
-        bool                         ok = m_handshake_cv.wait_for(lock,
-                                    std::chrono::milliseconds(m_config.GetClientConnectTimeoutMs()),
-                                    [this]() { return m_handshake_done; });
-        if (!ok)
-        {
-            SetState(State::HandshakeFailed);
-            SetLastError("handshake timeout");
-            return false;
-        }
-    }
-
     return true;
 }
 
@@ -125,7 +255,8 @@ bool WebSocketClient::Open(const std::string& address)
     if (p_url.IsInitiaized())
     {
         request.SetMethod(Method::GET);
-        return Open(request);
+        m_closing = false;
+        return Open(request) && EnableReconnect(address);
     }
     else
     {
@@ -138,10 +269,7 @@ bool WebSocketClient::Open(const std::string& address)
 
 bool WebSocketClient::SendText(const ByteArray& data)
 {
-    RequestWebSocket request;
-    request.SetType(MessageType::Text);
-    request.SetData(data);
-    return request.Send(m_connection.get());
+    return Send(MessageType::Text, data);
 }
 
 bool WebSocketClient::SendText(const std::string& data)
@@ -151,10 +279,7 @@ bool WebSocketClient::SendText(const std::string& data)
 
 bool WebSocketClient::SendBinary(const ByteArray& data)
 {
-    RequestWebSocket request;
-    request.SetType(MessageType::Binary);
-    request.SetData(data);
-    return request.Send(m_connection.get());
+    return Send(MessageType::Binary, data);
 }
 
 bool WebSocketClient::SendBinary(const std::string& data)
@@ -164,9 +289,53 @@ bool WebSocketClient::SendBinary(const std::string& data)
 
 bool WebSocketClient::SendPing()
 {
+    return Send(MessageType::Ping, ByteArray());
+}
+
+bool WebSocketClient::Send(MessageType type, const ByteArray& data)
+{
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    if (m_reconnecting)
+    {
+        if (m_sendQueue.size() >= m_config.GetClientSendQueueSize())
+        {
+            Metrics::Instance().Add(Metrics::Counter::ClientSendQueueDropped);
+            SetLastError("send queue is full");
+            return false;
+        }
+        m_sendQueue.emplace_back(type, data);
+        return true;
+    }
+
+    return SendFrame(type, data);
+}
+
+bool WebSocketClient::SendFrame(MessageType type, const ByteArray& data)
+{
+    auto connection = std::atomic_load(&m_connection);
+    if (connection == nullptr)
+    {
+        SetLastError("not connected");
+        return false;
+    }
+
     RequestWebSocket request;
-    request.SetType(MessageType::Ping);
-    return request.Send(m_connection.get());
+    request.SetType(type);
+    if (!data.empty())
+    {
+        request.SetData(data);
+    }
+    return request.Send(connection.get());
+}
+
+void WebSocketClient::SetReactor(std::shared_ptr<ClientReactor> reactor)
+{
+    m_reactor = std::move(reactor);
+}
+
+void WebSocketClient::SetResolver(std::shared_ptr<IResolver> resolver)
+{
+    m_resolver = std::move(resolver);
 }
 
 void WebSocketClient::SetOnConnect(OnConnectCallback callback)
@@ -205,26 +374,25 @@ void WebSocketClient::OnDataReady(ByteArray&& data)
     m_data.insert(m_data.end(), data.begin(), data.end());
     if (m_state == State::Handshake)
     {
-        Response response(0, m_config);
-        size_t   all, downloaded;
+        if (m_handshakeResponse == nullptr)
+        {
+            m_handshakeResponse.reset(new Response(0, m_config));
+        }
+        Response& response = *m_handshakeResponse;
+        size_t    all, downloaded;
         if (response.Parse(m_data, &all, &downloaded))
         {
             if (response.GetResponseCode() == 101)
             {
-                auto&       header = response.GetHeader();
-                std::string h      = header.GetHeader(Header::HeaderType::Upgrade);
-                StringUtil::ToLower(h);
-                if (h == "websocket")
+                auto& header = response.GetHeader();
+                if (header.CompareHeader(Header::HeaderType::Upgrade, "websocket"))
                 {
-                    h = header.GetHeader(Header::HeaderType::Connection);
-                    StringUtil::ToLower(h);
-                    if (h == "upgrade")
+                    if (header.CompareHeader(Header::HeaderType::Connection, "upgrade"))
                     {
-                        h                  = header.GetHeader("Sec-WebSocket-Accept");
-                        std::string key    = m_key + WEBSOCKET_KEY_TOKEN;
-                        auto        buffer = Data::Sha1Digest(key);
-                        key                = Data::Base64Encode(buffer.data(), Data::SHA1_DIGEST_LENGTH);
-                        if (h == key)
+                        size_t      size;
+                        const char* accept = header.FindHeader(Header::HeaderType::SecWebSocketAccept, size);
+                        char        key[HandshakeResponse::ACCEPT_KEY_LENGTH];
+                        if (HandshakeResponse::ComputeAcceptKey(m_key.data(), m_key.size(), key) && accept != nullptr && size == sizeof(key) && memcmp(accept, key, sizeof(key)) == 0)
                         {
                             SetState(State::BinaryMessage);
                             {
@@ -232,11 +400,9 @@ void WebSocketClient::OnDataReady(ByteArray&& data)
                                 m_handshake_done = true;
                             }
                             m_handshake_cv.notify_one();
-                            if (m_connectCallback != nullptr)
-                            {
-                                m_connectCallback(true);
-                            }
+                            FinishHandshake(true);
                             m_data.erase(m_data.begin(), m_data.begin() + response.GetResponseSize());
+                            m_handshakeResponse.reset();
                             return;
                         }
                         else
@@ -259,18 +425,18 @@ void WebSocketClient::OnDataReady(ByteArray&& data)
                 SetLastError("incorrect response code");
             }
         }
+        else if (response.GetParseState() != Response::ParseState::Error)
+        {
+            return; // the rest of the response hasn't arrived yet
+        }
         else
         {
             SetLastError("error while response parsing");
         }
 
+        m_handshakeResponse.reset();
         SetState(State::Closed);
-        if (m_connectCallback != nullptr)
-        {
-            m_connectCallback(false);
-        }
-
-        Close(false);
+        FinishHandshake(false);
     }
     else if (m_state == State::BinaryMessage)
     {
@@ -282,6 +448,11 @@ void WebSocketClient::OnDataReady(ByteArray&& data)
                 break;
             }
             m_data.erase(m_data.begin(), m_data.begin() + response.GetSize());
+            if (response.GetMessageType() == MessageType::Ping)
+            {
+                // RFC 6455 5.5.2, the server closes a connection that doesn't answer its pings
+                Send(MessageType::Pong, response.GetData());
+            }
             if (m_messageCallback != nullptr)
             {
                 m_messageCallback(response);
@@ -290,9 +461,48 @@ void WebSocketClient::OnDataReady(ByteArray&& data)
     }
 }
 
+void WebSocketClient::FinishHandshake(bool ok)
+{
+    auto connection = std::atomic_load(&m_connection);
+    connection->SetTimeout(0, nullptr);
+
+    if (ok)
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        if (m_reconnecting.exchange(false))
+        {
+            Metrics& metrics = Metrics::Instance();
+            metrics.Add(Metrics::Counter::ClientReconnects);
+            metrics.Record(Metrics::Histogram::ClientReconnectNs, Metrics::Now() - m_disconnectedAt);
+            m_reconnectAttempt = 0;
+        }
+        while (!m_sendQueue.empty())
+        {
+            auto& message = m_sendQueue.front();
+            SendFrame(message.first, message.second);
+            m_sendQueue.pop_front();
+        }
+    }
+
+    if (m_connectCallback != nullptr)
+    {
+        m_connectCallback(ok);
+    }
+
+    if (!ok)
+    {
+        connection->Close(false);
+        if (m_reconnecting)
+        {
+            ScheduleReconnect();
+        }
+    }
+}
+
 void WebSocketClient::OnClosed()
 {
     SetState(State::Closed);
+    ScheduleReconnect();
 
     if (m_closeCallback != nullptr)
     {
@@ -300,38 +510,123 @@ void WebSocketClient::OnClosed()
     }
 }
 
+bool WebSocketClient::EnableReconnect(const std::string& address)
+{
+    if (!m_config.GetClientReconnect())
+    {
+        return true;
+    }
+
+    m_address = address;
+    m_closing = false;
+    if (m_reconnectTimer.GetReactorId() != 0)
+    {
+        return true;
+    }
+
+    if (m_reactor == nullptr)
+    {
+        m_reactor = ClientReactor::Default();
+    }
+    if (m_reactor == nullptr || !m_reactor->Attach(-1, &m_reconnectTimer, 0))
+    {
+        SetLastError("reconnect timer failed");
+        LOG(GetLastError(), LogWriter::LogType::Error);
+        return false;
+    }
+
+    return true;
+}
+
+bool WebSocketClient::ScheduleReconnect()
+{
+    if (m_closing || m_address.empty() || m_reconnectTimer.GetReactorId() == 0)
+    {
+        return false;
+    }
+
+    if (!m_reconnecting.exchange(true))
+    {
+        m_disconnectedAt = Metrics::Now();
+    }
+
+    uint64_t delay = ReconnectDelay(m_reconnectAttempt++);
+    LOG("reconnect in " + std::to_string(delay) + "ms", LogWriter::LogType::Info);
+    return m_reactor->SetTimer(&m_reconnectTimer, delay);
+}
+
+void WebSocketClient::Reconnect()
+{
+    if (m_closing)
+    {
+        return;
+    }
+
+    Metrics::Instance().Add(Metrics::Counter::ClientReconnectAttempts);
+    if (!StartOpen(m_address))
+    {
+        ScheduleReconnect();
+    }
+}
+
+uint64_t WebSocketClient::ReconnectDelay(uint32_t attempt) const
+{
+    // equal jitter: half of the exponential delay is kept, the rest is random,
+    // so the clients dropped together don't come back together
+    static constexpr uint32_t MAX_SHIFT = 32;
+
+    uint64_t minDelay = std::max<uint64_t>(m_config.GetClientReconnectMinMs(), 1);
+    uint64_t maxDelay = std::max(m_config.GetClientReconnectMaxMs(), minDelay);
+    uint64_t delay    = maxDelay;
+    if (attempt < MAX_SHIFT && (maxDelay >> attempt) >= minDelay)
+    {
+        delay = minDelay << attempt;
+    }
+
+    thread_local std::mt19937_64            rng{std::random_device{}()};
+    std::uniform_int_distribution<uint64_t> jitter(0, delay / 2);
+    return delay - delay / 2 + jitter(rng);
+}
+
 bool WebSocketClient::InitConnection(const Url& url)
 {
-    if (m_connection != nullptr)
+    auto previous = std::atomic_load(&m_connection);
+    if (previous != nullptr)
     {
-        m_connection->Close();
+        previous->Close();
     }
 
+    std::shared_ptr<CommunicationClientBase> connection;
     switch (url.GetScheme())
     {
         case Url::Scheme::WS:
-            m_connection = std::make_shared<CommunicationTcpClient>();
+            connection = std::make_shared<CommunicationTcpClient>(m_reactor, m_resolver);
             break;
 #ifdef WITH_OPENSSL
         case Url::Scheme::WSS:
-            m_connection = std::make_shared<CommunicationSslClient>(m_config.GetSslSertificate(), m_config.GetSslKey());
+            connection = std::make_shared<CommunicationSslClient>(m_config.GetSslSertificate(), m_config.GetSslKey(), m_reactor, m_resolver);
             break;
 #endif
         default:
             break;
     }
 
-    if (m_connection == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        std::atomic_store(&m_connection, connection);
+    }
+
+    if (connection == nullptr)
     {
         SetLastError("provided scheme is incorrect or not supported");
         LOG(GetLastError(), LogWriter::LogType::Error);
         return false;
     }
 
-    m_connection->SetHost(url.GetHost());
-    m_connection->SetPort(url.GetPort());
+    connection->SetHost(url.GetHost());
+    connection->SetPort(url.GetPort());
 
-    if (!m_connection->Init())
+    if (!connection->Init())
     {
         SetLastError("WebSocketClient init failed");
         LOG(GetLastError(), LogWriter::LogType::Error);
@@ -341,9 +636,9 @@ bool WebSocketClient::InitConnection(const Url& url)
     SetState(State::Initialized);
 
     auto f1 = std::bind(&WebSocketClient::OnDataReady, this, std::placeholders::_1);
-    m_connection->SetDataReadyCallback(f1);
+    connection->SetDataReadyCallback(f1);
     auto f2 = std::bind(&WebSocketClient::OnClosed, this);
-    m_connection->SetCloseConnectionCallback(f2);
+    connection->SetCloseConnectionCallback(f2);
 
     return true;
 }
@@ -5,16 +5,17 @@
 
 #include "CommunicationSslServer.h"
 #include "CommunicationTcpServer.h"
-#include "Data.h"
 #include "FileSystem.h"
 #include "LogWriter.h"
+#include "Metrics.h"
 #include "common.h"
 #include "common_ws.h"
 
 using namespace WebSocketCpp;
 
 WebSocketServer::WebSocketServer()
-    : m_config(WebSocketCpp::Config::Instance())
+    : m_config(WebSocketCpp::Config::Instance()),
+      m_routes(std::make_shared<RouteTable>())
 {
 }
 
@@ -27,6 +28,10 @@ bool WebSocketServer::Init()
 {
     ClearError();
 
+    // the log files follow the current Log* settings
+    LogWriter::Instance().Reopen();
+    Trace::SetSampleRate(m_config.GetTraceSampleRate());
+
     m_protocol = m_config.GetWsProtocol();
     switch (m_protocol)
     {
@@ -35,7 +40,7 @@ bool WebSocketServer::Init()
             break;
 #ifdef WITH_OPENSSL
         case Protocol::WSS:
-            m_server = std::unique_ptr<CommunicationServerBase>(new CommunicationSslServer(m_config.GetSslSertificate(), m_config.GetSslKey()));
+            m_server = std::unique_ptr<CommunicationServerBase>(new CommunicationSslServer(m_config.GetSslSertificate(), m_config.GetSslKey(), m_config.GetSslKtls()));
             break;
 #endif
         default:
@@ -50,6 +55,7 @@ bool WebSocketServer::Init()
     }
 
     m_server->SetPort(m_config.GetWsServerPort());
+    m_server->SetTimeouts(m_config.GetWsHandshakeTimeoutMs(), m_config.GetWsPingIntervalMs(), m_config.GetWsPongTimeoutMs(), m_config.GetWsIdleTimeoutMs());
     if (!m_server->Init())
     {
         SetLastError("WebSocketServer init failed");
@@ -59,6 +65,8 @@ bool WebSocketServer::Init()
 
     LOG(ToString(), LogWriter::LogType::Info);
 
+    m_handshake.Init(m_config.GetServerName());
+
     FileSystem::ChangeDir(FileSystem::GetApplicationFolder());
 
     auto f1 = std::bind(&WebSocketServer::ClientConnected, this, std::placeholders::_1, std::placeholders::_2);
@@ -128,19 +136,26 @@ bool WebSocketServer::WaitFor()
 void WebSocketServer::OnMessage(const std::string& path, OnMessageCallback func)
 {
     std::lock_guard<std::mutex> lock(m_routeMutex);
-    auto                        it = std::find_if(m_routes.begin(), m_routes.end(),
-                               [&path](const RouteWebSocket& r) { return r.GetPath() == path; });
 
-    if (it != m_routes.end())
+    // the readers never lock, so the table is copied, modified and published as a whole
+    auto table    = std::make_shared<RouteTable>(*std::atomic_load(&m_routes));
+    auto existing = table->Find(path);
+
+    if (existing != nullptr)
     {
-        it->SetFunctionMessage(std::move(func));
-        LOG("Updated route: " + it->ToString(), LogWriter::LogType::Info);
+        auto route = std::make_shared<RouteWebSocket>(path, std::move(func), existing->GetFunctionRequest());
+        table->Replace(route);
+        LOG("Updated route: " + route->ToString(), LogWriter::LogType::Info);
     }
     else
     {
-        m_routes.emplace_back(path, func);
-        LOG("Registered route: " + m_routes.back().ToString(), LogWriter::LogType::Info);
+        auto route = std::make_shared<RouteWebSocket>(path, std::move(func));
+        table->Add(route);
+        LOG("Registered route: " + route->ToString(), LogWriter::LogType::Info);
     }
+
+    std::atomic_store(&m_routes, std::shared_ptr<const RouteTable>(std::move(table)));
+    m_routesVersion.fetch_add(1, std::memory_order_release);
 }
 
 void WebSocketServer::OnConnect(OnConnectCallback func)
@@ -175,7 +190,7 @@ std::string WebSocketServer::ToString() const
 
 void WebSocketServer::ClientConnected(int connID, const std::string& remote)
 {
-    LOG(std::string("client connected: #") + std::to_string(connID) + ", " + remote, LogWriter::LogType::Access);
+    LOG_ACCESS(AccessLog::Event::Connect, connID, remote);
     InitConnection(connID, remote);
     if (m_connect_callback)
     {
@@ -186,13 +201,15 @@ void WebSocketServer::ClientConnected(int connID, const std::string& remote)
 
 void WebSocketServer::DataReady(int connID, ByteArray data)
 {
-    PutToQueue(connID, std::move(data));
+    Trace::Context trace;
+    TRACE_TAKE(trace);
+    PutToQueue(connID, std::move(data), trace);
     SendSignal();
 }
 
 void WebSocketServer::ClientDisconnected(int connID)
 {
-    LOG(std::string("websocket connection closed: #") + std::to_string(connID), LogWriter::LogType::Access);
+    LOG_ACCESS(AccessLog::Event::Disconnect, connID, "");
 
     if (m_disconnect_callback)
     {
@@ -262,13 +279,14 @@ void WebSocketServer::WaitForSignal()
     m_pending_signal = false;
 }
 
-void WebSocketServer::PutToQueue(int connID, ByteArray&& data)
+void WebSocketServer::PutToQueue(int connID, ByteArray&& data, const Trace::Context& trace)
 {
     std::lock_guard<std::mutex> lock(m_queueMutex);
     for (auto& req : m_requestQueue)
     {
         if (req.connID == connID)
         {
+            TRACE_ADOPT(req.trace, trace, Queued);
             req.data.insert(req.data.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
             break;
         }
@@ -288,6 +306,7 @@ void WebSocketServer::InitConnection(int connID, const std::string& remote)
     if (getRequest(connID) == nullptr)
     {
         m_requestQueue.emplace_back(connID, remote);
+        Metrics::Instance().Add(Metrics::Gauge::Connections, 1);
     }
 }
 
@@ -298,6 +317,7 @@ bool WebSocketServer::CheckData()
 
     for (RequestData& requestData : m_requestQueue)
     {
+        TRACE_STAMP(requestData.trace, Woken);
         if (requestData.readyForDispatch == false)
         {
             if (requestData.handshake == false)
@@ -329,11 +349,29 @@ bool WebSocketServer::CheckWsHeader(RequestData& requestData)
         {
             requestData.request.SetMethod(Method::WEBSOCKET);
             requestData.data.erase(requestData.data.begin(), requestData.data.begin() + size);
+            TRACE_RESET(requestData.trace); // only the messages are traced
             requestData.readyForDispatch = true;
             requestData.handshake        = false;
             retval                       = true;
         }
     }
+    else if (requestData.request.GetParseState() == Request::ParseState::Error)
+    {
+        // the request line is broken, no reason to keep what's buffered or the connection
+        requestData.data.clear();
+        if (!requestData.rejected)
+        {
+            requestData.rejected = true;
+            Metrics::Instance().Add(Metrics::Counter::ParseErrors);
+
+            Response response(requestData.connID, m_config);
+            response.SetResponseCode(400);
+            response.AddHeader(Header::HeaderType::Connection, "close");
+            response.AddHeader(Header::HeaderType::ContentLength, "0");
+            response.Send(m_server.get());
+            m_server->CloseConnection(requestData.connID);
+        }
+    }
 
     return retval;
 }
@@ -348,6 +386,9 @@ bool WebSocketServer::CheckWsFrame(RequestData& requestData)
     {
         size_t size = request.GetSize();
         requestData.data.erase(requestData.data.begin(), requestData.data.begin() + size);
+        Metrics::Instance().Add(Metrics::FrameCounter(request.GetType(), true));
+        TRACE_STAMP(requestData.trace, Parsed);
+        Metrics::Instance().Add(Metrics::Gauge::RequestQueueDepth, 1);
         requestData.requestList.emplace_back(std::move(request));
         requestData.readyForDispatch = true;
         requestData.handshake        = true;
@@ -367,7 +408,16 @@ void WebSocketServer::ProcessRequests()
         {
             if (entry.handshake == false)
             {
-                if (ProcessRequest(entry.request))
+                if (IsMetricsRequest(entry.request))
+                {
+                    ServeMetrics(entry);
+                    continue;
+                }
+
+                uint64_t start     = Metrics::Now();
+                bool     processed = ProcessRequest(entry);
+                Metrics::Instance().Record(Metrics::Histogram::HandshakeLatencyNs, Metrics::Now() - start);
+                if (processed)
                 {
                     entry.handshake        = true;
                     entry.readyForDispatch = false;
@@ -383,8 +433,9 @@ void WebSocketServer::ProcessRequests()
                     {
                         if (it->IsFinal())
                         {
-                            ProcessWsRequest(entry.request, *it);
+                            ProcessWsRequest(entry, *it);
                             it = entry.requestList.erase(it);
+                            Metrics::Instance().Add(Metrics::Gauge::RequestQueueDepth, -1);
                         }
                         else
                         {
@@ -421,69 +472,105 @@ void WebSocketServer::RemoveFromQueue(int connID)
     {
         if (it->connID == connID)
         {
+            Metrics::Instance().Add(Metrics::Gauge::Connections, -1);
+            Metrics::Instance().Add(Metrics::Gauge::RequestQueueDepth, -static_cast<int64_t>(it->requestList.size()));
             m_requestQueue.erase(it);
             break;
         }
     }
 }
 
-bool WebSocketServer::ProcessRequest(Request& request)
+bool WebSocketServer::ProcessRequest(RequestData& requestData)
 {
-    Response response(request.GetConnectionID(), m_config);
-    bool     processed = false;
-    bool     matched   = false;
+    Request&                  request = requestData.request;
+    std::unique_ptr<Response> response;
+    bool                      processed = false;
 
-    for (auto& route : m_routes)
+    // the path doesn't change for the connection lifetime so the messages reuse this result
+    requestData.routesVersion = m_routesVersion.load(std::memory_order_acquire);
+    requestData.routeTable    = std::atomic_load(&m_routes);
+    bool matched              = requestData.routeTable->Match(request, requestData.routes);
+
+    for (auto& binding : requestData.routes.bindings)
     {
-        if (route.IsMatch(request))
+        auto& f = requestData.routeTable->Get(binding.route).GetFunctionRequest();
+        if (f != nullptr)
         {
-            matched = true;
-            auto& f = route.GetFunctionRequest();
-            if (f != nullptr)
+            if (response == nullptr)
             {
-                try
-                {
-                    if ((processed = f(request, response)))
-                    {
-                        break;
-                    }
-                }
-                catch (...)
+                response.reset(new Response(request.GetConnectionID(), m_config));
+            }
+            request.SetRouteArgs(&requestData.routes.path, &binding.args);
+            try
+            {
+                if ((processed = f(request, *response)))
                 {
+                    break;
                 }
             }
+            catch (...)
+            {
+            }
         }
     }
+    request.SetRouteArgs(nullptr, nullptr);
 
     // the uri is matched but not request handler is provided or request is not processed
+    if (processed == false && matched == true && m_config.GetWsProcessDefault() == true)
+    {
+        size_t      keySize;
+        const char* key = request.GetHeader().FindHeader(Header::HeaderType::SecWebSocketKey, keySize);
+        if (key != nullptr && m_handshake.Build(key, keySize))
+        {
+            if (!m_server->Write(request.GetConnectionID(), m_handshake.GetData()))
+            {
+                return false;
+            }
+            m_server->SetUpgraded(request.GetConnectionID());
+            Metrics::Instance().Add(Metrics::Counter::Handshakes);
+            return true;
+        }
+    }
+
+    if (response == nullptr)
+    {
+        response.reset(new Response(request.GetConnectionID(), m_config));
+    }
+
     if (processed == false && matched == true)
     {
         if (m_config.GetWsProcessDefault() == true)
         {
-            std::string key = request.GetHeader().GetHeader("Sec-WebSocket-Key");
-            key             = key + WEBSOCKET_KEY_TOKEN;
-
-            auto buffer = Data::Sha1Digest(key);
-            key         = Data::Base64Encode(buffer.data(), Data::SHA1_DIGEST_LENGTH);
-
-            response.SetResponseCode(101);
-            response.AddHeader(Header::HeaderType::Date, FileSystem::GetDateTime());
-            response.AddHeader(Header::HeaderType::Upgrade, "websocket");
-            response.AddHeader(Header::HeaderType::Connection, "upgrade");
-            response.AddHeader("Sec-WebSocket-Accept", key);
-            response.AddHeader("Sec-WebSocket-Version", WS_VERSION);
+            response->SetResponseCode(400);
+            response->AddHeader(Header::HeaderType::ContentLength, "0");
+            if (request.GetHeader().CompareHeader(Header::HeaderType::Upgrade, "websocket"))
+            {
+                Metrics::Instance().Add(Metrics::Counter::HandshakeErrors);
+            }
         }
         else
         {
-            response.NotFound();
+            response->NotFound();
         }
     }
 
-    return response.Send(m_server.get());
+    if (!response->Send(m_server.get()))
+    {
+        return false;
+    }
+    // a handler may answer without upgrading, the handshake deadline stays then
+    if (processed && response->GetResponseCode() == 101)
+    {
+        m_server->SetUpgraded(request.GetConnectionID());
+        Metrics::Instance().Add(Metrics::Counter::Handshakes);
+    }
+
+    return true;
 }
 
-bool WebSocketServer::ProcessWsRequest(Request& request, const RequestWebSocket& wsRequest)
+bool WebSocketServer::ProcessWsRequest(RequestData& requestData, const RequestWebSocket& wsRequest)
 {
+    Request&          request = requestData.request;
     ResponseWebSocket response(request.GetConnectionID());
     bool              processed = false;
 
@@ -493,27 +580,41 @@ bool WebSocketServer::ProcessWsRequest(Request& request, const RequestWebSocket&
         case MessageType::Text:
         case MessageType::Binary:
         {
-            std::lock_guard<std::mutex> lock(m_routeMutex);
-            for (auto& route : m_routes)
+            Metrics::Instance().Record(Metrics::Histogram::MessageSizeBytes, wsRequest.GetData().size());
+
+            size_t version = m_routesVersion.load(std::memory_order_acquire);
+            if (version != requestData.routesVersion) // the routes were changed after the handshake
             {
-                if (route.IsMatch(request))
+                requestData.routesVersion = version;
+                requestData.routeTable    = std::atomic_load(&m_routes);
+                requestData.routeTable->Match(request, requestData.routes);
+            }
+
+            TRACE_STAMP(requestData.trace, HandlerStart);
+            for (auto& binding : requestData.routes.bindings)
+            {
+                auto& f = requestData.routeTable->Get(binding.route).GetFunctionMessage();
+                if (f != nullptr)
                 {
-                    auto& f = route.GetFunctionMessage();
-                    if (f != nullptr)
+                    request.SetRouteArgs(&requestData.routes.path, &binding.args);
+                    uint64_t start   = Metrics::Now();
+                    bool     handled = false;
+                    try
+                    {
+                        handled = f(request, response, wsRequest.GetData());
+                    }
+                    catch (...)
                     {
-                        try
-                        {
-                            if (f(request, response, wsRequest.GetData()) == true)
-                            {
-                                break;
-                            }
-                        }
-                        catch (...)
-                        {
-                        }
+                    }
+                    Metrics::Instance().Record(Metrics::Histogram::HandlerLatencyNs, Metrics::Now() - start);
+                    if (handled)
+                    {
+                        break;
                     }
                 }
             }
+            request.SetRouteArgs(nullptr, nullptr);
+            TRACE_STAMP(requestData.trace, HandlerEnd);
         }
         break;
         case MessageType::Ping:
@@ -531,21 +632,48 @@ bool WebSocketServer::ProcessWsRequest(Request& request, const RequestWebSocket&
     {
         response.Send(m_server.get());
     }
+    TRACE_FINISH(requestData.trace);
 
     return true;
 }
 
-RouteWebSocket* WebSocketServer::GetRoute(const std::string& path)
+bool WebSocketServer::IsMetricsRequest(const Request& request) const
 {
-    for (size_t i = 0; i < m_routes.size(); i++)
+    const std::string& route = m_config.GetMetricsRoute();
+    if (route.empty() || request.GetHeader().HasHeader(Header::HeaderType::SecWebSocketKey))
     {
-        if (m_routes.at(i).GetPath() == path)
-        {
-            return &(m_routes.at(i));
-        }
+        return false;
     }
 
-    return nullptr;
+    return request.GetUrl().GetPath() == route;
+}
+
+bool WebSocketServer::ServeMetrics(RequestData& requestData)
+{
+    Request& request = requestData.request;
+    Response response(request.GetConnectionID(), m_config);
+
+    Metrics::Instance().Add(Metrics::Counter::MetricsRequests);
+    std::string body = Metrics::Instance().ToPrometheus();
+    response.SetResponseCode(200);
+    response.AddHeader(Header::HeaderType::ContentType, "text/plain; version=0.0.4");
+    response.Write(body);
+    bool retval = response.Send(m_server.get());
+
+    // not an upgrade, so the connection stays in the HTTP state for the next request
+    int         connID = request.GetConnectionID();
+    std::string remote = request.GetHeader().GetRemote();
+    request.Clear();
+    request.SetConnectionID(connID);
+    request.GetHeader().SetRemote(remote);
+    requestData.readyForDispatch = false;
+
+    return retval;
+}
+
+RouteTable::RoutePtr WebSocketServer::GetRoute(const std::string& path)
+{
+    return std::atomic_load(&m_routes)->Find(path);
 }
 
 WebSocketServer::RequestData* WebSocketServer::getRequest(int connID)
@@ -3,11 +3,13 @@
 
 using namespace WebSocketCpp;
 
-CommunicationSslClient::CommunicationSslClient(const std::string& cert, const std::string& key) noexcept
+CommunicationSslClient::CommunicationSslClient(const std::string& cert, const std::string& key, std::shared_ptr<ClientReactor> reactor, std::shared_ptr<IResolver> resolver) noexcept
     : m_cert(cert),
       m_key(key)
 {
     m_client.SetSslCredentials(cert, key);
+    m_client.SetReactor(std::move(reactor));
+    m_client.SetResolver(std::move(resolver));
 }
 
 CommunicationSslClient::~CommunicationSslClient()
@@ -69,19 +71,7 @@ bool CommunicationSslClient::Connect(const std::string& host, int port)
     const std::string& h = host.empty() ? m_host : host;
     int                p = (port <= 0) ? m_port : port;
 
-    m_client.SetOnData([this](ByteArray&& data) {
-        if (m_data_cb)
-        {
-            m_data_cb(std::move(data));
-        }
-    });
-
-    m_client.SetOnClose([this]() {
-        if (m_close_cb)
-        {
-            m_close_cb();
-        }
-    });
+    BindSocket();
 
     if (!m_client.Connect(h, p))
     {
@@ -93,6 +83,40 @@ bool CommunicationSslClient::Connect(const std::string& host, int port)
     return true;
 }
 
+bool CommunicationSslClient::ConnectAsync(const std::string& host, int port, ConnectCallback callback)
+{
+    const std::string& h = host.empty() ? m_host : host;
+    int                p = (port <= 0) ? m_port : port;
+
+    BindSocket();
+
+    bool ok = m_client.ConnectAsync(h, p, [this, callback](bool connected) {
+        if (connected)
+        {
+            setConnected(true);
+            setRunning(true);
+        }
+        else
+        {
+            SetLastError(m_client.GetLastError());
+        }
+        if (callback)
+        {
+            callback(connected);
+        }
+    });
+    if (!ok)
+    {
+        SetLastError(m_client.GetLastError());
+    }
+    return ok;
+}
+
+bool CommunicationSslClient::SetTimeout(uint64_t timeoutMs, TimeoutCallback callback)
+{
+    return m_client.SetTimeout(timeoutMs, std::move(callback));
+}
+
 bool CommunicationSslClient::Run()
 {
     if (!m_client.Run())
@@ -107,7 +131,7 @@ bool CommunicationSslClient::Run()
 
 bool CommunicationSslClient::Close(bool wait)
 {
-    if (IsRunning() || IsConnected())
+    if (IsRunning() || IsConnected() || m_client.IsRunning())
     {
         m_client.Close(wait);
         setRunning(false);
@@ -121,6 +145,23 @@ bool CommunicationSslClient::WaitFor()
     return m_client.WaitFor();
 }
 
+void CommunicationSslClient::BindSocket()
+{
+    m_client.SetOnData([this](ByteArray&& data) {
+        if (m_data_cb)
+        {
+            m_data_cb(std::move(data));
+        }
+    });
+
+    m_client.SetOnClose([this]() {
+        if (m_close_cb)
+        {
+            m_close_cb();
+        }
+    });
+}
+
 bool CommunicationSslClient::Write(const ByteArray& data)
 {
     if (!m_client.Write(data.data(), data.size()))
@@ -3,11 +3,12 @@
 
 using namespace WebSocketCpp;
 
-CommunicationSslServer::CommunicationSslServer(const std::string& cert, const std::string& key) noexcept
+CommunicationSslServer::CommunicationSslServer(const std::string& cert, const std::string& key, bool ktls) noexcept
     : m_cert(cert),
       m_key(key)
 {
     m_server.SetSslCredentials(cert, key);
+    m_server.SetKtls(ktls);
 }
 
 CommunicationSslServer::~CommunicationSslServer()
@@ -139,11 +140,26 @@ bool CommunicationSslServer::Write(int connID, ByteArray& data, size_t size)
     return true;
 }
 
-bool CommunicationSslServer::CloseConnection(int /*connID*/)
+bool CommunicationSslServer::CloseConnection(int connID)
 {
+    if (!m_server.CloseConnection(connID))
+    {
+        SetLastError(m_server.GetLastError());
+        return false;
+    }
     return true;
 }
 
+void CommunicationSslServer::SetTimeouts(uint64_t handshakeMs, uint64_t pingMs, uint64_t pongMs, uint64_t idleMs)
+{
+    m_server.SetTimeouts(handshakeMs, pingMs, pongMs, idleMs);
+}
+
+void CommunicationSslServer::SetUpgraded(int connID)
+{
+    m_server.SetUpgraded(connID);
+}
+
 bool CommunicationSslServer::SetNewConnectionCallback(NewConnectionCallback callback)
 {
     m_new_conn_cb = std::move(callback);
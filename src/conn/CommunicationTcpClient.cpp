@@ -2,7 +2,11 @@
 
 using namespace WebSocketCpp;
 
-CommunicationTcpClient::CommunicationTcpClient() = default;
+CommunicationTcpClient::CommunicationTcpClient(std::shared_ptr<ClientReactor> reactor, std::shared_ptr<IResolver> resolver)
+{
+    m_client.SetReactor(std::move(reactor));
+    m_client.SetResolver(std::move(resolver));
+}
 
 CommunicationTcpClient::~CommunicationTcpClient()
 {
@@ -63,19 +67,7 @@ bool CommunicationTcpClient::Connect(const std::string& host, int port)
     const std::string& h = host.empty() ? m_host : host;
     int                p = (port <= 0) ? m_port : port;
 
-    m_client.SetOnData([this](ByteArray&& data) {
-        if (m_data_cb)
-        {
-            m_data_cb(std::move(data));
-        }
-    });
-
-    m_client.SetOnClose([this]() {
-        if (m_close_cb)
-        {
-            m_close_cb();
-        }
-    });
+    BindSocket();
 
     if (!m_client.Connect(h, p))
     {
@@ -87,6 +79,40 @@ bool CommunicationTcpClient::Connect(const std::string& host, int port)
     return true;
 }
 
+bool CommunicationTcpClient::ConnectAsync(const std::string& host, int port, ConnectCallback callback)
+{
+    const std::string& h = host.empty() ? m_host : host;
+    int                p = (port <= 0) ? m_port : port;
+
+    BindSocket();
+
+    bool ok = m_client.ConnectAsync(h, p, [this, callback](bool connected) {
+        if (connected)
+        {
+            setConnected(true);
+            setRunning(true);
+        }
+        else
+        {
+            SetLastError(m_client.GetLastError());
+        }
+        if (callback)
+        {
+            callback(connected);
+        }
+    });
+    if (!ok)
+    {
+        SetLastError(m_client.GetLastError());
+    }
+    return ok;
+}
+
+bool CommunicationTcpClient::SetTimeout(uint64_t timeoutMs, TimeoutCallback callback)
+{
+    return m_client.SetTimeout(timeoutMs, std::move(callback));
+}
+
 bool CommunicationTcpClient::Run()
 {
     if (!m_client.Run())
@@ -101,7 +127,7 @@ bool CommunicationTcpClient::Run()
 
 bool CommunicationTcpClient::Close(bool wait)
 {
-    if (IsRunning() || IsConnected())
+    if (IsRunning() || IsConnected() || m_client.IsRunning())
     {
         m_client.Close(wait);
         setRunning(false);
@@ -115,6 +141,23 @@ bool CommunicationTcpClient::WaitFor()
     return m_client.WaitFor();
 }
 
+void CommunicationTcpClient::BindSocket()
+{
+    m_client.SetOnData([this](ByteArray&& data) {
+        if (m_data_cb)
+        {
+            m_data_cb(std::move(data));
+        }
+    });
+
+    m_client.SetOnClose([this]() {
+        if (m_close_cb)
+        {
+            m_close_cb();
+        }
+    });
+}
+
 bool CommunicationTcpClient::Write(const ByteArray& data)
 {
     if (!m_client.Write(data.data(), data.size()))
@@ -136,12 +136,26 @@ bool CommunicationTcpServer::Write(int connID, ByteArray& data, size_t size)
     return true;
 }
 
-bool CommunicationTcpServer::CloseConnection(int /*connID*/)
+bool CommunicationTcpServer::CloseConnection(int connID)
 {
-    // ServerSocket manages connection lifecycle internally
+    if (!m_server.CloseConnection(connID))
+    {
+        SetLastError(m_server.GetLastError());
+        return false;
+    }
     return true;
 }
 
+void CommunicationTcpServer::SetTimeouts(uint64_t handshakeMs, uint64_t pingMs, uint64_t pongMs, uint64_t idleMs)
+{
+    m_server.SetTimeouts(handshakeMs, pingMs, pongMs, idleMs);
+}
+
+void CommunicationTcpServer::SetUpgraded(int connID)
+{
+    m_server.SetUpgraded(connID);
+}
+
 bool CommunicationTcpServer::SetNewConnectionCallback(NewConnectionCallback callback)
 {
     m_new_conn_cb = std::move(callback);
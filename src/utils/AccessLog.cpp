@@ -0,0 +1,264 @@
+#include "AccessLog.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FileSystem.h"
+
+#define ACCESS_LOG_MAGIC "WSCPPACL"
+
+using namespace WebSocketCpp;
+
+constexpr uint32_t AccessLog::VERSION;
+constexpr size_t   AccessLog::DEFAULT_SIZE;
+
+AccessLog::~AccessLog()
+{
+    Close();
+}
+
+bool AccessLog::Open(const std::string& file, size_t capacity)
+{
+    Close();
+    ClearError();
+
+    m_fd = open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd == ERROR)
+    {
+        SetLastError(std::string("access log open error: ") + strerror(errno), errno);
+        return false;
+    }
+
+    FileHeader header{};
+    struct stat st;
+    if (fstat(m_fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(FileHeader) &&
+        pread(m_fd, &header, sizeof(header), 0) == sizeof(header) &&
+        memcmp(header.magic, ACCESS_LOG_MAGIC, sizeof(header.magic)) == 0 &&
+        header.recordSize == sizeof(Record))
+    {
+        // continue the existing file, records past the stored count are garbage
+        size_t used = sizeof(FileHeader) + header.count * sizeof(Record);
+        if (capacity < used + sizeof(Record))
+        {
+            capacity = used + sizeof(Record);
+        }
+    }
+    else
+    {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, ACCESS_LOG_MAGIC, sizeof(header.magic));
+        header.version    = VERSION;
+        header.recordSize = sizeof(Record);
+        header.count      = 0;
+    }
+
+    // whole records only
+    if (capacity < sizeof(FileHeader) + sizeof(Record))
+    {
+        capacity = sizeof(FileHeader) + sizeof(Record);
+    }
+    capacity -= (capacity - sizeof(FileHeader)) % sizeof(Record);
+
+    if (ftruncate(m_fd, static_cast<off_t>(capacity)) == ERROR)
+    {
+        SetLastError(std::string("access log truncate error: ") + strerror(errno), errno);
+        Close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        SetLastError(std::string("access log mmap error: ") + strerror(errno), errno);
+        Close();
+        return false;
+    }
+
+    m_data     = static_cast<uint8_t*>(data);
+    m_capacity = capacity;
+    m_header   = reinterpret_cast<FileHeader*>(m_data);
+    memcpy(m_header, &header, sizeof(header));
+
+    return true;
+}
+
+void AccessLog::Close()
+{
+    size_t used = GetSize();
+
+    if (m_data != nullptr)
+    {
+        munmap(m_data, m_capacity);
+        m_data   = nullptr;
+        m_header = nullptr;
+    }
+
+    if (m_fd != ERROR)
+    {
+        // drop the preallocated tail
+        if (used > 0 && ftruncate(m_fd, static_cast<off_t>(used)) == ERROR)
+        {
+            SetLastError(std::string("access log truncate error: ") + strerror(errno), errno);
+        }
+        close(m_fd);
+        m_fd = ERROR;
+    }
+
+    m_capacity = 0;
+}
+
+bool AccessLog::IsOpen() const
+{
+    return m_data != nullptr;
+}
+
+bool AccessLog::IsFull() const
+{
+    return m_data == nullptr || GetSize() + sizeof(Record) > m_capacity;
+}
+
+bool AccessLog::Append(const Record& record)
+{
+    if (IsFull())
+    {
+        return false;
+    }
+
+    memcpy(m_data + GetSize(), &record, sizeof(Record));
+    m_header->count++;
+
+    return true;
+}
+
+size_t AccessLog::GetSize() const
+{
+    if (m_header == nullptr)
+    {
+        return 0;
+    }
+
+    return sizeof(FileHeader) + m_header->count * sizeof(Record);
+}
+
+size_t AccessLog::GetCount() const
+{
+    return m_header == nullptr ? 0 : m_header->count;
+}
+
+AccessLog::Record AccessLog::MakeRecord(AccessLog::Event event, int connID, const std::string& remote)
+{
+    Record record;
+    memset(&record, 0, sizeof(record));
+
+    auto now      = std::chrono::system_clock::now().time_since_epoch();
+    record.timeUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    record.connID = static_cast<uint32_t>(connID);
+    record.event  = static_cast<uint8_t>(event);
+
+    if (remote.empty())
+    {
+        return record;
+    }
+
+    // "1.2.3.4:80", "[::1]:80" or an address without a port
+    std::string host = remote;
+    int         port = 0;
+    size_t      pos  = remote.rfind(':');
+    if (remote[0] == '[')
+    {
+        size_t end = remote.find(']');
+        host       = remote.substr(1, end == std::string::npos ? std::string::npos : end - 1);
+        if (end != std::string::npos && end + 1 < remote.size() && remote[end + 1] == ':')
+        {
+            port = atoi(remote.c_str() + end + 2);
+        }
+    }
+    else if (pos != std::string::npos && remote.find(':') == pos)
+    {
+        host = remote.substr(0, pos);
+        port = atoi(remote.c_str() + pos + 1);
+    }
+
+    if (inet_pton(AF_INET, host.c_str(), record.address) == 1)
+    {
+        record.family = AF_INET;
+    }
+    else if (inet_pton(AF_INET6, host.c_str(), record.address) == 1)
+    {
+        record.family = AF_INET6;
+    }
+    record.port = static_cast<uint16_t>(port);
+
+    return record;
+}
+
+bool AccessLog::Load(const std::string& file, std::vector<Record>& records)
+{
+    std::ifstream stream(file, std::ifstream::binary);
+    if (!stream)
+    {
+        return false;
+    }
+
+    FileHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.magic, ACCESS_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.recordSize != sizeof(Record))
+    {
+        return false;
+    }
+
+    records.reserve(records.size() + header.count);
+    for (uint64_t i = 0; i < header.count; i++)
+    {
+        Record record;
+        if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            return false;
+        }
+        records.push_back(record);
+    }
+
+    return true;
+}
+
+std::string AccessLog::ToString(const AccessLog::Record& record)
+{
+    char stamp[FileSystem::DATE_TIME_LENGTH + 1];
+    FileSystem::FormatDateTime(static_cast<time_t>(record.timeUs / 1000000), stamp, sizeof(stamp));
+
+    char address[INET6_ADDRSTRLEN] = "-";
+    if (record.family == AF_INET || record.family == AF_INET6)
+    {
+        inet_ntop(record.family, record.address, address, sizeof(address));
+    }
+
+    std::string event;
+    switch (static_cast<Event>(record.event))
+    {
+        case Event::Connect:
+            event = "connect";
+            break;
+        case Event::Disconnect:
+            event = "disconnect";
+            break;
+        default:
+            event = "unknown";
+            break;
+    }
+
+    // the raw microseconds first, so the output can be sorted and diffed
+    std::string result = std::to_string(record.timeUs) + " [" + stamp + "] " + event + " #" + std::to_string(record.connID);
+    if (record.family != 0)
+    {
+        result += std::string(", ") + (record.family == AF_INET6 ? "[" + std::string(address) + "]" : address) + ":" + std::to_string(record.port);
+    }
+
+    return result;
+}
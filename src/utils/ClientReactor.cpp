@@ -0,0 +1,467 @@
+#include "ClientReactor.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "Config.h"
+#include "LogWriter.h"
+
+using namespace WebSocketCpp;
+
+constexpr uint32_t ClientReactor::DEFAULT_EVENTS;
+constexpr uint64_t ClientReactor::WAKE_ID;
+constexpr size_t   ClientReactor::MAX_THREADS;
+
+static uint64_t Now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+ClientReactor::ClientReactor(size_t threads)
+{
+    threads = std::min(std::max<size_t>(threads, 1), MAX_THREADS);
+    for (size_t i = 0; i < threads; i++)
+    {
+        m_loops.emplace_back(new Loop());
+    }
+}
+
+ClientReactor::~ClientReactor()
+{
+    ClientReactor::Close(true);
+    for (auto& loop : m_loops)
+    {
+        if (loop->epollFd >= 0)
+        {
+            close(loop->epollFd);
+            loop->epollFd = -1;
+        }
+        if (loop->wakeFd >= 0)
+        {
+            close(loop->wakeFd);
+            loop->wakeFd = -1;
+        }
+    }
+}
+
+bool ClientReactor::Init()
+{
+    if (IsInitialized())
+    {
+        return true;
+    }
+
+    for (auto& loop : m_loops)
+    {
+        loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epollFd < 0)
+        {
+            SetLastError(std::string("epoll_create1 error: ") + strerror(errno));
+            return false;
+        }
+
+        loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->wakeFd < 0)
+        {
+            SetLastError(std::string("eventfd error: ") + strerror(errno));
+            return false;
+        }
+
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = WAKE_ID;
+        if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &ev) < 0)
+        {
+            SetLastError(std::string("epoll_ctl error: ") + strerror(errno));
+            return false;
+        }
+    }
+
+    setInitialized(true);
+    return true;
+}
+
+bool ClientReactor::Run()
+{
+    if (!IsInitialized())
+    {
+        SetLastError("not initialized");
+        return false;
+    }
+
+    if (IsRunning())
+    {
+        SetLastError("already running");
+        return false;
+    }
+
+    m_loopsRunning = true;
+    for (auto& loop : m_loops)
+    {
+        Loop* ptr    = loop.get();
+        loop->thread = std::thread([this, ptr]() { RunLoop(*ptr); });
+    }
+
+    setRunning(true);
+    return true;
+}
+
+bool ClientReactor::Close(bool wait)
+{
+    m_loopsRunning = false;
+    for (auto& loop : m_loops)
+    {
+        Wake(*loop);
+    }
+    if (wait)
+    {
+        WaitFor();
+    }
+    setRunning(false);
+    return true;
+}
+
+bool ClientReactor::WaitFor()
+{
+    for (auto& loop : m_loops)
+    {
+        if (loop->thread.joinable())
+        {
+            loop->thread.join();
+        }
+    }
+    return true;
+}
+
+bool ClientReactor::Attach(int32_t fd, Handler* handler, uint32_t events)
+{
+    if (!IsInitialized())
+    {
+        SetLastError("not initialized");
+        return false;
+    }
+
+    size_t index = 0;
+    size_t least = SIZE_MAX;
+    for (size_t i = 0; i < m_loops.size(); i++)
+    {
+        std::lock_guard<std::mutex> lock(m_loops[i]->mutex);
+        if (m_loops[i]->handlers.size() < least)
+        {
+            least = m_loops[i]->handlers.size();
+            index = i;
+        }
+    }
+
+    Loop&    loop = *m_loops[index];
+    uint64_t id   = (++m_sequence << LOOP_BITS) | index;
+
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    loop.handlers[id]    = handler;
+    handler->m_reactorId = id;
+    handler->m_lastId    = id;
+    handler->m_deadline  = 0;
+
+    if (fd < 0)
+    {
+        // timers and posted tasks only, the descriptor is added later by Modify()
+        return true;
+    }
+
+    epoll_event ev{};
+    ev.events   = events;
+    ev.data.u64 = id;
+    if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        loop.handlers.erase(id);
+        handler->m_reactorId = 0;
+        SetLastError(std::string("epoll_ctl error: ") + strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool ClientReactor::Modify(Handler* handler, int32_t fd, uint32_t events)
+{
+    uint64_t id = handler->m_reactorId;
+    if (id == 0)
+    {
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events   = events;
+    ev.data.u64 = id;
+    int32_t epollFd = GetLoop(id).epollFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0)
+    {
+        return true;
+    }
+    return errno == ENOENT && epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool ClientReactor::Detach(Handler* handler, int32_t fd)
+{
+    uint64_t id       = handler->m_reactorId.exchange(0);
+    bool     detached = (id != 0);
+    if (!detached)
+    {
+        // detached already, maybe by its own callback that is still running
+        id = handler->m_lastId;
+        if (id == 0)
+        {
+            return false;
+        }
+    }
+
+    Loop&                        loop = GetLoop(id);
+    std::unique_lock<std::mutex> lock(loop.mutex);
+    if (detached)
+    {
+        loop.handlers.erase(id);
+        handler->m_deadline = 0;
+        if (fd >= 0)
+        {
+            epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+    // the loop thread itself is inside the callback, it won't call the handler again
+    if (std::this_thread::get_id() != loop.thread.get_id())
+    {
+        loop.cv.wait(lock, [&loop, id]() { return loop.current != id; });
+    }
+
+    return detached;
+}
+
+bool ClientReactor::SetTimer(Handler* handler, uint64_t timeoutMs)
+{
+    uint64_t id = handler->m_reactorId;
+    if (id == 0)
+    {
+        return false;
+    }
+
+    Loop& loop = GetLoop(id);
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        if (loop.handlers.find(id) == loop.handlers.end())
+        {
+            return false;
+        }
+
+        // a replaced timer stays in the queue, it is skipped since the deadline doesn't match
+        handler->m_deadline = 0;
+        if (timeoutMs > 0)
+        {
+            handler->m_deadline = Now() + timeoutMs * 1000000;
+            loop.timers.emplace(handler->m_deadline, id);
+        }
+    }
+
+    if (std::this_thread::get_id() != loop.thread.get_id())
+    {
+        Wake(loop);
+    }
+    return true;
+}
+
+bool ClientReactor::Post(uint64_t id, Task task)
+{
+    if (id == 0)
+    {
+        return false;
+    }
+
+    Loop& loop = GetLoop(id);
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        if (loop.handlers.find(id) == loop.handlers.end())
+        {
+            return false;
+        }
+        loop.posted.emplace_back(id, std::move(task));
+    }
+
+    Wake(loop);
+    return true;
+}
+
+size_t ClientReactor::GetThreadCount() const
+{
+    return m_loops.size();
+}
+
+size_t ClientReactor::GetHandlerCount() const
+{
+    size_t count = 0;
+    for (auto& loop : m_loops)
+    {
+        std::lock_guard<std::mutex> lock(loop->mutex);
+        count += loop->handlers.size();
+    }
+    return count;
+}
+
+ClientReactor::Loop& ClientReactor::GetLoop(uint64_t id) const
+{
+    return *m_loops[id & (MAX_THREADS - 1)];
+}
+
+void ClientReactor::Wake(Loop& loop)
+{
+    if (loop.wakeFd >= 0)
+    {
+        uint64_t value = 1;
+        ssize_t  ret   = write(loop.wakeFd, &value, sizeof(value));
+        (void)ret;
+    }
+}
+
+int ClientReactor::NextTimeout(Loop& loop)
+{
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    if (!loop.posted.empty())
+    {
+        return 0;
+    }
+    if (loop.timers.empty())
+    {
+        return EPOLL_TIMEOUT_MS;
+    }
+
+    uint64_t now      = Now();
+    uint64_t deadline = loop.timers.begin()->first;
+    if (deadline <= now)
+    {
+        return 0;
+    }
+    uint64_t ms = (deadline - now + 999999) / 1000000;
+    return static_cast<int>(std::min<uint64_t>(ms, EPOLL_TIMEOUT_MS));
+}
+
+template <typename F>
+void ClientReactor::Dispatch(Loop& loop, uint64_t id, F func)
+{
+    Handler* handler = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        auto                        it = loop.handlers.find(id);
+        if (it == loop.handlers.end())
+        {
+            return; // detached by an earlier event of the batch
+        }
+        handler      = it->second;
+        loop.current = id;
+    }
+
+    func(handler);
+
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        loop.current = 0;
+    }
+    loop.cv.notify_all();
+}
+
+void ClientReactor::RunTimers(Loop& loop)
+{
+    std::vector<uint64_t> expired;
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        uint64_t                    now = Now();
+        while (!loop.timers.empty() && loop.timers.begin()->first <= now)
+        {
+            auto timer = loop.timers.begin();
+            auto it    = loop.handlers.find(timer->second);
+            if (it != loop.handlers.end() && it->second->m_deadline == timer->first)
+            {
+                it->second->m_deadline = 0;
+                expired.push_back(timer->second);
+            }
+            loop.timers.erase(timer);
+        }
+    }
+
+    for (uint64_t id : expired)
+    {
+        Dispatch(loop, id, [](Handler* handler) { handler->OnTimer(); });
+    }
+}
+
+void ClientReactor::RunLoop(Loop& loop)
+{
+    epoll_event                            events[MAX_EVENT_COUNT];
+    std::vector<std::pair<uint64_t, Task>> posted;
+
+    while (m_loopsRunning)
+    {
+        int n = epoll_wait(loop.epollFd, events, MAX_EVENT_COUNT, NextTimeout(loop));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG(std::string("epoll_wait error: ") + strerror(errno), LogWriter::LogType::Error);
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t id = events[i].data.u64;
+            if (id == WAKE_ID)
+            {
+                uint64_t value;
+                ssize_t  ret = read(loop.wakeFd, &value, sizeof(value));
+                (void)ret;
+                continue;
+            }
+
+            uint32_t ev = events[i].events;
+            Dispatch(loop, id, [ev](Handler* handler) { handler->OnEvent(ev); });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            posted.swap(loop.posted);
+        }
+        for (auto& task : posted)
+        {
+            Dispatch(loop, task.first, [&task](Handler*) { task.second(); });
+        }
+        posted.clear();
+
+        RunTimers(loop);
+    }
+}
+
+std::shared_ptr<ClientReactor> ClientReactor::Default()
+{
+    static std::mutex                   mutex;
+    static std::weak_ptr<ClientReactor> instance;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto                        reactor = instance.lock();
+    if (reactor == nullptr)
+    {
+        reactor = std::make_shared<ClientReactor>(Config::Instance().GetClientReactorThreads());
+        if (!reactor->Init() || !reactor->Run())
+        {
+            LOG("client reactor start failed: " + reactor->GetLastError(), LogWriter::LogType::Error);
+            return nullptr;
+        }
+        instance = reactor;
+    }
+
+    return reactor;
+}
@@ -4,6 +4,7 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -11,6 +12,7 @@
 #include <cstring>
 
 #include "LogWriter.h"
+#include "Metrics.h"
 #include "common.h"
 
 #ifdef WITH_OPENSSL
@@ -28,10 +30,7 @@ ClientSocket::ClientSocket()
 ClientSocket::~ClientSocket()
 {
     Shutdown();
-    if (m_read_thread.joinable())
-    {
-        m_read_thread.join();
-    }
+    Detach();
     if (m_fd >= 0)
     {
         close(m_fd);
@@ -42,22 +41,20 @@ ClientSocket::~ClientSocket()
 
 bool ClientSocket::Init()
 {
-    if (IsInitialized())
-    {
-        return true;
-    }
-
-    m_epoll_fd = epoll_create1(0);
-    if (m_epoll_fd < 0)
-    {
-        SetLastError(std::string("epoll_create1 error: ") + strerror(errno));
-        return false;
-    }
-
     setInitialized(true);
     return true;
 }
 
+void ClientSocket::SetReactor(std::shared_ptr<ClientReactor> reactor)
+{
+    m_reactor = std::move(reactor);
+}
+
+void ClientSocket::SetResolver(std::shared_ptr<IResolver> resolver)
+{
+    m_resolver = std::move(resolver);
+}
+
 bool ClientSocket::Connect(const std::string& host, int32_t port)
 {
     ClearError();
@@ -73,6 +70,10 @@ bool ClientSocket::Connect(const std::string& host, int32_t port)
         SetLastError("already connected");
         return false;
     }
+#ifdef WITH_OPENSSL
+    m_ssl_host = host;
+    m_ssl_peer = host + ":" + std::to_string(port);
+#endif
 
     struct addrinfo  hints{};
     struct addrinfo* result = nullptr;
@@ -123,30 +124,17 @@ bool ClientSocket::Connect(const std::string& host, int32_t port)
         }
     }
 
-    epoll_event ev{};
-    ev.events  = EPOLLIN | EPOLLERR | EPOLLHUP;
-    ev.data.fd = m_fd;
-    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_fd, &ev) < 0)
-    {
-        SetLastError(std::string("epoll_ctl error: ") + strerror(errno));
-        close(m_fd);
-        m_fd = -1;
-        return false;
-    }
-
 #ifdef WITH_OPENSSL
     if (!m_cert.empty() || !m_key.empty())
     {
         if (!InitSsl())
         {
-            epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, m_fd, nullptr);
             close(m_fd);
             m_fd = -1;
             return false;
         }
         if (!ConnectSsl())
         {
-            epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, m_fd, nullptr);
             close(m_fd);
             m_fd = -1;
             return false;
@@ -154,31 +142,236 @@ bool ClientSocket::Connect(const std::string& host, int32_t port)
     }
 #endif
 
-    m_connected = true;
+    m_connect_state = ConnectState::Connected;
+    m_connected     = true;
     return true;
 }
 
-bool ClientSocket::WaitConnect()
+bool ClientSocket::ConnectAsync(const std::string& host, int32_t port, OnConnectCallback callback, uint64_t timeoutMs)
 {
-    epoll_event ev{};
-    ev.events  = EPOLLOUT | EPOLLERR;
-    ev.data.fd = m_fd;
-    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_fd, &ev);
+    ClearError();
 
-    epoll_event event{};
-    int         n = epoll_wait(m_epoll_fd, &event, 1, CONNECT_TIMEOUT_MS);
+    if (!IsInitialized())
+    {
+        SetLastError("not initialized");
+        return false;
+    }
 
-    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, m_fd, nullptr);
+    if (m_connected || IsRunning())
+    {
+        SetLastError("already connected");
+        return false;
+    }
+
+    if (m_reactor == nullptr)
+    {
+        m_reactor = ClientReactor::Default();
+        if (m_reactor == nullptr)
+        {
+            SetLastError("no client reactor");
+            return false;
+        }
+    }
+    if (m_resolver == nullptr)
+    {
+        m_resolver = ThreadPoolResolver::Default();
+    }
+#ifdef WITH_OPENSSL
+    m_ssl_host = host;
+    m_ssl_peer = host + ":" + std::to_string(port);
+#endif
+
+    m_connect_callback = std::move(callback);
+    m_connect_state    = ConnectState::Resolving;
+    {
+        std::lock_guard<std::mutex> lock(m_run_mutex);
+        setRunning(true);
+    }
+
+    // no descriptor yet, the registration only carries the timer and the resolver answer
+    if (!m_reactor->Attach(-1, this, 0))
+    {
+        std::lock_guard<std::mutex> lock(m_run_mutex);
+        setRunning(false);
+        m_connect_state    = ConnectState::Idle;
+        m_connect_callback = nullptr;
+        SetLastError("attach failed: " + m_reactor->GetLastError());
+        return false;
+    }
+    m_reactor->SetTimer(this, timeoutMs);
+
+    std::shared_ptr<ClientReactor> reactor = m_reactor;
+    uint64_t                       id      = GetReactorId();
+    m_resolver->Resolve(host, port, [this, reactor, id](bool ok, const sockaddr_in& address, const std::string& error) {
+        reactor->Post(id, [this, ok, address, error]() { OnResolved(ok, address, error); });
+    });
+
+    return true;
+}
+
+void ClientSocket::OnResolved(bool ok, const sockaddr_in& address, const std::string& error)
+{
+    if (m_connect_state != ConnectState::Resolving)
+    {
+        return;
+    }
+
+    if (!ok)
+    {
+        ConnectDone(false, error);
+        return;
+    }
+
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd < 0)
+    {
+        ConnectDone(false, std::string("socket creation error: ") + strerror(errno));
+        return;
+    }
+
+    if (connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+    {
+        OnTcpConnected();
+        return;
+    }
+
+    if (errno != EINPROGRESS)
+    {
+        ConnectDone(false, std::string("connect error: ") + strerror(errno));
+        return;
+    }
+
+    m_connect_state = ConnectState::Connecting;
+    if (!m_reactor->Modify(this, m_fd, EPOLLOUT | EPOLLERR | EPOLLHUP))
+    {
+        ConnectDone(false, std::string("epoll_ctl error: ") + strerror(errno));
+    }
+}
+
+void ClientSocket::OnTcpConnected()
+{
+#ifdef WITH_OPENSSL
+    if (!m_cert.empty() || !m_key.empty())
+    {
+        if (!InitSsl())
+        {
+            ConnectDone(false, GetLastError());
+            return;
+        }
+        m_ssl = m_ssl_context->NewSsl(m_ssl_host, &m_ssl_peer);
+        if (!m_ssl)
+        {
+            ConnectDone(false, "SSL_new failed");
+            return;
+        }
+        SSL_set_fd(m_ssl, m_fd);
+        m_connect_state = ConnectState::SslHandshake;
+        ContinueSsl();
+        return;
+    }
+#endif
+
+    ConnectDone(true, "");
+}
+
+void ClientSocket::ConnectDone(bool ok, const std::string& error)
+{
+    m_reactor->SetTimer(this, 0);
+
+    OnConnectCallback callback;
+    callback.swap(m_connect_callback);
+
+    std::string reason = error;
+    if (ok)
+    {
+        m_connect_state = ConnectState::Connected;
+        m_connected     = true;
+        if (!m_reactor->Modify(this, m_fd, ClientReactor::DEFAULT_EVENTS))
+        {
+            ok     = false;
+            reason = std::string("epoll_ctl error: ") + strerror(errno);
+        }
+    }
+    if (!ok)
+    {
+        SetLastError(reason);
+        LOG(std::string("connect failed: ") + reason, LogWriter::LogType::Error);
+        m_connect_state = ConnectState::Idle;
+        m_connected     = false;
+        Detach();
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+        FreeSsl();
+    }
+
+    if (callback)
+    {
+        callback(ok);
+    }
+}
+
+bool ClientSocket::SetTimeout(uint64_t timeoutMs, OnTimeoutCallback callback)
+{
+    if (m_reactor == nullptr || m_connect_state != ConnectState::Connected)
+    {
+        return false;
+    }
+
+    m_timeout_callback = std::move(callback);
+    return m_reactor->SetTimer(this, timeoutMs);
+}
+
+void ClientSocket::OnTimer()
+{
+    if (m_connect_state == ConnectState::Resolving || m_connect_state == ConnectState::Connecting || m_connect_state == ConnectState::SslHandshake)
+    {
+        ConnectDone(false, "connect timeout");
+        return;
+    }
+
+    OnTimeoutCallback callback;
+    callback.swap(m_timeout_callback);
+    if (callback)
+    {
+        callback();
+    }
+}
+
+// the socket isn't attached to the reactor yet, so the connection phase waits on its own
+bool ClientSocket::WaitEvent(short events, const char* what)
+{
+    pollfd pfd{};
+    pfd.fd     = m_fd;
+    pfd.events = events;
+
+    int n;
+    do
+    {
+        n = poll(&pfd, 1, CONNECT_TIMEOUT_MS);
+    } while (n < 0 && errno == EINTR);
 
     if (n == 0)
     {
-        SetLastError("connect timeout");
+        SetLastError(std::string(what) + " timeout");
         return false;
     }
 
     if (n < 0)
     {
-        SetLastError(std::string("epoll_wait error: ") + strerror(errno));
+        SetLastError(std::string("poll error: ") + strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool ClientSocket::WaitConnect()
+{
+    if (!WaitEvent(POLLOUT, "connect"))
+    {
         return false;
     }
 
@@ -214,18 +407,39 @@ bool ClientSocket::Run()
         return false;
     }
 
-    m_read_running = true;
-    m_read_thread  = std::thread(&ClientSocket::ReadLoop, this);
-    setRunning(true);
+    if (m_reactor == nullptr)
+    {
+        m_reactor = ClientReactor::Default();
+        if (m_reactor == nullptr)
+        {
+            SetLastError("no client reactor");
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_run_mutex);
+        setRunning(true);
+    }
+    if (!m_reactor->Attach(m_fd, this))
+    {
+        std::lock_guard<std::mutex> lock(m_run_mutex);
+        setRunning(false);
+        SetLastError("attach failed: " + m_reactor->GetLastError());
+        return false;
+    }
+
     return true;
 }
 
 bool ClientSocket::Close(bool wait)
 {
     Shutdown();
+    Detach();
+    m_connect_state    = ConnectState::Idle;
+    m_connect_callback = nullptr;
     if (wait)
     {
-        WaitFor();
         if (m_fd >= 0)
         {
             close(m_fd);
@@ -236,19 +450,17 @@ bool ClientSocket::Close(bool wait)
     return true;
 }
 
+// blocks until the connection is closed by either side
 bool ClientSocket::WaitFor()
 {
-    if (m_read_thread.joinable())
-    {
-        m_read_thread.join();
-    }
+    std::unique_lock<std::mutex> lock(m_run_mutex);
+    m_run_cv.wait(lock, [this]() { return !IsRunning(); });
     return true;
 }
 
 void ClientSocket::Shutdown()
 {
-    m_connected    = false;
-    m_read_running = false;
+    m_connected = false;
 
     if (m_fd >= 0)
     {
@@ -256,20 +468,31 @@ void ClientSocket::Shutdown()
     }
 }
 
+void ClientSocket::Detach()
+{
+    if (m_reactor != nullptr)
+    {
+        m_reactor->Detach(this, m_fd);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_run_mutex);
+        setRunning(false);
+    }
+    m_run_cv.notify_all();
+}
+
 void ClientSocket::FreeSsl()
 {
 #ifdef WITH_OPENSSL
+    std::lock_guard<std::mutex> lock(m_write_mutex);
     if (m_ssl)
     {
         SSL_shutdown(m_ssl);
         SSL_free(m_ssl);
         m_ssl = nullptr;
     }
-    if (m_ssl_ctx)
-    {
-        SSL_CTX_free(m_ssl_ctx);
-        m_ssl_ctx = nullptr;
-    }
+    m_ssl_context.reset();
 #endif
 }
 
@@ -281,7 +504,8 @@ bool ClientSocket::Write(const uint8_t* data, size_t size)
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(m_write_mutex);
+    std::lock_guard<std::mutex>  send_lock(m_send_mutex);
+    std::unique_lock<std::mutex> lock(m_write_mutex);
 
 #ifdef WITH_OPENSSL
     if (m_ssl)
@@ -289,13 +513,23 @@ bool ClientSocket::Write(const uint8_t* data, size_t size)
         size_t total = 0;
         while (total < size)
         {
+            if (m_ssl == nullptr)
+            {
+                SetLastError("not connected");
+                return false;
+            }
+            ERR_clear_error(); // SSL_get_error() looks at this thread's queue, stale entries turn into SSL_ERROR_SSL
             int sent = SSL_write(m_ssl, data + total, static_cast<int>(size - total));
             if (sent <= 0)
             {
                 int err = SSL_get_error(m_ssl, sent);
-                if (err == SSL_ERROR_WANT_WRITE)
+                if (err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ)
                 {
-                    continue;
+                    if (WaitWritable(lock, err == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN))
+                    {
+                        continue;
+                    }
+                    return false;
                 }
                 SetLastError("SSL_write error");
                 return false;
@@ -306,14 +540,21 @@ bool ClientSocket::Write(const uint8_t* data, size_t size)
     }
 #endif
 
-    size_t  total  = 0;
-    int32_t cur_fd = m_fd;
+    size_t total = 0;
     while (total < size)
     {
-        ssize_t sent = send(cur_fd, data + total, size - total, MSG_NOSIGNAL);
+        ssize_t sent = send(m_fd, data + total, size - total, MSG_NOSIGNAL);
         if (sent < 0)
         {
             if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (WaitWritable(lock, POLLOUT))
+                {
+                    continue;
+                }
+                return false;
+            }
+            if (errno == EINTR)
             {
                 continue;
             }
@@ -326,6 +567,39 @@ bool ClientSocket::Write(const uint8_t* data, size_t size)
     return true;
 }
 
+// waits with the write mutex released so the reactor thread can go on reading,
+// the connection may be closed when the lock is taken back
+bool ClientSocket::WaitWritable(std::unique_lock<std::mutex>& lock, short events)
+{
+    pollfd pfd{m_fd, events, 0};
+    lock.unlock();
+    int ret;
+    do
+    {
+        ret = poll(&pfd, 1, WRITE_TIMEOUT_MS);
+    } while (ret < 0 && errno == EINTR);
+    int error = errno;
+    lock.lock();
+
+    if (!m_connected || m_fd < 0)
+    {
+        SetLastError("not connected");
+        return false;
+    }
+    if (ret == 0)
+    {
+        SetLastError("write timeout");
+        return false;
+    }
+    if (ret < 0)
+    {
+        SetLastError(std::string("poll error: ") + strerror(error));
+        return false;
+    }
+
+    return true;
+}
+
 bool ClientSocket::IsConnected() const
 {
     return m_connected;
@@ -351,79 +625,129 @@ bool ClientSocket::SetNonblocking(int32_t fd)
     return true;
 }
 
-void ClientSocket::ReadLoop()
+void ClientSocket::OnEvent(uint32_t events)
 {
-    epoll_event events[1];
-    uint8_t     buffer[BUFFER_SIZE];
-
-    while (m_read_running)
+    switch (m_connect_state)
     {
-        int n = epoll_wait(m_epoll_fd, events, 1, EPOLL_TIMEOUT_MS);
-
-        if (n < 0)
+        case ConnectState::Connecting:
         {
-            if (errno == EINTR)
+            int       err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0)
             {
-                continue;
+                ConnectDone(false, std::string("connect error: ") + strerror(err));
             }
-            LOG(std::string("epoll_wait error: ") + strerror(errno), LogWriter::LogType::Error);
-            break;
+            else
+            {
+                OnTcpConnected();
+            }
+            return;
         }
+#ifdef WITH_OPENSSL
+        case ConnectState::SslHandshake:
+            ContinueSsl();
+            return;
+#endif
+        case ConnectState::Connected:
+            break;
+        default:
+            return;
+    }
+
+    if (events & (EPOLLERR | EPOLLHUP))
+    {
+        HandleClose();
+        return;
+    }
 
-        if (n == 0)
+    if (events & EPOLLIN)
+    {
+#ifdef WITH_OPENSSL
+        if (m_ssl)
         {
-            continue;
+            ReadSsl();
+            return;
         }
-
-        uint32_t ev = events[0].events;
-
-        if (ev & (EPOLLERR | EPOLLHUP))
+#endif
+        uint8_t buffer[BUFFER_SIZE];
+        ssize_t size = read(m_fd, buffer, BUFFER_SIZE);
+        if (size == 0 || (size < 0 && errno != EAGAIN))
         {
             HandleClose();
-            break;
+            return;
         }
 
-        if (ev & EPOLLIN)
+        if (size > 0)
         {
-            ssize_t size = 0;
+            if (m_data_callback)
+            {
+                m_data_callback(ByteArray(buffer, buffer + size));
+            }
+        }
+    }
+}
+
 #ifdef WITH_OPENSSL
-            if (m_ssl)
+// drains what OpenSSL already decrypted, epoll won't report it again
+void ClientSocket::ReadSsl()
+{
+    if (m_read_buffer.size() < SSL_BUFFER_SIZE)
+    {
+        m_read_buffer.resize(SSL_BUFFER_SIZE);
+    }
+
+    while (true)
+    {
+        size_t size    = 0;
+        int    err     = SSL_ERROR_NONE;
+        bool   pending = false;
+        {
+            // SSL_read() and SSL_write() can't run on one SSL at the same time,
+            // the callback below may write so it's called without the lock
+            std::lock_guard<std::mutex> lock(m_write_mutex);
+            if (m_ssl == nullptr)
             {
-                size = SSL_read(m_ssl, buffer, static_cast<int>(BUFFER_SIZE));
-                if (size <= 0)
-                {
-                    int err = SSL_get_error(m_ssl, static_cast<int>(size));
-                    if (err != SSL_ERROR_WANT_READ)
-                    {
-                        HandleClose();
-                        break;
-                    }
-                    continue;
-                }
+                return;
             }
-            else
-#endif
+            while (size < SSL_BUFFER_SIZE)
             {
-                size = read(m_fd, buffer, BUFFER_SIZE);
-                if (size == 0 || (size < 0 && errno != EAGAIN))
+                ERR_clear_error();
+                int ret = SSL_read(m_ssl, m_read_buffer.data() + size, static_cast<int>(SSL_BUFFER_SIZE - size));
+                if (ret <= 0)
+                {
+                    err = SSL_get_error(m_ssl, ret);
+                    break;
+                }
+                size += static_cast<size_t>(ret);
+                if (SSL_pending(m_ssl) == 0)
                 {
-                    HandleClose();
                     break;
                 }
             }
+            pending = (SSL_pending(m_ssl) > 0);
+        }
 
-            if (size > 0)
+        if (size > 0 && m_data_callback)
+        {
+            m_data_callback(ByteArray(m_read_buffer.begin(), m_read_buffer.begin() + size));
+        }
+
+        if (err != SSL_ERROR_NONE)
+        {
+            if (err != SSL_ERROR_WANT_READ)
             {
-                if (m_data_callback)
-                {
-                    m_data_callback(ByteArray(buffer, buffer + size));
-                }
+                HandleClose();
             }
+            return;
+        }
+        if (!pending)
+        {
+            return;
         }
     }
-
-    setRunning(false);
 }
+#endif
 
 void ClientSocket::HandleClose()
 {
@@ -434,6 +758,7 @@ void ClientSocket::HandleClose()
             m_close_callback();
         }
     }
+    Detach();
 }
 
 #ifdef WITH_OPENSSL
@@ -445,44 +770,20 @@ void ClientSocket::SetSslCredentials(const std::string& cert, const std::string&
 
 bool ClientSocket::InitSsl()
 {
-    OpenSSL_add_all_algorithms();
-    SSL_load_error_strings();
-
-    m_ssl_ctx = SSL_CTX_new(TLS_client_method());
-    if (!m_ssl_ctx)
+    std::string error;
+    m_ssl_context = SslClientContext::Get(m_cert, m_key, error);
+    if (m_ssl_context == nullptr)
     {
-        SetLastError("SSL_CTX_new failed");
+        SetLastError(error);
         return false;
     }
 
-    if (!m_cert.empty())
-    {
-        if (SSL_CTX_use_certificate_file(m_ssl_ctx, m_cert.c_str(), SSL_FILETYPE_PEM) <= 0)
-        {
-            SetLastError("SSL_CTX_use_certificate_file failed");
-            SSL_CTX_free(m_ssl_ctx);
-            m_ssl_ctx = nullptr;
-            return false;
-        }
-    }
-
-    if (!m_key.empty())
-    {
-        if (SSL_CTX_use_PrivateKey_file(m_ssl_ctx, m_key.c_str(), SSL_FILETYPE_PEM) <= 0)
-        {
-            SetLastError("SSL_CTX_use_PrivateKey_file failed");
-            SSL_CTX_free(m_ssl_ctx);
-            m_ssl_ctx = nullptr;
-            return false;
-        }
-    }
-
     return true;
 }
 
 bool ClientSocket::ConnectSsl()
 {
-    m_ssl = SSL_new(m_ssl_ctx);
+    m_ssl = m_ssl_context->NewSsl(m_ssl_host, &m_ssl_peer);
     if (!m_ssl)
     {
         SetLastError("SSL_new failed");
@@ -493,34 +794,20 @@ bool ClientSocket::ConnectSsl()
 
     while (true)
     {
+        ERR_clear_error();
         int ret = SSL_connect(m_ssl);
         if (ret == 1)
         {
-            epoll_event ev{};
-            ev.events  = EPOLLIN | EPOLLERR | EPOLLHUP;
-            ev.data.fd = m_fd;
-            epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, m_fd, &ev);
             break;
         }
 
         int err = SSL_get_error(m_ssl, ret);
         if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
         {
-            uint32_t    want_ev = (err == SSL_ERROR_WANT_WRITE) ? (EPOLLOUT | EPOLLERR) : (EPOLLIN | EPOLLERR);
-            epoll_event ev{};
-            ev.events  = want_ev;
-            ev.data.fd = m_fd;
-            epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, m_fd, &ev);
-
-            epoll_event event{};
-            int         n = epoll_wait(m_epoll_fd, &event, 1, CONNECT_TIMEOUT_MS);
-            if (n <= 0)
+            if (!WaitEvent(err == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN, "SSL_connect"))
             {
-                SetLastError(n == 0 ? "SSL_connect timeout" : "SSL_connect epoll_wait error");
                 SSL_free(m_ssl);
                 m_ssl = nullptr;
-                SSL_CTX_free(m_ssl_ctx);
-                m_ssl_ctx = nullptr;
                 return false;
             }
             continue;
@@ -529,13 +816,44 @@ bool ClientSocket::ConnectSsl()
         SetLastError("SSL_connect failed");
         SSL_free(m_ssl);
         m_ssl = nullptr;
-        SSL_CTX_free(m_ssl_ctx);
-        m_ssl_ctx = nullptr;
         return false;
     }
 
+    if (SSL_session_reused(m_ssl))
+    {
+        Metrics::Instance().Add(Metrics::Counter::ClientTlsResumed);
+    }
+
     return true;
 }
+
+void ClientSocket::ContinueSsl()
+{
+    ERR_clear_error();
+    int ret = SSL_connect(m_ssl);
+    if (ret == 1)
+    {
+        if (SSL_session_reused(m_ssl))
+        {
+            Metrics::Instance().Add(Metrics::Counter::ClientTlsResumed);
+        }
+        ConnectDone(true, "");
+        return;
+    }
+
+    int err = SSL_get_error(m_ssl, ret);
+    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+    {
+        uint32_t events = (err == SSL_ERROR_WANT_WRITE ? EPOLLOUT : EPOLLIN) | EPOLLERR | EPOLLHUP;
+        if (!m_reactor->Modify(this, m_fd, events))
+        {
+            ConnectDone(false, std::string("epoll_ctl error: ") + strerror(errno));
+        }
+        return;
+    }
+
+    ConnectDone(false, "SSL_connect failed");
+}
 #endif
 
 } // namespace WebSocketCpp
@@ -15,46 +15,44 @@ static inline bool is_base64(unsigned char c)
 
 std::string Data::Base64Encode(const unsigned char* bytes_to_encode, size_t in_len)
 {
-    std::string   ret;
-    int           i = 0;
-    int           j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
+    std::string ret(Base64EncodedLength(in_len), '\0');
+    Base64Encode(bytes_to_encode, in_len, &ret[0]);
+    return ret;
+}
 
-    while (in_len--)
-    {
-        char_array_3[i++] = *(bytes_to_encode++);
-        if (i == 3)
-        {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
+size_t Data::Base64Encode(const uint8_t* in, size_t in_len, char* out)
+{
+    static const char table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        "abcdefghijklmnopqrstuvwxyz"
+        "0123456789+/";
 
-            for (i = 0; (i < 4); i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
+    char* p = out;
+    while (in_len >= 3)
+    {
+        uint32_t n = (static_cast<uint32_t>(in[0]) << 16) | (static_cast<uint32_t>(in[1]) << 8) | in[2];
+        *p++       = table[(n >> 18) & 0x3f];
+        *p++       = table[(n >> 12) & 0x3f];
+        *p++       = table[(n >> 6) & 0x3f];
+        *p++       = table[n & 0x3f];
+        in += 3;
+        in_len -= 3;
     }
 
-    if (i)
+    if (in_len > 0)
     {
-        for (j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-
-        for (j = 0; (j < i + 1); j++)
-            ret += base64_chars[char_array_4[j]];
-
-        while ((i++ < 3))
-            ret += '=';
+        uint32_t n = static_cast<uint32_t>(in[0]) << 16;
+        if (in_len == 2)
+        {
+            n |= static_cast<uint32_t>(in[1]) << 8;
+        }
+        *p++ = table[(n >> 18) & 0x3f];
+        *p++ = table[(n >> 12) & 0x3f];
+        *p++ = (in_len == 2) ? table[(n >> 6) & 0x3f] : '=';
+        *p++ = '=';
     }
 
-    return ret;
+    return p - out;
 }
 
 std::string Data::Base64Encode(const std::string& str)
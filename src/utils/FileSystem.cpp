@@ -5,6 +5,7 @@
 #include <unistd.h>
 
 #include <climits>
+#include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <iostream>
@@ -302,16 +303,76 @@ bool FileSystem::DeleteFolder(const std::string& path)
     }
 }
 
+bool FileSystem::RotateFile(const std::string& path, size_t keep)
+{
+    // file -> file.1 -> file.2 ... the oldest one is removed
+    std::string oldest = path + "." + std::to_string(keep);
+    if (keep == 0)
+    {
+        oldest = path;
+    }
+    if (IsFileExist(oldest) && unlink(oldest.c_str()) != 0)
+    {
+        return false;
+    }
+
+    for (size_t i = keep; i > 1; i--)
+    {
+        std::string from = path + "." + std::to_string(i - 1);
+        if (IsFileExist(from) && rename(from.c_str(), (path + "." + std::to_string(i)).c_str()) != 0)
+        {
+            return false;
+        }
+    }
+
+    if (keep > 0 && IsFileExist(path))
+    {
+        return rename(path.c_str(), (path + ".1").c_str()) == 0;
+    }
+
+    return true;
+}
+
+constexpr size_t FileSystem::DATE_TIME_LENGTH;
+
 std::string FileSystem::GetDateTime()
 {
-    time_t    tm;
-    struct tm tmbuf{};
-    char      buffer[30];
+    char   buffer[DATE_TIME_LENGTH + 1];
+    size_t size = GetDateTime(buffer, sizeof(buffer));
+    return std::string(buffer, size);
+}
+
+size_t FileSystem::GetDateTime(char* buffer, size_t size)
+{
+    // the string changes once a second, so each thread formats it only when the second turns over
+    static thread_local time_t cachedTime = 0;
+    static thread_local char   cached[DATE_TIME_LENGTH + 1];
+    static thread_local size_t cachedSize = 0;
+
+    if (size == 0)
+    {
+        return 0;
+    }
 
-    time(&tm);
-    gmtime_r(&tm, &tmbuf);
-    strftime(buffer, 30, "%a, %d %b %Y %H:%M:%S GMT", &tmbuf);
-    return buffer;
+    time_t now = time(nullptr);
+    if (now != cachedTime || cachedSize == 0)
+    {
+        cachedSize = FormatDateTime(now, cached, sizeof(cached));
+        cachedTime = now;
+    }
+
+    size_t len = cachedSize < size ? cachedSize : size - 1;
+    memcpy(buffer, cached, len);
+    buffer[len] = '\0';
+
+    return len;
+}
+
+size_t FileSystem::FormatDateTime(time_t time, char* buffer, size_t size)
+{
+    struct tm tmbuf{};
+    gmtime_r(&time, &tmbuf);
+    return strftime(buffer, size, "%a, %d %b %Y %H:%M:%S GMT", &tmbuf);
 }
 
 std::string FileSystem::GetFileModifiedTime(const std::string& file)
@@ -1,15 +1,28 @@
 #include "LogWriter.h"
 
+#include <chrono>
 #include <cstring>
 #include <iostream>
 
+#include "Config.h"
 #include "DebugPrint.h"
 #include "FileSystem.h"
 
-#define DEFAULT_FOLDER "/var/log/webcpp"
+#define ACCESS_BINARY_FILE "access.bin"
+
+constexpr size_t LogWriter::LOG_TYPE_COUNT;
+constexpr size_t LogWriter::QUEUE_CAPACITY;
+constexpr size_t LogWriter::BATCH_SIZE;
+constexpr int    LogWriter::FLUSH_INTERVAL_MS;
 
 LogWriter::~LogWriter()
 {
+    m_thread.StopNoWait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_all();
+    }
+    m_thread.Wait();
     Close();
 }
 
@@ -19,36 +32,138 @@ LogWriter& LogWriter::Instance()
     return instance;
 }
 
-void LogWriter::Write(const std::string& text, LogWriter::LogType type)
+void LogWriter::Write(std::string text, LogWriter::LogType type)
 {
-    std::string s      = "[" + WebSocketCpp::FileSystem::GetDateTime() + "] " + text;
-    auto&       stream = m_streams[static_cast<int>(type)];
-    if (stream.is_open())
+    Entry entry;
+    entry.type = type;
+    entry.time = time(nullptr);
+    entry.text = std::move(text);
+
+    if (!m_queue.TryPush(std::move(entry)))
     {
-        stream << s << std::endl;
+        m_dropped[static_cast<int>(type)].fetch_add(1, std::memory_order_relaxed);
+        return;
     }
 
-    WebSocketCpp::DebugPrint() << text << std::endl;
+    m_pushed.fetch_add(1);
+    if (m_sleeping.load())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_one();
+    }
+}
+
+void LogWriter::WriteAccess(WebSocketCpp::AccessLog::Event event, int connID, const std::string& remote)
+{
+    if (!m_binaryAccess.load(std::memory_order_relaxed))
+    {
+        std::string text = event == WebSocketCpp::AccessLog::Event::Connect
+                               ? std::string("client connected: #") + std::to_string(connID) + ", " + remote
+                               : std::string("websocket connection closed: #") + std::to_string(connID);
+        Write(std::move(text), LogType::Access);
+        return;
+    }
+
+    if (!m_accessQueue.TryPush(WebSocketCpp::AccessLog::MakeRecord(event, connID, remote)))
+    {
+        m_dropped[static_cast<int>(LogType::Access)].fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_pushed.fetch_add(1);
+    if (m_sleeping.load())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_one();
+    }
+}
+
+void LogWriter::Reopen()
+{
+    m_reopen.store(true);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_condition.notify_one();
+}
+
+void LogWriter::Flush()
+{
+    uint64_t target = m_pushed.load();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_one();
+    }
+
+    while (m_thread.IsRunning() && (m_written.load() < target || m_reopen.load()))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool LogWriter::IsEnabled(LogWriter::LogType type) const
+{
+    return m_enabled[static_cast<int>(type)].load(std::memory_order_relaxed);
+}
+
+void LogWriter::SetEnabled(LogWriter::LogType type, bool enabled)
+{
+    m_enabled[static_cast<int>(type)].store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t LogWriter::GetDropped(LogWriter::LogType type) const
+{
+    return m_dropped[static_cast<int>(type)].load(std::memory_order_relaxed);
 }
 
 LogWriter::LogWriter()
 {
+    for (size_t i = 0; i < LOG_TYPE_COUNT; i++)
+    {
+        m_enabled[i].store(true);
+        m_dropped[i].store(0);
+        m_sizes[i]     = 0;
+        m_openTimes[i] = 0;
+    }
+
     m_opened = Open();
+
+    m_thread.SetFunction(std::bind(&LogWriter::WriterThread, this, std::placeholders::_1));
+    m_thread.Start();
 }
 
 bool LogWriter::Open()
 {
+    auto& config     = WebSocketCpp::Config::Instance();
+    m_folder         = config.GetLogFolder();
+    m_maxFileSize    = config.GetLogMaxFileSize();
+    m_rotateInterval = config.GetLogRotateIntervalSec();
+    m_maxFiles       = config.GetLogMaxFiles();
+
     try
     {
-        if (WebSocketCpp::FileSystem::CreateFolder(DEFAULT_FOLDER))
+        if (!WebSocketCpp::FileSystem::CreateFolder(m_folder))
         {
-            for (int i = 0; i < 3; i++)
-            {
-                LogType     type = static_cast<LogType>(i);
-                std::string file = std::string(DEFAULT_FOLDER) + "/" + LogWriter::LogType2String(type) + ".log";
-                m_streams[i].open(file, std::ofstream::binary | std::ios::app);
-            }
+            return false;
+        }
+
+        time_t now = time(nullptr);
+        for (size_t i = 0; i < LOG_TYPE_COUNT; i++)
+        {
+            std::string file = GetFileName(i);
+            int         size = WebSocketCpp::FileSystem::GetFileSize(file);
+            m_streams[i].open(file, std::ofstream::binary | std::ios::app);
+            m_sizes[i]     = size > 0 ? static_cast<size_t>(size) : 0;
+            m_openTimes[i] = now;
+        }
+
+        bool binary = false;
+        if (config.GetLogBinaryAccess())
+        {
+            size_t capacity  = m_maxFileSize > 0 ? m_maxFileSize : WebSocketCpp::AccessLog::DEFAULT_SIZE;
+            binary           = m_accessLog.Open(m_folder + "/" + ACCESS_BINARY_FILE, capacity);
+            m_accessOpenTime = now;
         }
+        m_binaryAccess.store(binary);
 
         return true;
     }
@@ -62,7 +177,7 @@ bool LogWriter::Close()
 {
     try
     {
-        for (int i = 0; i < 3; i++)
+        for (size_t i = 0; i < LOG_TYPE_COUNT; i++)
         {
             auto& stream = m_streams[i];
             if (stream)
@@ -70,6 +185,7 @@ bool LogWriter::Close()
                 stream.close();
             }
         }
+        m_accessLog.Close();
 
         return true;
     }
@@ -79,6 +195,169 @@ bool LogWriter::Close()
     }
 }
 
+void* LogWriter::WriterThread(std::atomic<bool>& running)
+{
+    while (running)
+    {
+        if (m_reopen.exchange(false))
+        {
+            while (WriteBatch() > 0)
+            {
+            }
+            Close();
+            m_opened = Open();
+        }
+
+        if (WriteBatch() > 0)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true);
+        if (running && m_pushed.load() == m_written.load())
+        {
+            m_condition.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+        }
+        m_sleeping.store(false);
+    }
+
+    // drain what was queued before the stop
+    while (WriteBatch() > 0)
+    {
+    }
+
+    return nullptr;
+}
+
+size_t LogWriter::WriteBatch()
+{
+    Entry        entry;
+    AccessRecord record;
+    size_t       count = 0;
+    time_t       now   = time(nullptr);
+
+    while (count < BATCH_SIZE && m_queue.TryPop(entry))
+    {
+        if (entry.time != m_stampTime || m_stampSize == 0)
+        {
+            m_stampTime = entry.time;
+            m_stampSize = WebSocketCpp::FileSystem::FormatDateTime(entry.time, m_stamp, sizeof(m_stamp));
+        }
+
+        std::string& buffer = m_buffers[static_cast<int>(entry.type)];
+        buffer += '[';
+        buffer.append(m_stamp, m_stampSize);
+        buffer += "] ";
+        buffer += entry.text;
+        buffer += '\n';
+
+        if (WebSocketCpp::DebugPrint::AllowPrint)
+        {
+            m_console += entry.text;
+            m_console += '\n';
+        }
+
+        count++;
+    }
+
+    size_t records = 0;
+    while (records < BATCH_SIZE && m_accessQueue.TryPop(record))
+    {
+        WriteRecord(record, now);
+        records++;
+    }
+
+    if (count == 0 && records == 0)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < LOG_TYPE_COUNT; i++)
+    {
+        auto& buffer = m_buffers[i];
+        auto& stream = m_streams[i];
+        if (!buffer.empty() && stream.is_open())
+        {
+            if (NeedRotate(i, buffer.size(), now))
+            {
+                Rotate(i, now);
+            }
+            stream.write(buffer.data(), buffer.size());
+            stream.flush();
+            m_sizes[i] += buffer.size();
+        }
+        buffer.clear();
+    }
+
+    if (!m_console.empty())
+    {
+        WebSocketCpp::DebugPrint() << m_console << std::flush;
+        m_console.clear();
+    }
+
+    m_written.fetch_add(count + records);
+
+    return count + records;
+}
+
+void LogWriter::WriteRecord(const AccessRecord& record, time_t now)
+{
+    if (m_accessLog.IsOpen())
+    {
+        bool expired = m_rotateInterval > 0 && static_cast<uint64_t>(now - m_accessOpenTime) >= m_rotateInterval;
+        if ((m_accessLog.IsFull() || expired) && m_accessLog.GetCount() > 0)
+        {
+            std::string file = m_folder + "/" + ACCESS_BINARY_FILE;
+            m_accessLog.Close();
+            WebSocketCpp::FileSystem::RotateFile(file, m_maxFiles);
+            m_accessLog.Open(file, m_maxFileSize > 0 ? m_maxFileSize : WebSocketCpp::AccessLog::DEFAULT_SIZE);
+            m_accessOpenTime = now;
+        }
+
+        if (m_accessLog.Append(record))
+        {
+            return;
+        }
+    }
+
+    // the binary log is gone (switched off or failed to open), keep the record as text
+    std::string& buffer = m_buffers[static_cast<int>(LogType::Access)];
+    buffer += WebSocketCpp::AccessLog::ToString(record);
+    buffer += '\n';
+}
+
+bool LogWriter::NeedRotate(size_t index, size_t pending, time_t now) const
+{
+    if (m_sizes[index] == 0)
+    {
+        return false;
+    }
+
+    if (m_maxFileSize > 0 && m_sizes[index] + pending > m_maxFileSize)
+    {
+        return true;
+    }
+
+    return m_rotateInterval > 0 && static_cast<uint64_t>(now - m_openTimes[index]) >= m_rotateInterval;
+}
+
+void LogWriter::Rotate(size_t index, time_t now)
+{
+    std::string file = GetFileName(index);
+
+    m_streams[index].close();
+    WebSocketCpp::FileSystem::RotateFile(file, m_maxFiles);
+    m_streams[index].open(file, std::ofstream::binary | std::ios::trunc);
+    m_sizes[index]     = 0;
+    m_openTimes[index] = now;
+}
+
+std::string LogWriter::GetFileName(size_t index) const
+{
+    return m_folder + "/" + LogType2String(static_cast<LogType>(index)) + ".log";
+}
+
 std::string LogWriter::LogType2String(LogWriter::LogType type)
 {
     switch (type)
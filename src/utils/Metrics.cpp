@@ -0,0 +1,373 @@
+#include "Metrics.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace WebSocketCpp;
+
+constexpr size_t Metrics::COUNTER_COUNT;
+constexpr size_t Metrics::GAUGE_COUNT;
+constexpr size_t Metrics::HISTOGRAM_COUNT;
+constexpr size_t Metrics::SUB_BUCKET_BITS;
+constexpr size_t Metrics::SUB_BUCKETS;
+constexpr size_t Metrics::BUCKET_COUNT;
+constexpr size_t Metrics::MAX_SLOTS;
+
+namespace
+{
+
+struct MetricInfo
+{
+    const char* name;
+    const char* labels;
+    const char* help;
+};
+
+// the entries with the same name must follow each other, they share HELP and TYPE
+const MetricInfo COUNTER_INFO[Metrics::COUNTER_COUNT] = {
+    {"websocketcpp_accepts_total", "", "Accepted TCP connections"},
+    {"websocketcpp_accept_errors_total", "", "Connections refused or failed to accept"},
+    {"websocketcpp_handshakes_total", "", "Completed WebSocket handshakes"},
+    {"websocketcpp_handshake_errors_total", "", "Rejected WebSocket handshakes"},
+    {"websocketcpp_parse_errors_total", "", "Malformed HTTP requests"},
+    {"websocketcpp_bytes_in_total", "", "Bytes read from the sockets"},
+    {"websocketcpp_bytes_out_total", "", "Bytes written to the sockets"},
+    {"websocketcpp_frames_in_total", "opcode=\"text\"", "Parsed incoming frames"},
+    {"websocketcpp_frames_in_total", "opcode=\"binary\"", ""},
+    {"websocketcpp_frames_in_total", "opcode=\"close\"", ""},
+    {"websocketcpp_frames_in_total", "opcode=\"ping\"", ""},
+    {"websocketcpp_frames_in_total", "opcode=\"pong\"", ""},
+    {"websocketcpp_frames_in_total", "opcode=\"other\"", ""},
+    {"websocketcpp_frames_out_total", "opcode=\"text\"", "Sent frames"},
+    {"websocketcpp_frames_out_total", "opcode=\"binary\"", ""},
+    {"websocketcpp_frames_out_total", "opcode=\"close\"", ""},
+    {"websocketcpp_frames_out_total", "opcode=\"ping\"", ""},
+    {"websocketcpp_frames_out_total", "opcode=\"pong\"", ""},
+    {"websocketcpp_frames_out_total", "opcode=\"other\"", ""},
+    {"websocketcpp_metrics_requests_total", "", "Served metrics requests"},
+    {"websocketcpp_client_reconnect_attempts_total", "", "Connection attempts of the reconnecting clients"},
+    {"websocketcpp_client_reconnects_total", "", "Client connections restored after a drop"},
+    {"websocketcpp_client_send_queue_dropped_total", "", "Client messages refused since the send queue was full"},
+    {"websocketcpp_tls_connections_total", "offload=\"kernel\"", "Established TLS connections by where the records are encrypted"},
+    {"websocketcpp_tls_connections_total", "offload=\"none\"", ""},
+    {"websocketcpp_tls_resumed_total", "side=\"server\"", "TLS handshakes that resumed a session"},
+    {"websocketcpp_tls_resumed_total", "side=\"client\"", ""},
+    {"websocketcpp_timeouts_total", "timer=\"handshake\"", "Connections closed since a deadline passed"},
+    {"websocketcpp_timeouts_total", "timer=\"idle\"", ""},
+    {"websocketcpp_timeouts_total", "timer=\"pong\"", ""},
+};
+
+const MetricInfo GAUGE_INFO[Metrics::GAUGE_COUNT] = {
+    {"websocketcpp_connections", "", "Open connections"},
+    {"websocketcpp_connection_queue_depth", "", "Socket events waiting for the connection threads"},
+    {"websocketcpp_request_queue_depth", "", "Parsed frames waiting for the handlers"},
+    {"websocketcpp_memory_pool_used_bytes", "", "Bytes allocated from the read buffer pools"},
+    {"websocketcpp_memory_pool_total_bytes", "", "Capacity of the read buffer pools"},
+};
+
+const MetricInfo HISTOGRAM_INFO[Metrics::HISTOGRAM_COUNT] = {
+    {"websocketcpp_handshake_latency_seconds", "", "Time to process a handshake request"},
+    {"websocketcpp_handler_latency_seconds", "", "Time spent in the message handlers"},
+    {"websocketcpp_message_size_bytes", "", "Size of the incoming messages"},
+    {"websocketcpp_trace_stage_seconds", "stage=\"read\"", "Sampled per message latency of the processing stages"},
+    {"websocketcpp_trace_stage_seconds", "stage=\"connection_queue\"", ""},
+    {"websocketcpp_trace_stage_seconds", "stage=\"dispatch\"", ""},
+    {"websocketcpp_trace_stage_seconds", "stage=\"signal\"", ""},
+    {"websocketcpp_trace_stage_seconds", "stage=\"parse\"", ""},
+    {"websocketcpp_trace_stage_seconds", "stage=\"handler_queue\"", ""},
+    {"websocketcpp_trace_stage_seconds", "stage=\"handler\"", ""},
+    {"websocketcpp_trace_stage_seconds", "stage=\"total\"", ""},
+    {"websocketcpp_client_reconnect_seconds", "", "Time from a client connection drop until it is open again"},
+};
+
+const double HISTOGRAM_SCALE[Metrics::HISTOGRAM_COUNT] = {1e-9, 1e-9, 1.0, 1e-9, 1e-9, 1e-9, 1e-9, 1e-9, 1e-9, 1e-9, 1e-9, 1e-9};
+
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+void AppendValue(std::string& out, const char* name, const char* suffix, const std::string& labels, const std::string& value)
+{
+    out += name;
+    out += suffix;
+    if (!labels.empty())
+    {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+std::string FormatDouble(double value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+} // namespace
+
+Metrics::Slot::Slot()
+{
+    for (auto& counter : counters)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto& gauge : gauges)
+    {
+        gauge.store(0, std::memory_order_relaxed);
+    }
+    for (auto& histogram : histograms)
+    {
+        for (auto& bucket : histogram.buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        histogram.sum.store(0, std::memory_order_relaxed);
+    }
+}
+
+Metrics::Metrics()
+{
+    for (auto& slot : m_slots)
+    {
+        slot.store(nullptr);
+    }
+}
+
+Metrics& Metrics::Instance()
+{
+    // never destroyed, the threads still running at exit keep updating their slots
+    static Metrics* instance = new Metrics();
+    return *instance;
+}
+
+Metrics::Slot* Metrics::AcquireSlot()
+{
+    auto& entry = m_slots[m_nextSlot.fetch_add(1, std::memory_order_relaxed) % MAX_SLOTS];
+
+    Slot* slot = entry.load(std::memory_order_acquire);
+    if (slot == nullptr)
+    {
+        // plain new ignores alignas(64) before C++17
+        void* memory = nullptr;
+        if (posix_memalign(&memory, alignof(Slot), sizeof(Slot)) != 0)
+        {
+            throw std::bad_alloc(); // the same as new would do
+        }
+
+        Slot* created = new (memory) Slot();
+        if (entry.compare_exchange_strong(slot, created, std::memory_order_acq_rel))
+        {
+            slot = created;
+        }
+        else
+        {
+            created->~Slot(); // another thread was faster, `slot` holds its one
+            free(memory);
+        }
+    }
+
+    return slot;
+}
+
+Metrics::Snapshot Metrics::GetSnapshot() const
+{
+    Snapshot snapshot;
+    memset(snapshot.counters, 0, sizeof(snapshot.counters));
+    memset(snapshot.gauges, 0, sizeof(snapshot.gauges));
+    for (auto& histogram : snapshot.histograms)
+    {
+        histogram.buckets.assign(BUCKET_COUNT, 0);
+    }
+
+    for (auto& entry : m_slots)
+    {
+        const Slot* slot = entry.load(std::memory_order_acquire);
+        if (slot == nullptr)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < COUNTER_COUNT; i++)
+        {
+            snapshot.counters[i] += slot->counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < GAUGE_COUNT; i++)
+        {
+            snapshot.gauges[i] += slot->gauges[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < HISTOGRAM_COUNT; i++)
+        {
+            auto& data = snapshot.histograms[i];
+            for (size_t b = 0; b < BUCKET_COUNT; b++)
+            {
+                uint64_t count = slot->histograms[i].buckets[b].load(std::memory_order_relaxed);
+                data.buckets[b] += count;
+                data.count += count;
+            }
+            data.sum += slot->histograms[i].sum.load(std::memory_order_relaxed);
+        }
+    }
+
+    return snapshot;
+}
+
+std::string Metrics::ToPrometheus() const
+{
+    Snapshot    snapshot = GetSnapshot();
+    std::string out;
+    const char* last = nullptr;
+
+    for (size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        auto& info = COUNTER_INFO[i];
+        if (last == nullptr || strcmp(last, info.name) != 0)
+        {
+            out += std::string("# HELP ") + info.name + " " + info.help + "\n";
+            out += std::string("# TYPE ") + info.name + " counter\n";
+            last = info.name;
+        }
+        AppendValue(out, info.name, "", info.labels, std::to_string(snapshot.counters[i]));
+    }
+
+    for (size_t i = 0; i < GAUGE_COUNT; i++)
+    {
+        auto& info = GAUGE_INFO[i];
+        out += std::string("# HELP ") + info.name + " " + info.help + "\n";
+        out += std::string("# TYPE ") + info.name + " gauge\n";
+        AppendValue(out, info.name, "", info.labels, std::to_string(snapshot.gauges[i]));
+    }
+
+    last = nullptr;
+    for (size_t i = 0; i < HISTOGRAM_COUNT; i++)
+    {
+        auto&       info   = HISTOGRAM_INFO[i];
+        auto&       data   = snapshot.histograms[i];
+        std::string labels = info.labels;
+        if (last == nullptr || strcmp(last, info.name) != 0)
+        {
+            out += std::string("# HELP ") + info.name + " " + info.help + "\n";
+            out += std::string("# TYPE ") + info.name + " summary\n";
+            last = info.name;
+        }
+        for (double quantile : QUANTILES)
+        {
+            AppendValue(out, info.name, "", (labels.empty() ? "" : labels + ",") + "quantile=\"" + FormatDouble(quantile) + "\"",
+                        FormatDouble(static_cast<double>(data.Percentile(quantile * 100.0)) * HISTOGRAM_SCALE[i]));
+        }
+        AppendValue(out, info.name, "_sum", labels, FormatDouble(static_cast<double>(data.sum) * HISTOGRAM_SCALE[i]));
+        AppendValue(out, info.name, "_count", labels, std::to_string(data.count));
+    }
+
+    return out;
+}
+
+Metrics::Counter Metrics::FrameCounter(MessageType type, bool incoming)
+{
+    Counter counter;
+    switch (type)
+    {
+        case MessageType::Text:
+            counter = Counter::FramesInText;
+            break;
+        case MessageType::Binary:
+            counter = Counter::FramesInBinary;
+            break;
+        case MessageType::Close:
+            counter = Counter::FramesInClose;
+            break;
+        case MessageType::Ping:
+            counter = Counter::FramesInPing;
+            break;
+        case MessageType::Pong:
+            counter = Counter::FramesInPong;
+            break;
+        default:
+            counter = Counter::FramesInOther;
+            break;
+    }
+
+    if (!incoming)
+    {
+        counter = static_cast<Counter>(static_cast<size_t>(counter) + (static_cast<size_t>(Counter::FramesOutText) -
+                                                                       static_cast<size_t>(Counter::FramesInText)));
+    }
+
+    return counter;
+}
+
+uint64_t Metrics::BucketLowerBound(size_t index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    size_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    size_t sub      = index % SUB_BUCKETS;
+    return static_cast<uint64_t>(SUB_BUCKETS + sub) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t Metrics::BucketUpperBound(size_t index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    size_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    return BucketLowerBound(index) + ((static_cast<uint64_t>(1) << (exponent - SUB_BUCKET_BITS)) - 1);
+}
+
+uint64_t Metrics::HistogramData::Percentile(double percent) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(count) + 0.5);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    if (rank > count)
+    {
+        rank = count;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return BucketUpperBound(i);
+        }
+    }
+
+    return BucketUpperBound(buckets.size() - 1);
+}
+
+double Metrics::HistogramData::Mean() const
+{
+    return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+}
+
+uint64_t Metrics::Snapshot::Get(Metrics::Counter counter) const
+{
+    return counters[static_cast<size_t>(counter)];
+}
+
+int64_t Metrics::Snapshot::Get(Metrics::Gauge gauge) const
+{
+    return gauges[static_cast<size_t>(gauge)];
+}
+
+const Metrics::HistogramData& Metrics::Snapshot::Get(Metrics::Histogram histogram) const
+{
+    return histograms[static_cast<size_t>(histogram)];
+}
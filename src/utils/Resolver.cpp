@@ -0,0 +1,108 @@
+#include "Resolver.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <cstring>
+
+using namespace WebSocketCpp;
+
+constexpr size_t ThreadPoolResolver::DEFAULT_THREADS;
+
+bool IResolver::ParseNumeric(const std::string& host, int32_t port, sockaddr_in& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(static_cast<uint16_t>(port));
+    return inet_pton(AF_INET, host.c_str(), &address.sin_addr) == 1;
+}
+
+ThreadPoolResolver::ThreadPoolResolver(size_t threads)
+    : m_pool(threads)
+{
+    m_pool.Init(&ThreadPoolResolver::Lookup);
+    m_pool.Run();
+}
+
+ThreadPoolResolver::~ThreadPoolResolver()
+{
+    m_pool.Stop();
+}
+
+void ThreadPoolResolver::Resolve(const std::string& host, int32_t port, Callback callback)
+{
+    sockaddr_in address;
+    if (ParseNumeric(host, port, address))
+    {
+        callback(true, address, "");
+        return;
+    }
+
+    m_pool.Submit(host, port, std::move(callback));
+}
+
+void ThreadPoolResolver::Lookup(std::string host, int32_t port, Callback callback)
+{
+    struct addrinfo  hints{};
+    struct addrinfo* result = nullptr;
+    hints.ai_family         = AF_INET;
+    hints.ai_socktype       = SOCK_STREAM;
+
+    sockaddr_in address{};
+    int         ret = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result);
+    if (ret != 0 || result == nullptr)
+    {
+        callback(false, address, std::string("host resolution error: ") + gai_strerror(ret));
+        return;
+    }
+
+    std::memcpy(&address, result->ai_addr, sizeof(address));
+    freeaddrinfo(result);
+    callback(true, address, "");
+}
+
+std::shared_ptr<ThreadPoolResolver> ThreadPoolResolver::Default()
+{
+    static std::mutex                        mutex;
+    static std::weak_ptr<ThreadPoolResolver> instance;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto                        resolver = instance.lock();
+    if (resolver == nullptr)
+    {
+        resolver = std::make_shared<ThreadPoolResolver>();
+        instance = resolver;
+    }
+
+    return resolver;
+}
+
+void StaticResolver::Add(const std::string& host, const std::string& address)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hosts[host] = address;
+}
+
+void StaticResolver::Resolve(const std::string& host, int32_t port, Callback callback)
+{
+    std::string numeric = host;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        it = m_hosts.find(host);
+        if (it != m_hosts.end())
+        {
+            numeric = it->second;
+        }
+    }
+
+    sockaddr_in address;
+    if (ParseNumeric(numeric, port, address))
+    {
+        callback(true, address, "");
+    }
+    else
+    {
+        callback(false, address, "unknown host: " + host);
+    }
+}
@@ -3,6 +3,7 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -10,7 +11,10 @@
 #include <algorithm>
 #include <cstring>
 
+#include "Config.h"
+#include "FrameCodec.h"
 #include "LogWriter.h"
+#include "Metrics.h"
 #include "common.h"
 
 #ifdef WITH_OPENSSL
@@ -21,9 +25,14 @@
 namespace WebSocketCpp
 {
 
+static uint64_t NowMs()
+{
+    return Metrics::Now() / 1000000;
+}
+
 ServerSocket::ServerSocket(size_t client_count)
     : m_client_count(client_count),
-      m_memory_pool(m_client_count * BUFFER_SIZE * 2)
+      m_memory_pool(m_client_count * POOL_BLOCK_SIZE * 2)
 {
     m_connections.resize(m_client_count);
 }
@@ -67,6 +76,12 @@ bool ServerSocket::Init()
         ev.data.u32 = UINT32_MAX;
         epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_server_fd, &ev);
 
+        if (m_handshake_timeout_ms > 0 || m_ping_interval_ms > 0 || m_idle_timeout_ms > 0)
+        {
+            m_timers.reset(new TimerWheel(m_client_count, TIMER_TICK_MS, NowMs()));
+            m_liveness.assign(m_client_count, Liveness());
+        }
+
 #ifdef WITH_OPENSSL
         if (!m_cert.empty() && !m_key.empty())
         {
@@ -161,25 +176,24 @@ void ServerSocket::Cleanup()
         m_process_thread.join();
     }
 
-    for (auto& conn : m_connections)
-    {
-        CloseSocket(conn.GetFD());
-        conn.Free();
-    }
-
 #ifdef WITH_OPENSSL
-    for (auto& [fd, idx_ssl] : m_pending_ssl)
+    m_handshake_pool.reset();
+#endif
+
+    for (size_t i = 0; i < m_connections.size(); i++)
     {
-        SSL_free(idx_ssl.second);
-        close(fd);
+        CloseSocket(i);
+        m_connections[i].Free();
     }
-    m_pending_ssl.clear();
+    m_timers.reset();
 
+#ifdef WITH_OPENSSL
     if (m_ssl_ctx)
     {
         SSL_CTX_free(m_ssl_ctx);
         m_ssl_ctx = nullptr;
     }
+    m_ticket_keys.reset();
 #endif
 
     if (m_epoll_fd >= 0)
@@ -203,6 +217,22 @@ void ServerSocket::SetAddress(const std::string& host, int32_t port)
     m_port = port;
 }
 
+void ServerSocket::SetTimeouts(uint64_t handshakeMs, uint64_t pingMs, uint64_t pongMs, uint64_t idleMs)
+{
+    m_handshake_timeout_ms = handshakeMs;
+    m_ping_interval_ms     = pingMs;
+    m_pong_timeout_ms      = pongMs;
+    m_idle_timeout_ms      = idleMs;
+}
+
+void ServerSocket::SetUpgraded(int32_t idx)
+{
+    if (idx >= 0 && static_cast<size_t>(idx) < m_connections.size())
+    {
+        m_connections[idx].SetUpgraded(true);
+    }
+}
+
 void ServerSocket::OnConnected(OnConnectedCalback callback)
 {
     m_connected_callback = std::move(callback);
@@ -226,35 +256,58 @@ bool ServerSocket::Write(int32_t idx, const uint8_t* data, size_t size)
         return false;
     }
 
-    int32_t fd = m_connections[idx].GetFD();
-    if (fd < 0)
+    Connection& conn = m_connections[idx];
+    if (conn.GetFD() < 0)
     {
         SetLastError("connection not active");
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(m_write_mutex);
+    // the writers queue up here, the epoll thread takes only the write mutex and
+    // that one is released while waiting for the peer to drain the socket
+    std::lock_guard<std::mutex>  sending(conn.GetSendMutex());
+    std::unique_lock<std::mutex> lock(conn.GetWriteMutex());
+    int32_t                      fd         = conn.GetFD();
+    uint32_t                     generation = conn.GetGeneration();
+    if (fd < 0 || conn.IsClosed())
+    {
+        SetLastError("connection not active");
+        return false;
+    }
 
 #ifdef WITH_OPENSSL
-    auto it = m_ssl_conns.find(fd);
-    if (it != m_ssl_conns.end())
+    SSL* ssl = conn.GetSsl();
+    if (m_ssl_ctx != nullptr && (ssl == nullptr || conn.IsSslPending()))
+    {
+        // closed already or still in the handshake, never write it in clear
+        SetLastError("connection not active");
+        return false;
+    }
+    if (ssl != nullptr && !conn.IsKtls())
     {
         size_t total = 0;
         while (total < size)
         {
-            int sent = SSL_write(it->second, data + total, static_cast<int>(size - total));
+            ERR_clear_error(); // SSL_get_error() looks at this thread's queue, stale entries turn into SSL_ERROR_SSL
+            int sent = SSL_write(ssl, data + total, static_cast<int>(size - total));
             if (sent <= 0)
             {
-                int err = SSL_get_error(it->second, sent);
-                if (err == SSL_ERROR_WANT_WRITE)
+                int err = SSL_get_error(ssl, sent);
+                if (err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ)
                 {
-                    continue;
+                    // the retry passes the same arguments, as SSL_write() wants
+                    if (WaitSocket(conn, lock, generation, err == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN))
+                    {
+                        continue;
+                    }
+                    return false;
                 }
                 SetLastError("SSL_write error");
                 return false;
             }
             total += static_cast<size_t>(sent);
         }
+        Metrics::Instance().Add(Metrics::Counter::BytesOut, size);
         return true;
     }
 #endif
@@ -266,6 +319,14 @@ bool ServerSocket::Write(int32_t idx, const uint8_t* data, size_t size)
         if (sent < 0)
         {
             if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (WaitSocket(conn, lock, generation, POLLOUT))
+                {
+                    continue;
+                }
+                return false;
+            }
+            if (errno == EINTR)
             {
                 continue;
             }
@@ -274,6 +335,63 @@ bool ServerSocket::Write(int32_t idx, const uint8_t* data, size_t size)
         }
         total += static_cast<size_t>(sent);
     }
+    Metrics::Instance().Add(Metrics::Counter::BytesOut, size);
+
+    return true;
+}
+
+// ends the reading side only, the epoll thread sees the end of input and closes
+// the socket as it does for a peer that left, the data written before still goes out
+bool ServerSocket::CloseConnection(int32_t idx)
+{
+    if (idx < 0 || static_cast<size_t>(idx) >= m_connections.size())
+    {
+        SetLastError("invalid connection index");
+        return false;
+    }
+
+    Connection&                 conn = m_connections[idx];
+    std::lock_guard<std::mutex> lock(conn.GetWriteMutex());
+    int32_t                     fd = conn.GetFD();
+    if (fd < 0 || conn.IsClosed())
+    {
+        SetLastError("connection not active");
+        return false;
+    }
+    shutdown(fd, SHUT_RD);
+
+    return true;
+}
+
+// waits with the write mutex released so the epoll thread can go on reading and
+// closing, the connection may be gone when the lock is taken back
+bool ServerSocket::WaitSocket(Connection& conn, std::unique_lock<std::mutex>& lock, uint32_t generation, short events)
+{
+    pollfd pfd{conn.GetFD(), events, 0};
+    lock.unlock();
+    int ret;
+    do
+    {
+        ret = poll(&pfd, 1, static_cast<int>(WRITE_TIMEOUT_MS));
+    } while (ret < 0 && errno == EINTR);
+    int error = errno;
+    lock.lock();
+
+    if (conn.IsClosed() || conn.GetGeneration() != generation)
+    {
+        SetLastError("connection closed");
+        return false;
+    }
+    if (ret == 0)
+    {
+        SetLastError("write timeout");
+        return false;
+    }
+    if (ret < 0)
+    {
+        SetLastError(std::string("poll error: ") + strerror(error));
+        return false;
+    }
 
     return true;
 }
@@ -313,7 +431,21 @@ void ServerSocket::ProcessTask()
 
     while (m_process_running)
     {
-        int32_t n = epoll_wait(m_epoll_fd, events, m_client_count < MAX_EVENT_COUNT ? m_client_count : MAX_EVENT_COUNT, PROCESS_TIMEOUT_MS);
+        int timeout = m_deferred_reads.empty() ? PROCESS_TIMEOUT_MS : 0;
+        if (m_timers)
+        {
+            uint64_t next = m_timers->NextTimeoutMs(NowMs());
+            if (next < static_cast<uint64_t>(timeout))
+            {
+                timeout = static_cast<int>(next);
+            }
+        }
+
+        int32_t n = epoll_wait(m_epoll_fd, events, m_client_count < MAX_EVENT_COUNT ? m_client_count : MAX_EVENT_COUNT, timeout);
+        m_now_ms  = NowMs();
+#ifdef WITH_TRACING
+        m_epollTime = Metrics::Now();
+#endif
         for (int32_t i = 0; i < n; i++)
         {
             if (events[i].data.u32 == UINT32_MAX)
@@ -330,40 +462,69 @@ void ServerSocket::ProcessTask()
                 if (idx >= 0)
                 {
 #ifdef WITH_OPENSSL
-                    if (ev & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP))
+                    if (m_connections[idx].IsSslPending())
                     {
-                        int32_t fd = m_connections[idx].GetFD();
-                        auto    ps = m_pending_ssl.find(fd);
-                        if (ps != m_pending_ssl.end())
+                        if (m_connections[idx].IsSslFailed())
                         {
-                            if ((ev & (EPOLLERR | EPOLLHUP)) || !ContinueSslHandshake(idx))
-                            {
-                                SSL_free(ps->second.second);
-                                m_pending_ssl.erase(ps);
-                                epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
-                                close(fd);
-                                m_connections[idx].Free();
-                            }
+                            CloseSocket(idx);
+                            m_connections[idx].Free();
                             continue;
                         }
+                        // an error shows up as the failed SSL_accept() there
+                        m_handshake_pool->Submit(idx);
+                        continue;
                     }
 #endif
                     if (ev & EPOLLIN)
                     {
+                        if (m_timers)
+                        {
+                            m_liveness[idx].readMs = m_now_ms;
+                        }
                         if (HandleRead(idx) == false)
                         {
-                            CloseSocket(m_connections[idx].GetFD());
+                            CloseSocket(idx);
                             m_connections[idx].Disconnect();
                         }
                     }
                     else if (ev & (EPOLLERR | EPOLLHUP))
                     {
-                        CloseSocket(m_connections[idx].GetFD());
+                        CloseSocket(idx);
                         m_connections[idx].Disconnect();
                     }
                 }
             }
         }
+
+        if (!m_deferred_reads.empty())
+        {
+            std::vector<int32_t> deferred;
+            deferred.swap(m_deferred_reads);
+            for (int32_t idx : deferred)
+            {
+                Connection& conn = m_connections[idx];
+                if (conn.GetFD() < 0 || conn.IsClosed())
+                {
+                    continue;
+                }
+#ifdef WITH_OPENSSL
+                if (conn.IsSslPending())
+                {
+                    continue; // the slot went to a new connection in the meantime
+                }
+#endif
+                if (HandleRead(idx) == false)
+                {
+                    CloseSocket(idx);
+                    conn.Disconnect();
+                }
+            }
+        }
+
+        if (m_timers)
+        {
+            m_timers->Advance(m_now_ms, [this](uint32_t idx) { CheckTimers(static_cast<int32_t>(idx)); });
+        }
     }
 }
 
@@ -379,15 +540,22 @@ bool ServerSocket::AcceptClient()
     if (idx == -1)
     {
         close(fd);
+        Metrics::Instance().Add(Metrics::Counter::AcceptErrors);
         return false;
     }
+    Metrics::Instance().Add(Metrics::Counter::Accepts);
 
     SetNonblocking(fd);
 
 #ifdef WITH_OPENSSL
     if (m_ssl_ctx)
     {
-        return BeginSslHandshake(fd, idx);
+        if (!BeginSslHandshake(fd, idx))
+        {
+            return false;
+        }
+        StartTimers(idx);
+        return true;
     }
 #endif
 
@@ -396,6 +564,7 @@ bool ServerSocket::AcceptClient()
     ev.data.u32 = static_cast<uint32_t>(idx);
     epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
     m_connections[idx].Assign(this, fd, idx);
+    StartTimers(idx);
     return true;
 }
 
@@ -414,6 +583,19 @@ int32_t ServerSocket::FindFreeConnection()
 
 bool ServerSocket::HandleRead(int32_t idx)
 {
+    int32_t        conn_fd = m_connections[idx].GetFD();
+    Trace::Context trace;
+    TRACE_START(trace, m_epollTime);
+
+#ifdef WITH_OPENSSL
+    // only this thread closes the connection, the SSL can't go away under us
+    SSL* ssl = m_connections[idx].GetSsl();
+    if (ssl != nullptr)
+    {
+        return ReadSsl(idx, ssl, trace);
+    }
+#endif
+
     uint8_t* buffer = m_memory_pool.allocate(BUFFER_SIZE);
     if (buffer == nullptr)
     {
@@ -423,65 +605,165 @@ bool ServerSocket::HandleRead(int32_t idx)
         return false;
     }
 
-    int32_t conn_fd = m_connections[idx].GetFD();
-    int     size    = 0;
+    int size = read(conn_fd, buffer, BUFFER_SIZE);
+    if (size > 0)
+    {
+        Metrics::Instance().Add(Metrics::Counter::BytesIn, static_cast<uint64_t>(size));
+        TRACE_STAMP(trace, ReadDone);
+        m_connections[idx].Submit(buffer, static_cast<size_t>(size), trace);
+        return true;
+    }
+
+    bool retval = (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+    m_memory_pool.free(buffer);
+    return retval;
+}
 
-#ifdef WITH_OPENSSL
-    auto it = m_ssl_conns.find(conn_fd);
-    if (it != m_ssl_conns.end())
+bool ServerSocket::CloseSocket(int32_t idx)
+{
+    Connection& conn = m_connections[idx];
+    int32_t     fd   = conn.GetFD();
+    if (fd >= 0)
     {
-        size = SSL_read(it->second, buffer, static_cast<int>(BUFFER_SIZE));
-        if (size <= 0)
+        // Write() may be using the socket on another thread
+        std::lock_guard<std::mutex> lock(conn.GetWriteMutex());
+        conn.MarkClosed();
+#ifdef WITH_OPENSSL
+        bool established = !conn.IsSslPending();
+        SSL* ssl         = conn.DetachSsl();
+        if (ssl != nullptr)
         {
-            int err = SSL_get_error(it->second, size);
-            m_memory_pool.free(buffer);
-            return (err == SSL_ERROR_WANT_READ);
+            if (established)
+            {
+                SSL_shutdown(ssl);
+            }
+            SSL_free(ssl);
         }
-        m_connections[idx].Submit(buffer, static_cast<size_t>(size));
-        return true;
-    }
 #endif
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        shutdown(fd, SHUT_RDWR); // wakes a Write() waiting in poll(), close() alone doesn't
+        close(fd);
+    }
+    if (m_timers)
+    {
+        m_timers->Cancel(idx);
+    }
 
-    size = read(conn_fd, buffer, BUFFER_SIZE);
-    if (size > 0)
+    return true;
+}
+
+// the timers live on the epoll thread, a connection has one entry in the wheel
+// at its nearest deadline and the reads only stamp the time, so the wheel is
+// touched only when something is due
+void ServerSocket::StartTimers(int32_t idx)
+{
+    m_connections[idx].SetUpgraded(false);
+    if (m_timers)
     {
-        m_connections[idx].Submit(buffer, static_cast<size_t>(size));
+        Liveness& liveness = m_liveness[idx];
+        liveness.acceptMs  = m_now_ms;
+        liveness.readMs    = m_now_ms;
+        liveness.pingMs    = 0;
+        CheckTimers(idx);
     }
-    else if (size == 0)
+}
+
+void ServerSocket::CheckTimers(int32_t idx)
+{
+    Connection& conn = m_connections[idx];
+    if (conn.GetFD() < 0)
     {
-        m_memory_pool.free(buffer);
-        return false;
+        return;
+    }
+
+    Liveness& liveness = m_liveness[idx];
+    uint64_t  now      = m_now_ms;
+    uint64_t  next     = UINT64_MAX;
+
+    if (!conn.IsUpgraded())
+    {
+        if (m_handshake_timeout_ms > 0)
+        {
+            if (now >= liveness.acceptMs + m_handshake_timeout_ms)
+            {
+                Metrics::Instance().Add(Metrics::Counter::HandshakeTimeouts);
+                Expire(idx);
+                return;
+            }
+            next = liveness.acceptMs + m_handshake_timeout_ms;
+        }
+        // SetUpgraded() comes from another thread, so look again later
+        uint64_t poll = m_ping_interval_ms > 0 ? m_ping_interval_ms : m_idle_timeout_ms;
+        if (m_idle_timeout_ms > 0 && m_idle_timeout_ms < poll)
+        {
+            poll = m_idle_timeout_ms;
+        }
+        if (poll > 0 && now + poll < next)
+        {
+            next = now + poll;
+        }
     }
     else
     {
-        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        if (m_idle_timeout_ms > 0)
         {
-            m_memory_pool.free(buffer);
-            return false;
+            if (now >= liveness.readMs + m_idle_timeout_ms)
+            {
+                Metrics::Instance().Add(Metrics::Counter::IdleTimeouts);
+                Expire(idx);
+                return;
+            }
+            next = liveness.readMs + m_idle_timeout_ms;
+        }
+
+        if (m_ping_interval_ms > 0)
+        {
+            uint64_t deadline;
+            if (m_pong_timeout_ms > 0 && liveness.pingMs > liveness.readMs)
+            {
+                // the ping isn't answered yet, any data counts as the answer
+                deadline = liveness.pingMs + m_pong_timeout_ms;
+                if (now >= deadline)
+                {
+                    Metrics::Instance().Add(Metrics::Counter::PongTimeouts);
+                    Expire(idx);
+                    return;
+                }
+            }
+            else
+            {
+                deadline = std::max(liveness.readMs, liveness.pingMs) + m_ping_interval_ms;
+                if (now >= deadline)
+                {
+                    conn.Ping();
+                    liveness.pingMs = now;
+                    deadline        = now + (m_pong_timeout_ms > 0 ? m_pong_timeout_ms : m_ping_interval_ms);
+                }
+            }
+            if (deadline < next)
+            {
+                next = deadline;
+            }
         }
     }
 
-    return true;
+    if (next != UINT64_MAX)
+    {
+        m_timers->Schedule(idx, next);
+    }
 }
 
-bool ServerSocket::CloseSocket(int32_t fd)
+// shutdown() is safe whoever owns the socket now, the epoll thread or a handshake
+// worker sees it as a closed peer and the connection goes the usual way out. Only
+// the reading side, OpenSSL may still send an alert and a write to a socket shut
+// down for writing raises SIGPIPE
+void ServerSocket::Expire(int32_t idx)
 {
-    if (fd >= 0)
+    int32_t fd = m_connections[idx].GetFD();
+    if (fd >= 0 && !m_connections[idx].IsClosed())
     {
-#ifdef WITH_OPENSSL
-        auto it = m_ssl_conns.find(fd);
-        if (it != m_ssl_conns.end())
-        {
-            SSL_shutdown(it->second);
-            SSL_free(it->second);
-            m_ssl_conns.erase(it);
-        }
-#endif
-        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
-        close(fd);
+        shutdown(fd, SHUT_RD);
     }
-
-    return true;
 }
 
 #ifdef WITH_OPENSSL
@@ -491,6 +773,11 @@ void ServerSocket::SetSslCredentials(const std::string& cert, const std::string&
     m_key  = key;
 }
 
+void ServerSocket::SetKtls(bool enable)
+{
+    m_ktls = enable;
+}
+
 bool ServerSocket::InitSsl()
 {
     OpenSSL_add_all_algorithms();
@@ -519,9 +806,60 @@ bool ServerSocket::InitSsl()
         return false;
     }
 
+    // a reconnecting client resumes its session instead of the full handshake
+    const Config& config = Config::Instance();
+    size_t        cacheSize = config.GetSslSessionCacheSize();
+    uint64_t      lifetime  = config.GetSslTicketKeyLifetimeSec();
+    if (cacheSize > 0)
+    {
+        static const unsigned char SESSION_CONTEXT[] = "websocketcpp";
+        SSL_CTX_set_session_cache_mode(m_ssl_ctx, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(m_ssl_ctx, static_cast<long>(cacheSize));
+        SSL_CTX_set_session_id_context(m_ssl_ctx, SESSION_CONTEXT, sizeof(SESSION_CONTEXT) - 1);
+    }
+    else
+    {
+        SSL_CTX_set_session_cache_mode(m_ssl_ctx, SSL_SESS_CACHE_OFF);
+    }
+
+    if (lifetime > 0)
+    {
+        m_ticket_keys.reset(new SslTicketKeys(lifetime));
+        if (!m_ticket_keys->Attach(m_ssl_ctx))
+        {
+            SetLastError("session ticket keys setup failed");
+            SSL_CTX_free(m_ssl_ctx);
+            m_ssl_ctx = nullptr;
+            return false;
+        }
+        SSL_CTX_set_timeout(m_ssl_ctx, static_cast<long>(lifetime));
+    }
+    else
+    {
+        SSL_CTX_set_options(m_ssl_ctx, SSL_OP_NO_TICKET);
+    }
+
+    size_t threads = config.GetSslHandshakeThreads();
+    m_handshake_pool.reset(new ThreadPool<int32_t>(threads > 0 ? threads : 1));
+    m_handshake_pool->Init([this](int32_t idx) { ContinueSslHandshake(idx); });
+    m_handshake_pool->Run();
+
+    if (m_ktls)
+    {
+#ifdef SSL_OP_ENABLE_KTLS
+        // OpenSSL hands the keys to the kernel once the handshake is done,
+        // if the kernel or the cipher can't take them it just goes on by itself
+        SSL_CTX_set_options(m_ssl_ctx, SSL_OP_ENABLE_KTLS);
+#else
+        LOG("kernel TLS isn't supported by this OpenSSL, falling back to user space TLS", LogWriter::LogType::Error);
+#endif
+    }
+
     return true;
 }
 
+// the handshake itself runs on m_handshake_pool, the descriptor is armed with
+// EPOLLONESHOT so only one side touches the SSL until it's established
 bool ServerSocket::BeginSslHandshake(int32_t fd, int32_t idx)
 {
     SSL* ssl = SSL_new(m_ssl_ctx);
@@ -533,72 +871,149 @@ bool ServerSocket::BeginSslHandshake(int32_t fd, int32_t idx)
     }
 
     SSL_set_fd(ssl, fd);
+    m_connections[idx].Reserve(fd);
+    m_connections[idx].AttachSsl(ssl);
+
+    epoll_event ev{};
+    ev.events   = EPOLLIN | EPOLLONESHOT;
+    ev.data.u32 = static_cast<uint32_t>(idx);
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    return true;
+}
 
+void ServerSocket::ContinueSslHandshake(int32_t idx)
+{
+    Connection& conn = m_connections[idx];
+    int32_t     fd   = conn.GetFD();
+    SSL*        ssl  = conn.GetSsl();
+    if (ssl == nullptr || !conn.IsSslPending())
+    {
+        return;
+    }
+
+    ERR_clear_error();
     int ret = SSL_accept(ssl);
     if (ret == 1)
     {
-        m_ssl_conns[fd] = ssl;
+        SslEstablished(idx);
+        conn.Assign(this, fd, idx);
+
         epoll_event ev{};
         ev.events   = EPOLLIN;
         ev.data.u32 = static_cast<uint32_t>(idx);
-        epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
-        m_connections[idx].Assign(this, fd, idx);
-        return true;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+        return;
     }
 
     int err = SSL_get_error(ssl, ret);
     if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
     {
-        m_connections[idx].Reserve(fd);
-        m_pending_ssl[fd] = {idx, ssl};
         epoll_event ev{};
-        ev.events   = EPOLLIN | EPOLLERR | EPOLLHUP;
+        ev.events   = (err == SSL_ERROR_WANT_WRITE ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
         ev.data.u32 = static_cast<uint32_t>(idx);
-        epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
-        return true;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+        return;
     }
 
-    SSL_free(ssl);
-    close(fd);
-    SetLastError("SSL_accept failed");
-    return false;
+    // closed by the epoll thread, it owns the slot and the timers, and a descriptor
+    // closed here could be accepted again before the slot is free. The shut down
+    // socket is reported at once
+    conn.SslFailed();
+    shutdown(fd, SHUT_RDWR);
+    epoll_event ev{};
+    ev.events   = EPOLLIN | EPOLLONESHOT;
+    ev.data.u32 = static_cast<uint32_t>(idx);
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
 }
 
-bool ServerSocket::ContinueSslHandshake(int32_t idx)
+void ServerSocket::SslEstablished(int32_t idx)
 {
-    int32_t fd  = m_connections[idx].GetFD();
-    auto    it  = m_pending_ssl.find(fd);
-    SSL*    ssl = it->second.second;
-
-    int ret = SSL_accept(ssl);
-    if (ret == 1)
+    SSL* ssl    = m_connections[idx].GetSsl();
+    bool kernel = false;
+#ifdef BIO_get_ktls_send
+    // the kernel encrypts what's written to the socket now, reading stays with
+    // SSL_read() which also takes the non-data records out of the kernel
+    kernel = m_ktls && BIO_get_ktls_send(SSL_get_wbio(ssl));
+#endif
+    m_connections[idx].SslEstablished(kernel);
+    Metrics::Instance().Add(kernel ? Metrics::Counter::TlsKernelConnections : Metrics::Counter::TlsUserConnections);
+    if (SSL_session_reused(ssl))
     {
-        m_ssl_conns[fd] = ssl;
-        m_pending_ssl.erase(it);
-
-        epoll_event ev{};
-        ev.events   = EPOLLIN;
-        ev.data.u32 = static_cast<uint32_t>(idx);
-        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
-        m_connections[idx].Assign(this, fd, idx);
-        return true;
+        Metrics::Instance().Add(Metrics::Counter::TlsResumed);
     }
+}
 
-    int err = SSL_get_error(ssl, ret);
-    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+// SSL_read() hands out at most one record, the rest of it stays decrypted inside
+// OpenSSL where epoll can't see it, so keep reading while SSL_pending() says so
+bool ServerSocket::ReadSsl(int32_t idx, SSL* ssl, const Trace::Context& trace)
+{
+    while (true)
     {
-        uint32_t    want_ev = (err == SSL_ERROR_WANT_WRITE)
-                                  ? (EPOLLOUT | EPOLLERR | EPOLLHUP)
-                                  : (EPOLLIN | EPOLLERR | EPOLLHUP);
-        epoll_event ev{};
-        ev.events   = want_ev;
-        ev.data.u32 = static_cast<uint32_t>(idx);
-        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
-        return true;
-    }
+        uint8_t* buffer = m_memory_pool.allocate(SSL_BUFFER_SIZE);
+        if (buffer == nullptr)
+        {
+            SetLastError("memory pool exhausted");
+            LOG(GetLastError(), LogWriter::LogType::Error);
+            Close(false);
+            return false;
+        }
+
+        size_t size    = 0;
+        int    err     = SSL_ERROR_NONE;
+        bool   pending = false;
+        {
+            // SSL_read() and SSL_write() can't run on one SSL at the same time, but
+            // a writer is never waited for here, the read is just tried again later
+            std::unique_lock<std::mutex> lock(m_connections[idx].GetWriteMutex(), std::try_to_lock);
+            if (!lock.owns_lock())
+            {
+                m_memory_pool.free(buffer);
+                if (std::find(m_deferred_reads.begin(), m_deferred_reads.end(), idx) == m_deferred_reads.end())
+                {
+                    m_deferred_reads.push_back(idx);
+                }
+                return true;
+            }
+            while (size < SSL_BUFFER_SIZE)
+            {
+                ERR_clear_error();
+                int ret = SSL_read(ssl, buffer + size, static_cast<int>(SSL_BUFFER_SIZE - size));
+                if (ret <= 0)
+                {
+                    err = SSL_get_error(ssl, ret);
+                    break;
+                }
+                size += static_cast<size_t>(ret);
+                if (SSL_pending(ssl) == 0)
+                {
+                    break;
+                }
+            }
+            pending = (SSL_pending(ssl) > 0);
+        }
 
-    SetLastError("SSL_accept failed");
-    return false;
+        if (size > 0)
+        {
+            m_memory_pool.shrink(buffer, size);
+            Metrics::Instance().Add(Metrics::Counter::BytesIn, static_cast<uint64_t>(size));
+            Trace::Context stamped = trace;
+            TRACE_STAMP(stamped, ReadDone);
+            m_connections[idx].Submit(buffer, size, stamped);
+        }
+        else
+        {
+            m_memory_pool.free(buffer);
+        }
+
+        if (err != SSL_ERROR_NONE)
+        {
+            return (err == SSL_ERROR_WANT_READ);
+        }
+        if (!pending)
+        {
+            return true;
+        }
+    }
 }
 #endif
 
@@ -631,6 +1046,16 @@ void ServerSocket::FreeData(const uint8_t* data)
     m_memory_pool.free(data);
 }
 
+void ServerSocket::SendPing(int32_t idx)
+{
+    uint8_t frame[ServerFrameCodec::MAX_HEADER_SIZE];
+    size_t  size = ServerFrameCodec::WriteHeader(frame, MessageType::Ping, 0, 0);
+    if (Write(idx, frame, size))
+    {
+        Metrics::Instance().Add(Metrics::Counter::FramesOutPing);
+    }
+}
+
 // ---------------------------- Connection ----------------------------------
 
 ServerSocket::Connection::Connection()
@@ -644,7 +1069,8 @@ ServerSocket::Connection::~Connection()
 
 void ServerSocket::Connection::Reserve(int32_t fd)
 {
-    m_fd = fd;
+    m_fd     = fd;
+    m_closed = false;
 }
 
 void ServerSocket::Connection::Assign(ServerSocket* server, int32_t fd, int32_t idx)
@@ -656,16 +1082,19 @@ void ServerSocket::Connection::Assign(ServerSocket* server, int32_t fd, int32_t
     m_server = server;
     m_fd     = fd;
     m_idx    = idx;
+    m_closed = false;
     runThread();
     std::unique_lock<std::mutex> lock(m_args_mtx);
-    m_args_queue.push(std::make_tuple(TaskType::CONNECTION, nullptr, 0));
+    m_args_queue.push(std::make_tuple(TaskType::CONNECTION, nullptr, 0, Trace::Context()));
+    Metrics::Instance().Add(Metrics::Gauge::ConnectionQueueDepth, 1);
     m_cv.notify_one();
 }
 
-void ServerSocket::Connection::Submit(const uint8_t* data, size_t size)
+void ServerSocket::Connection::Submit(const uint8_t* data, size_t size, const Trace::Context& trace)
 {
     std::unique_lock<std::mutex> lock(m_args_mtx);
-    m_args_queue.push(std::make_tuple(TaskType::DATA, data, size));
+    m_args_queue.push(std::make_tuple(TaskType::DATA, data, size, trace));
+    Metrics::Instance().Add(Metrics::Gauge::ConnectionQueueDepth, 1);
     m_cv.notify_one();
 }
 
@@ -684,10 +1113,29 @@ void ServerSocket::Connection::Free()
     }
 }
 
+void ServerSocket::Connection::Ping()
+{
+    std::unique_lock<std::mutex> lock(m_args_mtx);
+    m_args_queue.push(std::make_tuple(TaskType::PING, nullptr, 0, Trace::Context()));
+    Metrics::Instance().Add(Metrics::Gauge::ConnectionQueueDepth, 1);
+    m_cv.notify_one();
+}
+
+void ServerSocket::Connection::SetUpgraded(bool upgraded)
+{
+    m_upgraded = upgraded;
+}
+
+bool ServerSocket::Connection::IsUpgraded() const
+{
+    return m_upgraded;
+}
+
 void ServerSocket::Connection::Disconnect()
 {
     std::unique_lock<std::mutex> lock(m_args_mtx);
-    m_args_queue.push(std::make_tuple(TaskType::DISCONNECTION, nullptr, 0));
+    m_args_queue.push(std::make_tuple(TaskType::DISCONNECTION, nullptr, 0, Trace::Context()));
+    Metrics::Instance().Add(Metrics::Gauge::ConnectionQueueDepth, 1);
     m_cv.notify_one();
 }
 
@@ -709,9 +1157,11 @@ void ServerSocket::Connection::processTask()
             TaskType       task_type = std::get<0>(m_args_queue.front());
             const uint8_t* data      = std::get<1>(m_args_queue.front());
             size_t         size      = std::get<2>(m_args_queue.front());
+            Trace::Context trace     = std::get<3>(m_args_queue.front());
             int32_t        idx       = m_idx;
             m_args_queue.pop();
             lock.unlock();
+            Metrics::Instance().Add(Metrics::Gauge::ConnectionQueueDepth, -1);
 
             switch (task_type)
             {
@@ -729,10 +1179,15 @@ void ServerSocket::Connection::processTask()
                     return;
                 case TaskType::DATA:
                 {
+                    TRACE_STAMP(trace, Dequeued);
+                    TRACE_HANDOFF(trace);
                     m_server->OnData(idx, ByteArray(data, data + size));
                     m_server->FreeData(data);
                 }
                 break;
+                case TaskType::PING:
+                    m_server->SendPing(idx);
+                    break;
                 default:
                     break;
             }
@@ -750,4 +1205,80 @@ int32_t ServerSocket::Connection::GetIdx() const
     return m_idx;
 }
 
+std::mutex& ServerSocket::Connection::GetSendMutex()
+{
+    return m_send_mutex;
+}
+
+std::mutex& ServerSocket::Connection::GetWriteMutex()
+{
+    return m_write_mutex;
+}
+
+uint32_t ServerSocket::Connection::GetGeneration() const
+{
+    return m_generation;
+}
+
+bool ServerSocket::Connection::IsClosed() const
+{
+    return m_closed;
+}
+
+void ServerSocket::Connection::MarkClosed()
+{
+    m_closed = true;
+    m_generation++;
+}
+
+#ifdef WITH_OPENSSL
+void ServerSocket::Connection::AttachSsl(SSL* ssl)
+{
+    m_ssl         = ssl;
+    m_ktls        = false;
+    m_ssl_failed  = false;
+    m_ssl_pending = true;
+}
+
+void ServerSocket::Connection::SslFailed()
+{
+    m_ssl_failed = true;
+}
+
+bool ServerSocket::Connection::IsSslFailed() const
+{
+    return m_ssl_failed;
+}
+
+void ServerSocket::Connection::SslEstablished(bool ktls)
+{
+    m_ktls        = ktls;
+    m_ssl_pending = false;
+}
+
+SSL* ServerSocket::Connection::DetachSsl()
+{
+    SSL* ssl      = m_ssl;
+    m_ssl         = nullptr;
+    m_ktls        = false;
+    m_ssl_pending = false;
+    return ssl;
+}
+
+SSL* ServerSocket::Connection::GetSsl() const
+{
+    return m_ssl;
+}
+
+bool ServerSocket::Connection::IsSslPending() const
+{
+    return m_ssl_pending;
+}
+
+bool ServerSocket::Connection::IsKtls() const
+{
+    return m_ktls;
+}
+#endif
+
 } // namespace WebSocketCpp
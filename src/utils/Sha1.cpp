@@ -1,13 +1,20 @@
 #include "Sha1.h"
 
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SHA1_HAVE_SHANI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 /* Help macros */
-#define SHA1_ROL(value, bits) (((value) << (bits)) | (((value) & 0xffffffff) >> (32 - (bits))))
+#define SHA1_ROL(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
 #define SHA1_BLK(i)           (block[i & 15] = SHA1_ROL(block[(i + 13) & 15] ^ block[(i + 8) & 15] ^ block[(i + 2) & 15] ^ block[i & 15], 1))
 
 /* (R0+R1), R2, R3, R4 are the different operations used in SHA1 */
@@ -27,6 +34,352 @@
     z += (w ^ x ^ y) + SHA1_BLK(i) + 0xca62c1d6 + SHA1_ROL(v, 5); \
     w = SHA1_ROL(w, 30);
 
+typedef void (*sha1_compress_t)(uint32_t* state, const uint8_t* data, size_t blocks);
+
+static void sha1_compress_portable(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    uint32_t block[16];
+
+    for (; blocks > 0; blocks--, data += SHA1::BLOCK_BYTES)
+    {
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            block[i] = static_cast<uint32_t>(data[4 * i + 3]) | static_cast<uint32_t>(data[4 * i + 2]) << 8 | static_cast<uint32_t>(data[4 * i + 1]) << 16 | static_cast<uint32_t>(data[4 * i + 0]) << 24;
+        }
+
+        /* Copy state[] to working vars */
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+
+        /* 4 rounds of 20 operations each. Loop unrolled. */
+        SHA1_R0(a, b, c, d, e, 0);
+        SHA1_R0(e, a, b, c, d, 1);
+        SHA1_R0(d, e, a, b, c, 2);
+        SHA1_R0(c, d, e, a, b, 3);
+        SHA1_R0(b, c, d, e, a, 4);
+        SHA1_R0(a, b, c, d, e, 5);
+        SHA1_R0(e, a, b, c, d, 6);
+        SHA1_R0(d, e, a, b, c, 7);
+        SHA1_R0(c, d, e, a, b, 8);
+        SHA1_R0(b, c, d, e, a, 9);
+        SHA1_R0(a, b, c, d, e, 10);
+        SHA1_R0(e, a, b, c, d, 11);
+        SHA1_R0(d, e, a, b, c, 12);
+        SHA1_R0(c, d, e, a, b, 13);
+        SHA1_R0(b, c, d, e, a, 14);
+        SHA1_R0(a, b, c, d, e, 15);
+        SHA1_R1(e, a, b, c, d, 16);
+        SHA1_R1(d, e, a, b, c, 17);
+        SHA1_R1(c, d, e, a, b, 18);
+        SHA1_R1(b, c, d, e, a, 19);
+        SHA1_R2(a, b, c, d, e, 20);
+        SHA1_R2(e, a, b, c, d, 21);
+        SHA1_R2(d, e, a, b, c, 22);
+        SHA1_R2(c, d, e, a, b, 23);
+        SHA1_R2(b, c, d, e, a, 24);
+        SHA1_R2(a, b, c, d, e, 25);
+        SHA1_R2(e, a, b, c, d, 26);
+        SHA1_R2(d, e, a, b, c, 27);
+        SHA1_R2(c, d, e, a, b, 28);
+        SHA1_R2(b, c, d, e, a, 29);
+        SHA1_R2(a, b, c, d, e, 30);
+        SHA1_R2(e, a, b, c, d, 31);
+        SHA1_R2(d, e, a, b, c, 32);
+        SHA1_R2(c, d, e, a, b, 33);
+        SHA1_R2(b, c, d, e, a, 34);
+        SHA1_R2(a, b, c, d, e, 35);
+        SHA1_R2(e, a, b, c, d, 36);
+        SHA1_R2(d, e, a, b, c, 37);
+        SHA1_R2(c, d, e, a, b, 38);
+        SHA1_R2(b, c, d, e, a, 39);
+        SHA1_R3(a, b, c, d, e, 40);
+        SHA1_R3(e, a, b, c, d, 41);
+        SHA1_R3(d, e, a, b, c, 42);
+        SHA1_R3(c, d, e, a, b, 43);
+        SHA1_R3(b, c, d, e, a, 44);
+        SHA1_R3(a, b, c, d, e, 45);
+        SHA1_R3(e, a, b, c, d, 46);
+        SHA1_R3(d, e, a, b, c, 47);
+        SHA1_R3(c, d, e, a, b, 48);
+        SHA1_R3(b, c, d, e, a, 49);
+        SHA1_R3(a, b, c, d, e, 50);
+        SHA1_R3(e, a, b, c, d, 51);
+        SHA1_R3(d, e, a, b, c, 52);
+        SHA1_R3(c, d, e, a, b, 53);
+        SHA1_R3(b, c, d, e, a, 54);
+        SHA1_R3(a, b, c, d, e, 55);
+        SHA1_R3(e, a, b, c, d, 56);
+        SHA1_R3(d, e, a, b, c, 57);
+        SHA1_R3(c, d, e, a, b, 58);
+        SHA1_R3(b, c, d, e, a, 59);
+        SHA1_R4(a, b, c, d, e, 60);
+        SHA1_R4(e, a, b, c, d, 61);
+        SHA1_R4(d, e, a, b, c, 62);
+        SHA1_R4(c, d, e, a, b, 63);
+        SHA1_R4(b, c, d, e, a, 64);
+        SHA1_R4(a, b, c, d, e, 65);
+        SHA1_R4(e, a, b, c, d, 66);
+        SHA1_R4(d, e, a, b, c, 67);
+        SHA1_R4(c, d, e, a, b, 68);
+        SHA1_R4(b, c, d, e, a, 69);
+        SHA1_R4(a, b, c, d, e, 70);
+        SHA1_R4(e, a, b, c, d, 71);
+        SHA1_R4(d, e, a, b, c, 72);
+        SHA1_R4(c, d, e, a, b, 73);
+        SHA1_R4(b, c, d, e, a, 74);
+        SHA1_R4(a, b, c, d, e, 75);
+        SHA1_R4(e, a, b, c, d, 76);
+        SHA1_R4(d, e, a, b, c, 77);
+        SHA1_R4(c, d, e, a, b, 78);
+        SHA1_R4(b, c, d, e, a, 79);
+
+        /* Add the working vars back into state[] */
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+#ifdef SHA1_HAVE_SHANI
+/*
+ * Intel SHA extensions. Four rounds per sha1rnds4, the message schedule
+ * is computed with sha1msg1/sha1msg2 while the rounds are running.
+ */
+__attribute__((target("sha,ssse3,sse4.1"))) static void sha1_compress_shani(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    __m128i       ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+    __m128i       MSG0, MSG1, MSG2, MSG3;
+    const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    ABCD = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    E0   = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+    ABCD = _mm_shuffle_epi32(ABCD, 0x1B);
+
+    for (; blocks > 0; blocks--, data += SHA1::BLOCK_BYTES)
+    {
+        ABCD_SAVE = ABCD;
+        E0_SAVE   = E0;
+
+        /* Rounds 0-3 */
+        MSG0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0));
+        MSG0 = _mm_shuffle_epi8(MSG0, MASK);
+        E0   = _mm_add_epi32(E0, MSG0);
+        E1   = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+
+        /* Rounds 4-7 */
+        MSG1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+        MSG1 = _mm_shuffle_epi8(MSG1, MASK);
+        E1   = _mm_sha1nexte_epu32(E1, MSG1);
+        E0   = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+        MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+
+        /* Rounds 8-11 */
+        MSG2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+        MSG2 = _mm_shuffle_epi8(MSG2, MASK);
+        E0   = _mm_sha1nexte_epu32(E0, MSG2);
+        E1   = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+        MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+        MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+        /* Rounds 12-15 */
+        MSG3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48));
+        MSG3 = _mm_shuffle_epi8(MSG3, MASK);
+        E1   = _mm_sha1nexte_epu32(E1, MSG3);
+        E0   = ABCD;
+        MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+        MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+        MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+        /* Rounds 16-19 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG0);
+        E1   = ABCD;
+        MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+        MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+        MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+        /* Rounds 20-23 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG1);
+        E0   = ABCD;
+        MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+        MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+        MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+        /* Rounds 24-27 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG2);
+        E1   = ABCD;
+        MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 1);
+        MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+        MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+        /* Rounds 28-31 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG3);
+        E0   = ABCD;
+        MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+        MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+        MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+        /* Rounds 32-35 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG0);
+        E1   = ABCD;
+        MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 1);
+        MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+        MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+        /* Rounds 36-39 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG1);
+        E0   = ABCD;
+        MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+        MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+        MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+        /* Rounds 40-43 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG2);
+        E1   = ABCD;
+        MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+        MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+        MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+        /* Rounds 44-47 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG3);
+        E0   = ABCD;
+        MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 2);
+        MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+        MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+        /* Rounds 48-51 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG0);
+        E1   = ABCD;
+        MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+        MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+        MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+        /* Rounds 52-55 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG1);
+        E0   = ABCD;
+        MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 2);
+        MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+        MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+        /* Rounds 56-59 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG2);
+        E1   = ABCD;
+        MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+        MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+        MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+        /* Rounds 60-63 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG3);
+        E0   = ABCD;
+        MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+        MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+        MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+        /* Rounds 64-67 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG0);
+        E1   = ABCD;
+        MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+        MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+        MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+        /* Rounds 68-71 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG1);
+        E0   = ABCD;
+        MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+        MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+        /* Rounds 72-75 */
+        E0   = _mm_sha1nexte_epu32(E0, MSG2);
+        E1   = ABCD;
+        MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+
+        /* Rounds 76-79 */
+        E1   = _mm_sha1nexte_epu32(E1, MSG3);
+        E0   = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+
+        E0   = _mm_sha1nexte_epu32(E0, E0_SAVE);
+        ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+    }
+
+    ABCD = _mm_shuffle_epi32(ABCD, 0x1B);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), ABCD);
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(E0, 3));
+}
+
+static bool sha1_cpu_supported()
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        return false;
+    }
+    const bool ssse3 = (ecx & (1u << 9)) != 0;
+    const bool sse41 = (ecx & (1u << 19)) != 0;
+
+    if (__get_cpuid_max(0, nullptr) < 7)
+    {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    const bool sha = (ebx & (1u << 29)) != 0;
+
+    return ssse3 && sse41 && sha;
+}
+#endif
+
+static sha1_compress_t sha1_select()
+{
+#ifdef SHA1_HAVE_SHANI
+    if (sha1_cpu_supported())
+    {
+        return sha1_compress_shani;
+    }
+#endif
+    return sha1_compress_portable;
+}
+
+// starts portable and switches on first use, no CPU probing during static initialization
+static std::atomic<sha1_compress_t> sha1_compress{sha1_compress_portable};
+static std::atomic<bool>            sha1_selected{false};
+
+static sha1_compress_t sha1_get()
+{
+    if (!sha1_selected.load(std::memory_order_acquire))
+    {
+        bool expected = false;
+        if (sha1_selected.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            sha1_compress.store(sha1_select(), std::memory_order_release);
+        }
+    }
+    return sha1_compress.load(std::memory_order_acquire);
+}
+
 SHA1::SHA1()
 {
     reset();
@@ -34,91 +387,78 @@ SHA1::SHA1()
 
 void SHA1::update(const std::string& s)
 {
-    std::istringstream is(s);
-    update(is);
+    update(reinterpret_cast<const uint8_t*>(s.data()), s.size());
 }
 
 void SHA1::update(std::istream& is)
 {
-    std::string rest_of_buffer;
-    read(is, rest_of_buffer, BLOCK_BYTES - m_buffer.size());
-    m_buffer += rest_of_buffer;
-
+    char buffer[BLOCK_BYTES * 64];
     while (is)
     {
-        uint32 block[BLOCK_INTS];
-        buffer_to_block(m_buffer, block);
-        transform(block);
-        read(is, m_buffer, BLOCK_BYTES);
+        is.read(buffer, sizeof(buffer));
+        update(reinterpret_cast<const uint8_t*>(buffer), static_cast<size_t>(is.gcount()));
     }
 }
 
-void SHA1::prepare()
+void SHA1::update(const uint8_t* data, size_t size)
 {
-    /* Total number of hashed bits */
-    uint64 total_bits = (m_transforms * BLOCK_BYTES + m_buffer.size()) * 8;
+    m_total += size;
 
-    /* Padding */
-    m_buffer += 0x80;
-    unsigned int orig_size = m_buffer.size();
-    while (m_buffer.size() < BLOCK_BYTES)
+    if (m_buffer_size > 0)
     {
-        m_buffer += (char)0x00;
-    }
-
-    uint32 block[BLOCK_INTS];
-    buffer_to_block(m_buffer, block);
+        size_t n = BLOCK_BYTES - m_buffer_size;
+        if (n > size)
+        {
+            n = size;
+        }
+        memcpy(m_buffer + m_buffer_size, data, n);
+        m_buffer_size += n;
+        data += n;
+        size -= n;
 
-    if (orig_size > BLOCK_BYTES - 8)
-    {
-        transform(block);
-        for (unsigned int i = 0; i < BLOCK_INTS - 2; i++)
+        if (m_buffer_size < BLOCK_BYTES)
         {
-            block[i] = 0;
+            return;
         }
+        process_blocks(m_digest, m_buffer, 1);
+        m_buffer_size = 0;
     }
 
-    /* Append total_bits, split this uint64 into two uint32 */
-    block[BLOCK_INTS - 1] = total_bits;
-    block[BLOCK_INTS - 2] = (total_bits >> 32);
-    transform(block);
+    size_t blocks = size / BLOCK_BYTES;
+    if (blocks > 0)
+    {
+        process_blocks(m_digest, data, blocks);
+        data += blocks * BLOCK_BYTES;
+        size -= blocks * BLOCK_BYTES;
+    }
+
+    if (size > 0)
+    {
+        memcpy(m_buffer, data, size);
+        m_buffer_size = size;
+    }
 }
 
 std::string SHA1::final()
 {
-    prepare();
+    uint8_t digest[DIGEST_BYTES];
+    finish(digest);
 
     /* Hex std::string */
     std::ostringstream result;
 
-    for (unsigned int i = 0; i < DIGEST_INTS; i++)
+    for (unsigned int i = 0; i < DIGEST_BYTES; i++)
     {
-        result << std::hex << std::setfill('0') << std::setw(8);
-        result << (m_digest[i] & 0xffffffff);
+        result << std::hex << std::setfill('0') << std::setw(2) << static_cast<unsigned int>(digest[i]);
     }
 
-    reset();
-
     return result.str();
 }
 
 std::array<uint8_t, 20> SHA1::digest()
 {
     std::array<uint8_t, 20> buffer;
-    prepare();
-
-    for (size_t i = 0; i < DIGEST_INTS; i++)
-    {
-        uint32_t d = (m_digest[i] & 0xffffffff);
-
-        buffer[i * 4]     = (d >> 24) & 0xFF;
-        buffer[i * 4 + 1] = (d >> 16) & 0xFF;
-        buffer[i * 4 + 2] = (d >> 8) & 0xFF;
-        buffer[i * 4 + 3] = d & 0xFF;
-    }
-
-    reset();
-
+    finish(buffer.data());
     return buffer;
 }
 
@@ -130,138 +470,97 @@ std::string SHA1::from_file(const std::string& filename)
     return checksum.final();
 }
 
-void SHA1::reset()
+void SHA1::digest(const uint8_t* data, size_t size, uint8_t* out)
 {
-    /* SHA1 initialization constants */
-    m_digest[0] = 0x67452301;
-    m_digest[1] = 0xefcdab89;
-    m_digest[2] = 0x98badcfe;
-    m_digest[3] = 0x10325476;
-    m_digest[4] = 0xc3d2e1f0;
+    uint32_t state[DIGEST_INTS];
+    init_state(state);
 
-    /* Reset counters */
-    m_transforms = 0;
-    m_buffer     = "";
+    size_t blocks = size / BLOCK_BYTES;
+    if (blocks > 0)
+    {
+        process_blocks(state, data, blocks);
+    }
+    pad(state, data + blocks * BLOCK_BYTES, size - blocks * BLOCK_BYTES, size);
+
+    for (size_t i = 0; i < DIGEST_INTS; i++)
+    {
+        out[i * 4]     = (state[i] >> 24) & 0xFF;
+        out[i * 4 + 1] = (state[i] >> 16) & 0xFF;
+        out[i * 4 + 2] = (state[i] >> 8) & 0xFF;
+        out[i * 4 + 3] = state[i] & 0xFF;
+    }
 }
 
-/*
- * Hash a single 512-bit block. This is the core of the algorithm.
- */
+void SHA1::process_blocks(uint32_t state[5], const uint8_t* data, size_t blocks)
+{
+    sha1_get()(state, data, blocks);
+}
 
-void SHA1::transform(uint32 block[BLOCK_BYTES])
+bool SHA1::hardware_accelerated()
 {
-    /* Copy digest[] to working vars */
-    uint32 a = m_digest[0];
-    uint32 b = m_digest[1];
-    uint32 c = m_digest[2];
-    uint32 d = m_digest[3];
-    uint32 e = m_digest[4];
-
-    /* 4 rounds of 20 operations each. Loop unrolled. */
-    SHA1_R0(a, b, c, d, e, 0);
-    SHA1_R0(e, a, b, c, d, 1);
-    SHA1_R0(d, e, a, b, c, 2);
-    SHA1_R0(c, d, e, a, b, 3);
-    SHA1_R0(b, c, d, e, a, 4);
-    SHA1_R0(a, b, c, d, e, 5);
-    SHA1_R0(e, a, b, c, d, 6);
-    SHA1_R0(d, e, a, b, c, 7);
-    SHA1_R0(c, d, e, a, b, 8);
-    SHA1_R0(b, c, d, e, a, 9);
-    SHA1_R0(a, b, c, d, e, 10);
-    SHA1_R0(e, a, b, c, d, 11);
-    SHA1_R0(d, e, a, b, c, 12);
-    SHA1_R0(c, d, e, a, b, 13);
-    SHA1_R0(b, c, d, e, a, 14);
-    SHA1_R0(a, b, c, d, e, 15);
-    SHA1_R1(e, a, b, c, d, 16);
-    SHA1_R1(d, e, a, b, c, 17);
-    SHA1_R1(c, d, e, a, b, 18);
-    SHA1_R1(b, c, d, e, a, 19);
-    SHA1_R2(a, b, c, d, e, 20);
-    SHA1_R2(e, a, b, c, d, 21);
-    SHA1_R2(d, e, a, b, c, 22);
-    SHA1_R2(c, d, e, a, b, 23);
-    SHA1_R2(b, c, d, e, a, 24);
-    SHA1_R2(a, b, c, d, e, 25);
-    SHA1_R2(e, a, b, c, d, 26);
-    SHA1_R2(d, e, a, b, c, 27);
-    SHA1_R2(c, d, e, a, b, 28);
-    SHA1_R2(b, c, d, e, a, 29);
-    SHA1_R2(a, b, c, d, e, 30);
-    SHA1_R2(e, a, b, c, d, 31);
-    SHA1_R2(d, e, a, b, c, 32);
-    SHA1_R2(c, d, e, a, b, 33);
-    SHA1_R2(b, c, d, e, a, 34);
-    SHA1_R2(a, b, c, d, e, 35);
-    SHA1_R2(e, a, b, c, d, 36);
-    SHA1_R2(d, e, a, b, c, 37);
-    SHA1_R2(c, d, e, a, b, 38);
-    SHA1_R2(b, c, d, e, a, 39);
-    SHA1_R3(a, b, c, d, e, 40);
-    SHA1_R3(e, a, b, c, d, 41);
-    SHA1_R3(d, e, a, b, c, 42);
-    SHA1_R3(c, d, e, a, b, 43);
-    SHA1_R3(b, c, d, e, a, 44);
-    SHA1_R3(a, b, c, d, e, 45);
-    SHA1_R3(e, a, b, c, d, 46);
-    SHA1_R3(d, e, a, b, c, 47);
-    SHA1_R3(c, d, e, a, b, 48);
-    SHA1_R3(b, c, d, e, a, 49);
-    SHA1_R3(a, b, c, d, e, 50);
-    SHA1_R3(e, a, b, c, d, 51);
-    SHA1_R3(d, e, a, b, c, 52);
-    SHA1_R3(c, d, e, a, b, 53);
-    SHA1_R3(b, c, d, e, a, 54);
-    SHA1_R3(a, b, c, d, e, 55);
-    SHA1_R3(e, a, b, c, d, 56);
-    SHA1_R3(d, e, a, b, c, 57);
-    SHA1_R3(c, d, e, a, b, 58);
-    SHA1_R3(b, c, d, e, a, 59);
-    SHA1_R4(a, b, c, d, e, 60);
-    SHA1_R4(e, a, b, c, d, 61);
-    SHA1_R4(d, e, a, b, c, 62);
-    SHA1_R4(c, d, e, a, b, 63);
-    SHA1_R4(b, c, d, e, a, 64);
-    SHA1_R4(a, b, c, d, e, 65);
-    SHA1_R4(e, a, b, c, d, 66);
-    SHA1_R4(d, e, a, b, c, 67);
-    SHA1_R4(c, d, e, a, b, 68);
-    SHA1_R4(b, c, d, e, a, 69);
-    SHA1_R4(a, b, c, d, e, 70);
-    SHA1_R4(e, a, b, c, d, 71);
-    SHA1_R4(d, e, a, b, c, 72);
-    SHA1_R4(c, d, e, a, b, 73);
-    SHA1_R4(b, c, d, e, a, 74);
-    SHA1_R4(a, b, c, d, e, 75);
-    SHA1_R4(e, a, b, c, d, 76);
-    SHA1_R4(d, e, a, b, c, 77);
-    SHA1_R4(c, d, e, a, b, 78);
-    SHA1_R4(b, c, d, e, a, 79);
-
-    /* Add the working vars back into digest[] */
-    m_digest[0] += a;
-    m_digest[1] += b;
-    m_digest[2] += c;
-    m_digest[3] += d;
-    m_digest[4] += e;
-
-    /* Count the number of transformations */
-    m_transforms++;
+    return sha1_get() != sha1_compress_portable;
 }
 
-void SHA1::buffer_to_block(const std::string& buffer, uint32 block[BLOCK_BYTES])
+bool SHA1::enable_hardware(bool enable)
 {
-    /* Convert the std::string (byte buffer) to a uint32 array (MSB) */
-    for (unsigned int i = 0; i < BLOCK_INTS; i++)
+    sha1_selected.store(true, std::memory_order_release);
+    sha1_compress.store(enable ? sha1_select() : sha1_compress_portable, std::memory_order_release);
+    return hardware_accelerated();
+}
+
+void SHA1::reset()
+{
+    init_state(m_digest);
+
+    /* Reset counters */
+    m_buffer_size = 0;
+    m_total       = 0;
+}
+
+void SHA1::finish(uint8_t* out)
+{
+    pad(m_digest, m_buffer, m_buffer_size, m_total);
+
+    for (size_t i = 0; i < DIGEST_INTS; i++)
     {
-        block[i] = (buffer[4 * i + 3] & 0xff) | (buffer[4 * i + 2] & 0xff) << 8 | (buffer[4 * i + 1] & 0xff) << 16 | (buffer[4 * i + 0] & 0xff) << 24;
+        out[i * 4]     = (m_digest[i] >> 24) & 0xFF;
+        out[i * 4 + 1] = (m_digest[i] >> 16) & 0xFF;
+        out[i * 4 + 2] = (m_digest[i] >> 8) & 0xFF;
+        out[i * 4 + 3] = m_digest[i] & 0xFF;
     }
+
+    reset();
 }
 
-void SHA1::read(std::istream& is, std::string& s, int max)
+void SHA1::init_state(uint32_t state[DIGEST_INTS])
 {
-    char sbuf[max];
-    is.read(sbuf, max);
-    s.assign(sbuf, is.gcount());
+    /* SHA1 initialization constants */
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+    state[4] = 0xc3d2e1f0;
+}
+
+/*
+ * Hash the last incomplete block, the 0x80 marker and the message length in bits.
+ * This takes one or two blocks, both live on the stack.
+ */
+void SHA1::pad(uint32_t state[DIGEST_INTS], const uint8_t* tail, size_t tail_size, uint64_t total)
+{
+    uint8_t  buffer[BLOCK_BYTES * 2] = {};
+    size_t   size                    = (tail_size + 9 > BLOCK_BYTES) ? BLOCK_BYTES * 2 : BLOCK_BYTES;
+    uint64_t total_bits              = total * 8;
+
+    if (tail_size > 0)
+    {
+        memcpy(buffer, tail, tail_size);
+    }
+    buffer[tail_size] = 0x80;
+    for (size_t i = 0; i < 8; i++)
+    {
+        buffer[size - 1 - i] = static_cast<uint8_t>(total_bits >> (i * 8));
+    }
+
+    process_blocks(state, buffer, size / BLOCK_BYTES);
 }
@@ -0,0 +1,272 @@
+#ifdef WITH_OPENSSL
+#include "SslContext.h"
+
+#include <arpa/inet.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+
+using namespace WebSocketCpp;
+
+constexpr size_t SslTicketKeys::KEY_COUNT;
+
+static uint64_t NowSec()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// the owner of a SSL_CTX, for the static OpenSSL callbacks
+static int CtxIndex()
+{
+    static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+static int PeerIndex()
+{
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+SslTicketKeys::SslTicketKeys(uint64_t lifetimeSec)
+    : m_lifetime(lifetimeSec)
+{
+}
+
+bool SslTicketKeys::Attach(SSL_CTX* ctx)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!Rotate(NowSec()))
+        {
+            return false;
+        }
+    }
+
+    SSL_CTX_set_ex_data(ctx, CtxIndex(), this);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    return SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, OnTicket) == 1;
+#else
+    return SSL_CTX_set_tlsext_ticket_key_cb(ctx, OnTicket) == 1;
+#endif
+}
+
+bool SslTicketKeys::Rotate(uint64_t now)
+{
+    Key key;
+    if (RAND_bytes(key.name, sizeof(key.name)) != 1 || RAND_bytes(key.aes, sizeof(key.aes)) != 1 || RAND_bytes(key.hmac, sizeof(key.hmac)) != 1)
+    {
+        return false;
+    }
+    key.created = now;
+
+    m_keys.push_front(key);
+    if (m_keys.size() > KEY_COUNT)
+    {
+        OPENSSL_cleanse(&m_keys.back(), sizeof(Key));
+        m_keys.pop_back();
+    }
+    return true;
+}
+
+const SslTicketKeys::Key* SslTicketKeys::Current()
+{
+    uint64_t now = NowSec();
+    if (now - m_keys.front().created >= m_lifetime)
+    {
+        // a failed rotation keeps the old key issuing, better than no tickets at all
+        Rotate(now);
+    }
+    return &m_keys.front();
+}
+
+const SslTicketKeys::Key* SslTicketKeys::Find(const uint8_t* name, bool& current)
+{
+    for (size_t i = 0; i < m_keys.size(); i++)
+    {
+        if (std::memcmp(m_keys[i].name, name, sizeof(m_keys[i].name)) == 0)
+        {
+            current = (i == 0);
+            return &m_keys[i];
+        }
+    }
+    return nullptr;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int SslTicketKeys::OnTicket(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int enc)
+#else
+int SslTicketKeys::OnTicket(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipher, HMAC_CTX* mac, int enc)
+#endif
+{
+    SslTicketKeys* keys = static_cast<SslTicketKeys*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), CtxIndex()));
+    if (keys == nullptr)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(keys->m_mutex);
+
+    const Key* key     = nullptr;
+    bool       current = true;
+    if (enc == 1)
+    {
+        key = keys->Current();
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1)
+        {
+            return -1;
+        }
+        std::memcpy(name, key->name, sizeof(key->name));
+        if (EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key->aes, iv) != 1)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        key = keys->Find(name, current);
+        if (key == nullptr)
+        {
+            return 0; // an unknown or expired key, do the full handshake
+        }
+        if (EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key->aes, iv) != 1)
+        {
+            return -1;
+        }
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<uint8_t*>(key->hmac), sizeof(key->hmac)),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+        OSSL_PARAM_construct_end(),
+    };
+    if (EVP_MAC_CTX_set_params(mac, params) != 1)
+    {
+        return -1;
+    }
+#else
+    if (HMAC_Init_ex(mac, key->hmac, sizeof(key->hmac), EVP_sha256(), nullptr) != 1)
+    {
+        return -1;
+    }
+#endif
+
+    // 2 asks OpenSSL to issue a new ticket, TLS 1.3 sends none on a resumption otherwise
+    // and the client would have to use the old one again
+    return (current && SSL_version(ssl) < TLS1_3_VERSION) ? 1 : 2;
+}
+
+SslClientContext::~SslClientContext()
+{
+    for (auto& session : m_sessions)
+    {
+        SSL_SESSION_free(session.second);
+    }
+    SSL_CTX_free(m_ctx);
+}
+
+std::shared_ptr<SslClientContext> SslClientContext::Get(const std::string& cert, const std::string& key, std::string& error)
+{
+    // the contexts live as long as the process, the sessions must survive the sockets
+    static std::mutex                                                        mutex;
+    static std::unordered_map<std::string, std::shared_ptr<SslClientContext>> contexts;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string                 id = cert + '\n' + key;
+    auto                        it = contexts.find(id);
+    if (it != contexts.end())
+    {
+        return it->second;
+    }
+
+    if (contexts.empty())
+    {
+        OpenSSL_add_all_algorithms();
+        SSL_load_error_strings();
+    }
+
+    std::shared_ptr<SslClientContext> context(new SslClientContext());
+    context->m_ctx = SSL_CTX_new(TLS_client_method());
+    if (context->m_ctx == nullptr)
+    {
+        error = "SSL_CTX_new failed";
+        return nullptr;
+    }
+
+    if (!cert.empty() && SSL_CTX_use_certificate_file(context->m_ctx, cert.c_str(), SSL_FILETYPE_PEM) <= 0)
+    {
+        error = "SSL_CTX_use_certificate_file failed";
+        return nullptr;
+    }
+
+    if (!key.empty() && SSL_CTX_use_PrivateKey_file(context->m_ctx, key.c_str(), SSL_FILETYPE_PEM) <= 0)
+    {
+        error = "SSL_CTX_use_PrivateKey_file failed";
+        return nullptr;
+    }
+
+    // OpenSSL only hands the sessions out, they are kept here by the peer
+    SSL_CTX_set_session_cache_mode(context->m_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context->m_ctx, OnNewSession);
+    SSL_CTX_set_ex_data(context->m_ctx, CtxIndex(), context.get());
+
+    contexts[id] = context;
+    return context;
+}
+
+SSL* SslClientContext::NewSsl(const std::string& host, const std::string* peer)
+{
+    SSL* ssl = SSL_new(m_ctx);
+    if (ssl == nullptr)
+    {
+        return nullptr;
+    }
+
+    SSL_set_ex_data(ssl, PeerIndex(), const_cast<std::string*>(peer));
+
+    // SNI takes a name only
+    in_addr  address4;
+    in6_addr address6;
+    if (!host.empty() && inet_pton(AF_INET, host.c_str(), &address4) != 1 && inet_pton(AF_INET6, host.c_str(), &address6) != 1)
+    {
+        SSL_set_tlsext_host_name(ssl, host.c_str());
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        it = m_sessions.find(*peer);
+    if (it != m_sessions.end())
+    {
+        SSL_set_session(ssl, it->second);
+    }
+
+    return ssl;
+}
+
+int SslClientContext::OnNewSession(SSL* ssl, SSL_SESSION* session)
+{
+    SslClientContext*  context = static_cast<SslClientContext*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), CtxIndex()));
+    const std::string* peer    = static_cast<const std::string*>(SSL_get_ex_data(ssl, PeerIndex()));
+    if (context == nullptr || peer == nullptr || !SSL_SESSION_is_resumable(session))
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(context->m_mutex);
+    SSL_SESSION*&               slot = context->m_sessions[*peer];
+    if (slot != nullptr)
+    {
+        SSL_SESSION_free(slot);
+    }
+    slot = session;
+
+    return 1; // the reference is kept
+}
+#endif // WITH_OPENSSL
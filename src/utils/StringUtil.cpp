@@ -1,49 +1,184 @@
 #include "StringUtil.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
 #include "iostream"
 
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define STRINGUTIL_HAVE_SIMD
+#include <immintrin.h>
+#endif
+
 using namespace WebSocketCpp;
 
 thread_local std::mt19937 StringUtil::m_rng;
 
-size_t StringUtil::SearchPosition(const ByteArray& str, const ByteArray& substring, size_t start, size_t end)
+/*
+ * Substring search: candidates are positions where both the first and the last
+ * byte of the needle match, checked 16/32 positions at a time, and only those
+ * are verified with memcmp. Single byte needles go straight to memchr.
+ */
+static const uint8_t* search_scalar(const uint8_t* data, size_t size, const uint8_t* needle, size_t needleSize, size_t pos)
 {
-    if (str.size() <= 0 || substring.size() <= 0)
+    const uint8_t* end = data + size - needleSize + 1;
+    const uint8_t* p   = data + pos;
+
+    while (p < end)
     {
-        return SIZE_MAX;
+        p = static_cast<const uint8_t*>(memchr(p, needle[0], end - p));
+        if (p == nullptr)
+        {
+            return nullptr;
+        }
+        if (memcmp(p + 1, needle + 1, needleSize - 1) == 0)
+        {
+            return p;
+        }
+        p++;
     }
 
-    const uint8_t* pstr         = str.data();
-    const uint8_t* psubstring   = substring.data();
-    size_t         substringLen = substring.size();
-    if (end == SIZE_MAX)
+    return nullptr;
+}
+
+#ifdef STRINGUTIL_HAVE_SIMD
+static const uint8_t* search_sse2(const uint8_t* data, size_t size, const uint8_t* needle, size_t needleSize)
+{
+    const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+    const __m128i last  = _mm_set1_epi8(static_cast<char>(needle[needleSize - 1]));
+    size_t        pos   = 0;
+
+    for (; pos + needleSize - 1 + 16 <= size; pos += 16)
     {
-        end = str.size() - 1;
+        __m128i  blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i  blockLast  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + needleSize - 1));
+        uint32_t mask       = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+
+        while (mask != 0)
+        {
+            unsigned int bit = __builtin_ctz(mask);
+            if (memcmp(data + pos + bit + 1, needle + 1, needleSize - 2) == 0)
+            {
+                return data + pos + bit;
+            }
+            mask &= mask - 1;
+        }
     }
 
-    for (size_t pos1 = start; pos1 <= end - substringLen + 1; pos1++)
+    return search_scalar(data, size, needle, needleSize, pos);
+}
+
+__attribute__((target("avx2"))) static const uint8_t* search_avx2(const uint8_t* data, size_t size, const uint8_t* needle, size_t needleSize)
+{
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    const __m256i last  = _mm256_set1_epi8(static_cast<char>(needle[needleSize - 1]));
+    size_t        pos   = 0;
+
+    for (; pos + needleSize - 1 + 32 <= size; pos += 32)
     {
-        size_t pos2;
-        for (pos2 = 0; pos2 < substringLen; pos2++)
+        __m256i  blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i  blockLast  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + needleSize - 1));
+        uint32_t mask       = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+
+        while (mask != 0)
         {
-            if (pstr[pos1 + pos2] == psubstring[pos2])
+            unsigned int bit = __builtin_ctz(mask);
+            if (memcmp(data + pos + bit + 1, needle + 1, needleSize - 2) == 0)
             {
-                continue;
+                return data + pos + bit;
             }
-            break;
+            mask &= mask - 1;
         }
+    }
 
-        if (pos2 == substringLen)
+    return search_sse2(data + pos, size - pos, needle, needleSize);
+}
+#endif
+
+#ifndef STRINGUTIL_HAVE_SIMD
+static const uint8_t* search_generic(const uint8_t* data, size_t size, const uint8_t* needle, size_t needleSize)
+{
+    return search_scalar(data, size, needle, needleSize, 0);
+}
+#endif
+
+typedef const uint8_t* (*search_func_t)(const uint8_t*, size_t, const uint8_t*, size_t);
+
+static search_func_t search_select()
+{
+#ifdef STRINGUTIL_HAVE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return search_avx2;
+    }
+    return search_sse2;
+#else
+    return search_generic;
+#endif
+}
+
+// starts with the baseline and switches on first use, no CPU probing during static initialization
+#ifdef STRINGUTIL_HAVE_SIMD
+static std::atomic<search_func_t> search_func{search_sse2};
+#else
+static std::atomic<search_func_t> search_func{search_generic};
+#endif
+static std::atomic<bool> search_selected{false};
+
+static search_func_t search_get()
+{
+    if (!search_selected.load(std::memory_order_acquire))
+    {
+        bool expected = false;
+        if (search_selected.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
         {
-            return pos1;
+            search_func.store(search_select(), std::memory_order_release);
         }
     }
+    return search_func.load(std::memory_order_acquire);
+}
 
-    return SIZE_MAX;
+const uint8_t* StringUtil::Search(const uint8_t* data, size_t size, const uint8_t* needle, size_t needleSize)
+{
+    if (needleSize == 0 || size < needleSize)
+    {
+        return nullptr;
+    }
+    if (needleSize == 1)
+    {
+        return static_cast<const uint8_t*>(memchr(data, needle[0], size));
+    }
+
+    return search_get()(data, size, needle, needleSize);
+}
+
+size_t StringUtil::SearchPosition(const ByteArray& str, const ByteArray& substring, size_t start, size_t end)
+{
+    if (str.size() <= 0 || substring.size() <= 0)
+    {
+        return SIZE_MAX;
+    }
+
+    if (end >= str.size())
+    {
+        end = str.size() - 1;
+    }
+    if (start > end)
+    {
+        return SIZE_MAX;
+    }
+
+    const uint8_t* found = Search(str.data() + start, end - start + 1, substring.data(), substring.size());
+    if (found == nullptr)
+    {
+        return SIZE_MAX;
+    }
+
+    return found - str.data();
 }
 
 StringUtil::Ranges StringUtil::Split(const ByteArray& str, const ByteArray& delimiter, size_t start, size_t end)
@@ -91,6 +226,59 @@ StringUtil::Ranges StringUtil::Split(const ByteArray& str, const ByteArray& deli
     return retval;
 }
 
+void StringUtil::LineTokenizer::Reset(size_t start)
+{
+    lineStart = start;
+    scanned   = start;
+}
+
+/*
+ * Appends the complete lines found since the previous call to `lines`.
+ * Returns the position of the terminating empty line or SIZE_MAX if it hasn't arrived yet.
+ * Bytes are searched only once, a partial line is resumed from where the search stopped.
+ */
+size_t StringUtil::LineTokenizer::Next(const ByteArray& data, Ranges& lines)
+{
+    static const uint8_t crlf[] = {CR, LF};
+
+    const uint8_t* begin = data.data();
+    const size_t   size  = data.size();
+
+    while (true)
+    {
+        size_t from = std::max(lineStart, scanned);
+        if (from >= size)
+        {
+            return SIZE_MAX;
+        }
+
+        const uint8_t* found = Search(begin + from, size - from, crlf, sizeof(crlf));
+        if (found == nullptr)
+        {
+            // the last byte may be CR of a CRLF which is not complete yet
+            scanned = std::max(lineStart, size - 1);
+            return SIZE_MAX;
+        }
+
+        size_t eol = found - begin;
+        if (eol == lineStart)
+        {
+            return eol;
+        }
+
+        lines.push_back(Range{lineStart, eol - 1});
+        lineStart = eol + sizeof(crlf);
+        scanned   = lineStart;
+    }
+}
+
+size_t StringUtil::TokenizeLines(const ByteArray& data, size_t start, Ranges& lines)
+{
+    LineTokenizer tokenizer;
+    tokenizer.Reset(start);
+    return tokenizer.Next(data, lines);
+}
+
 size_t StringUtil::SearchPositionReverse(const ByteArray& str, const ByteArray& substring, size_t start, size_t end)
 {
     const uint8_t* pstr         = str.data();
@@ -448,6 +636,77 @@ void StringUtil::Replace(std::string& str, const std::string& find, const std::s
     }
 }
 
+/*
+ * WebSocket masking: the key is XORed in memory order, so a 32-bit key loaded
+ * from the frame works for whole words as it is and 16 bytes are processed a
+ * time (8 without SIMD), only the tail goes byte by byte.
+ */
+namespace
+{
+
+struct MaskKeyPool
+{
+    static constexpr size_t BATCH = 64;
+
+    MaskKeyPool()
+    {
+        std::random_device rd;
+        std::seed_seq      seed{rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd()};
+        rng.seed(seed);
+    }
+
+    std::mt19937 rng;
+    uint32_t     keys[BATCH];
+    size_t       next = BATCH;
+};
+
+thread_local MaskKeyPool mask_key_pool;
+
+} // namespace
+
+uint32_t StringUtil::MaskKey()
+{
+    MaskKeyPool& pool = mask_key_pool;
+    if (pool.next == MaskKeyPool::BATCH)
+    {
+        for (auto& key : pool.keys)
+        {
+            key = static_cast<uint32_t>(pool.rng());
+        }
+        pool.next = 0;
+    }
+    return pool.keys[pool.next++];
+}
+
+void StringUtil::MaskCopy(uint8_t* dst, const uint8_t* src, size_t size, uint32_t key)
+{
+    size_t i = 0;
+
+#ifdef STRINGUTIL_HAVE_SIMD
+    const __m128i key128 = _mm_set1_epi32(static_cast<int>(key));
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(chunk, key128));
+    }
+#endif
+
+    const uint64_t key64 = (static_cast<uint64_t>(key) << 32) | key;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t chunk;
+        std::memcpy(&chunk, src + i, sizeof(chunk));
+        chunk ^= key64;
+        std::memcpy(dst + i, &chunk, sizeof(chunk));
+    }
+
+    const uint8_t* keyBytes = reinterpret_cast<const uint8_t*>(&key);
+    for (; i < size; i++)
+    {
+        dst[i] = src[i] ^ keyBytes[i & 3];
+    }
+}
+
 void StringUtil::RandInit()
 {
     m_rng.seed(std::random_device{}());
@@ -479,11 +738,16 @@ bool StringUtil::Compare(const ByteArray& arr1, const ByteArray& arr2)
 
 bool StringUtil::Compare(const std::string& a, const std::string& b)
 {
-    if (a.size() != b.size())
+    return Compare(a.data(), a.size(), b.data(), b.size());
+}
+
+bool StringUtil::Compare(const char* str1, size_t length1, const char* str2, size_t length2)
+{
+    if (length1 != length2)
         return false;
-    for (size_t i = 0; i < a.size(); ++i)
+    for (size_t i = 0; i < length1; ++i)
     {
-        if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i]))
+        if (std::tolower((unsigned char)str1[i]) != std::tolower((unsigned char)str2[i]))
         {
             return false;
         }
@@ -0,0 +1,193 @@
+#include "TimerWheel.h"
+
+using namespace WebSocketCpp;
+
+constexpr size_t   TimerWheel::LEVEL_BITS;
+constexpr size_t   TimerWheel::LEVELS;
+constexpr size_t   TimerWheel::SLOTS;
+constexpr uint64_t TimerWheel::SLOT_MASK;
+constexpr uint64_t TimerWheel::MAX_TICKS;
+constexpr uint32_t TimerWheel::NIL;
+constexpr uint32_t TimerWheel::EXPIRING;
+
+TimerWheel::TimerWheel(size_t capacity, uint64_t tickMs, uint64_t nowMs)
+    : m_tick_ms(tickMs > 0 ? tickMs : 1),
+      m_start_ms(nowMs),
+      m_nodes(capacity),
+      m_heads(EXPIRING + 1, NIL)
+{
+}
+
+void TimerWheel::Schedule(uint32_t id, uint64_t expireMs)
+{
+    if (id >= m_nodes.size())
+    {
+        return;
+    }
+
+    Cancel(id);
+
+    // rounded up, a timer never fires before its time
+    uint64_t elapsed   = expireMs > m_start_ms ? expireMs - m_start_ms : 0;
+    m_nodes[id].expire = (elapsed + m_tick_ms - 1) / m_tick_ms;
+    Insert(id);
+    m_count++;
+}
+
+void TimerWheel::Cancel(uint32_t id)
+{
+    if (IsScheduled(id))
+    {
+        Unlink(id);
+        m_count--;
+    }
+}
+
+bool TimerWheel::IsScheduled(uint32_t id) const
+{
+    return id < m_nodes.size() && m_nodes[id].slot != NIL;
+}
+
+size_t TimerWheel::GetCount() const
+{
+    return m_count;
+}
+
+size_t TimerWheel::Advance(uint64_t nowMs, const ExpiredCallback& callback)
+{
+    uint64_t target  = (nowMs > m_start_ms ? nowMs - m_start_ms : 0) / m_tick_ms;
+    size_t   expired = 0;
+
+    while (m_tick <= target && m_count > 0)
+    {
+        size_t index = m_tick & SLOT_MASK;
+        if (index == 0)
+        {
+            // the lower level wrapped around, bring the next slot of the upper one down
+            for (size_t level = 1; level < LEVELS; level++)
+            {
+                size_t upper = (m_tick >> (LEVEL_BITS * level)) & SLOT_MASK;
+                Cascade(level, upper);
+                if (upper != 0)
+                {
+                    break;
+                }
+            }
+        }
+        m_tick++;
+
+        // moved aside since the callbacks may schedule into this very slot again
+        uint32_t id       = m_heads[index];
+        m_heads[index]    = NIL;
+        m_heads[EXPIRING] = id;
+        for (; id != NIL; id = m_nodes[id].next)
+        {
+            m_nodes[id].slot = EXPIRING;
+        }
+
+        while ((id = m_heads[EXPIRING]) != NIL)
+        {
+            Unlink(id);
+            m_count--;
+            expired++;
+            callback(id);
+        }
+    }
+
+    if (m_count == 0 && m_tick <= target)
+    {
+        m_tick = target + 1; // nothing to walk through
+    }
+
+    return expired;
+}
+
+uint64_t TimerWheel::NextTimeoutMs(uint64_t nowMs) const
+{
+    if (m_count == 0)
+    {
+        return UINT64_MAX;
+    }
+
+    // either a level 0 slot with timers or the wrap around that cascades the next level
+    uint64_t tick = m_tick;
+    while ((tick & SLOT_MASK) != 0 && m_heads[tick & SLOT_MASK] == NIL)
+    {
+        tick++;
+    }
+
+    uint64_t due = m_start_ms + tick * m_tick_ms;
+    return due > nowMs ? due - nowMs : 0;
+}
+
+void TimerWheel::Insert(uint32_t id)
+{
+    uint64_t expire = m_nodes[id].expire;
+    if (expire < m_tick)
+    {
+        expire = m_tick; // overdue, goes with the next tick
+    }
+    uint64_t delta = expire - m_tick;
+    if (delta > MAX_TICKS)
+    {
+        // waits in the last level and cascades there again until it's close enough
+        delta  = MAX_TICKS;
+        expire = m_tick + MAX_TICKS;
+    }
+
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= (1ULL << (LEVEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+
+    size_t index = (expire >> (LEVEL_BITS * level)) & SLOT_MASK;
+    Link(id, static_cast<uint32_t>(level * SLOTS + index));
+}
+
+void TimerWheel::Link(uint32_t id, uint32_t slot)
+{
+    Node& node = m_nodes[id];
+    node.slot  = slot;
+    node.prev  = NIL;
+    node.next  = m_heads[slot];
+    if (node.next != NIL)
+    {
+        m_nodes[node.next].prev = id;
+    }
+    m_heads[slot] = id;
+}
+
+void TimerWheel::Unlink(uint32_t id)
+{
+    Node& node = m_nodes[id];
+    if (node.prev != NIL)
+    {
+        m_nodes[node.prev].next = node.next;
+    }
+    else
+    {
+        m_heads[node.slot] = node.next;
+    }
+    if (node.next != NIL)
+    {
+        m_nodes[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+    node.slot = NIL;
+}
+
+void TimerWheel::Cascade(size_t level, size_t index)
+{
+    uint32_t slot = static_cast<uint32_t>(level * SLOTS + index);
+    uint32_t id   = m_heads[slot];
+    m_heads[slot] = NIL;
+
+    while (id != NIL)
+    {
+        uint32_t next = m_nodes[id].next;
+        Insert(id);
+        id = next;
+    }
+}
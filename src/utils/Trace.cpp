@@ -0,0 +1,56 @@
+#include "Trace.h"
+
+using namespace WebSocketCpp;
+
+constexpr size_t Trace::POINT_COUNT;
+
+std::atomic<uint32_t> Trace::m_sampleRate{1};
+
+void Trace::SetSampleRate(uint32_t rate)
+{
+    m_sampleRate.store(rate, std::memory_order_relaxed);
+}
+
+uint32_t Trace::GetSampleRate()
+{
+    return m_sampleRate.load(std::memory_order_relaxed);
+}
+
+Trace::Context& Trace::Current()
+{
+    static thread_local Context context;
+    return context;
+}
+
+#ifdef WITH_TRACING
+void Trace::Context::Finish()
+{
+    if (!active)
+    {
+        return;
+    }
+    active = false;
+
+    auto& metrics = Metrics::Instance();
+    for (size_t i = 1; i < POINT_COUNT; i++)
+    {
+        // a stage is skipped if one of its ends wasn't passed, e.g. an earlier wake up parsed the frame
+        uint64_t from = stamps[i - 1];
+        uint64_t to   = stamps[i];
+        if (from == 0 || to < from)
+        {
+            continue;
+        }
+
+        auto histogram = static_cast<Metrics::Histogram>(static_cast<size_t>(Metrics::Histogram::TraceReadNs) + i - 1);
+        metrics.Record(histogram, to - from);
+    }
+
+    uint64_t start = stamps[static_cast<size_t>(Point::EpollReturn)];
+    uint64_t end   = stamps[static_cast<size_t>(Point::HandlerEnd)];
+    if (end >= start && end != 0)
+    {
+        metrics.Record(Metrics::Histogram::TraceTotalNs, end - start);
+    }
+}
+#endif
@@ -1,15 +1,20 @@
 #include "MemoryPool.h"
 
+#include "Metrics.h"
+
 WebSocketCpp::MemoryPool::MemoryPool(std::size_t total_size)
     : m_total_size(total_size),
       m_used_size(0)
 {
     m_buffer.resize(total_size);
     m_regions.reserve(DEFAULT_BLOCK_COUNT);
+    Metrics::Instance().Add(Metrics::Gauge::MemoryPoolTotalBytes, static_cast<int64_t>(m_total_size));
 }
 
 WebSocketCpp::MemoryPool::~MemoryPool()
 {
+    Metrics::Instance().Add(Metrics::Gauge::MemoryPoolTotalBytes, -static_cast<int64_t>(m_total_size));
+    Metrics::Instance().Add(Metrics::Gauge::MemoryPoolUsedBytes, -static_cast<int64_t>(m_used_size));
 }
 
 uint8_t* WebSocketCpp::MemoryPool::allocate(std::size_t size)
@@ -29,6 +34,7 @@ uint8_t* WebSocketCpp::MemoryPool::allocate(std::size_t size)
         {
             m_regions.insert(m_regions.begin() + i, {cursor, size});
             m_used_size += size;
+            Metrics::Instance().Add(Metrics::Gauge::MemoryPoolUsedBytes, static_cast<int64_t>(size));
             return m_buffer.data() + cursor;
         }
         cursor = m_regions[i].m_offset + m_regions[i].m_size;
@@ -38,6 +44,7 @@ uint8_t* WebSocketCpp::MemoryPool::allocate(std::size_t size)
     {
         m_regions.push_back({cursor, size});
         m_used_size += size;
+        Metrics::Instance().Add(Metrics::Gauge::MemoryPoolUsedBytes, static_cast<int64_t>(size));
         return m_buffer.data() + cursor;
     }
 
@@ -59,6 +66,32 @@ void WebSocketCpp::MemoryPool::free(const uint8_t* ptr)
         if (m_regions[i].m_offset != offset)
             continue;
         m_used_size -= m_regions[i].m_size;
+        Metrics::Instance().Add(Metrics::Gauge::MemoryPoolUsedBytes, -static_cast<int64_t>(m_regions[i].m_size));
         m_regions.erase(m_regions.begin() + i);
     }
 }
+
+void WebSocketCpp::MemoryPool::shrink(const uint8_t* ptr, std::size_t size)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    std::size_t offset = static_cast<std::size_t>(ptr - m_buffer.data());
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (std::size_t i = 0; i < m_regions.size(); ++i)
+    {
+        if (m_regions[i].m_offset != offset)
+            continue;
+        if (size < m_regions[i].m_size)
+        {
+            std::size_t released = m_regions[i].m_size - size;
+            m_regions[i].m_size  = size;
+            m_used_size -= released;
+            Metrics::Instance().Add(Metrics::Gauge::MemoryPoolUsedBytes, -static_cast<int64_t>(released));
+        }
+        return;
+    }
+}
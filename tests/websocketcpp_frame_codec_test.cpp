@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "FrameCodec.h"
+#include "RequestWebSocket.h"
+#include "ResponseWebSocket.h"
+#include "common.h"
+
+using namespace WebSocketCpp;
+
+static ByteArray MakePayload(size_t size)
+{
+    ByteArray payload(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        payload[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    return payload;
+}
+
+template <Role ROLE, Role PEER>
+static void RoundTrip(size_t size)
+{
+    ByteArray payload = MakePayload(size);
+    ByteArray frame;
+    FrameCodec<ROLE>::Encode(frame, MessageType::Binary, payload.data(), payload.size());
+    ASSERT_EQ(frame.size(), FrameCodec<ROLE>::HeaderSize(size) + size);
+
+    FrameHeader header;
+    ASSERT_EQ(FrameCodec<PEER>::ParseHeader(frame.data(), frame.size(), header), FrameCodec<PEER>::Result::Ok);
+    EXPECT_TRUE(header.fin);
+    EXPECT_EQ(header.opcode, static_cast<uint8_t>(MessageType::Binary));
+    EXPECT_EQ(header.masked, FrameCodec<ROLE>::MASKED);
+    EXPECT_EQ(header.payloadSize, size);
+    EXPECT_EQ(header.headerSize, FrameCodec<ROLE>::HeaderSize(size));
+    ASSERT_EQ(FrameCodec<PEER>::FrameSize(header), frame.size());
+
+    ByteArray decoded(size);
+    FrameCodec<PEER>::DecodePayload(header, frame.data(), decoded.data());
+    EXPECT_EQ(decoded, payload);
+}
+
+TEST(FrameCodecTest, HeaderSizes)
+{
+    EXPECT_EQ(ServerFrameCodec::HeaderSize(0), 2u);
+    EXPECT_EQ(ServerFrameCodec::HeaderSize(125), 2u);
+    EXPECT_EQ(ServerFrameCodec::HeaderSize(126), 4u);
+    EXPECT_EQ(ServerFrameCodec::HeaderSize(65535), 4u);
+    EXPECT_EQ(ServerFrameCodec::HeaderSize(65536), 10u);
+    EXPECT_EQ(ClientFrameCodec::HeaderSize(0), 6u);
+    EXPECT_EQ(ClientFrameCodec::HeaderSize(65536), ClientFrameCodec::MAX_HEADER_SIZE);
+}
+
+TEST(FrameCodecTest, LengthIsBigEndian)
+{
+    uint8_t header[ServerFrameCodec::MAX_HEADER_SIZE];
+
+    ASSERT_EQ(ServerFrameCodec::WriteHeader(header, MessageType::Text, 300, 0), 4u);
+    EXPECT_EQ(header[0], 0x81);
+    EXPECT_EQ(header[1], 126);
+    EXPECT_EQ(header[2], 0x01);
+    EXPECT_EQ(header[3], 0x2C);
+
+    ASSERT_EQ(ServerFrameCodec::WriteHeader(header, MessageType::Binary, 0x0102030405ULL, 0, false), 10u);
+    EXPECT_EQ(header[0], 0x02);
+    EXPECT_EQ(header[1], 127);
+    const uint8_t expected[] = {0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05};
+    EXPECT_EQ(std::memcmp(header + 2, expected, sizeof(expected)), 0);
+}
+
+TEST(FrameCodecTest, ClientHeaderCarriesMaskKey)
+{
+    uint8_t  header[ClientFrameCodec::MAX_HEADER_SIZE];
+    uint32_t key = 0x11223344;
+    ASSERT_EQ(ClientFrameCodec::WriteHeader(header, MessageType::Text, 5, key), 6u);
+    EXPECT_EQ(header[1], 0x80 | 5);
+    EXPECT_EQ(std::memcmp(header + 2, &key, sizeof(key)), 0);
+}
+
+TEST(FrameCodecTest, ClientToServerRoundTrip)
+{
+    for (size_t size : {0, 1, 125, 126, 300, 65535, 65536, 100000})
+    {
+        RoundTrip<Role::Client, Role::Server>(size);
+    }
+}
+
+TEST(FrameCodecTest, ServerToClientRoundTrip)
+{
+    for (size_t size : {0, 1, 125, 126, 300, 65535, 65536, 100000})
+    {
+        RoundTrip<Role::Server, Role::Client>(size);
+    }
+}
+
+TEST(FrameCodecTest, TruncatedHeaderIsIncomplete)
+{
+    ByteArray payload = MakePayload(70000);
+    ByteArray frame;
+    ClientFrameCodec::Encode(frame, MessageType::Binary, payload.data(), payload.size());
+
+    FrameHeader header;
+    for (size_t size = 0; size < ClientFrameCodec::MAX_HEADER_SIZE; size++)
+    {
+        EXPECT_EQ(ServerFrameCodec::ParseHeader(frame.data(), size, header), ServerFrameCodec::Result::Incomplete) << size;
+    }
+    EXPECT_EQ(ServerFrameCodec::ParseHeader(frame.data(), ClientFrameCodec::MAX_HEADER_SIZE, header), ServerFrameCodec::Result::Ok);
+}
+
+TEST(FrameCodecTest, OversizedLengthIsError)
+{
+    const uint8_t frame[] = {0x82, 127, 0x80, 0, 0, 0, 0, 0, 0, 0};
+    FrameHeader   header;
+    EXPECT_EQ(ServerFrameCodec::ParseHeader(frame, sizeof(frame), header), ServerFrameCodec::Result::Error);
+}
+
+TEST(FrameCodecTest, RequestParsesEmptyPing)
+{
+    ByteArray frame;
+    ClientFrameCodec::Encode(frame, MessageType::Ping, nullptr, 0);
+
+    RequestWebSocket request;
+    ASSERT_TRUE(request.Parse(frame));
+    EXPECT_EQ(request.GetType(), MessageType::Ping);
+    EXPECT_EQ(request.GetSize(), frame.size());
+    EXPECT_TRUE(request.GetData().empty());
+}
+
+TEST(FrameCodecTest, ResponseParsesExtendedLength)
+{
+    ByteArray payload = MakePayload(300);
+    ByteArray frame;
+    ServerFrameCodec::Encode(frame, MessageType::Text, payload.data(), payload.size());
+
+    ResponseWebSocket response(0);
+    EXPECT_FALSE(response.Parse(ByteArray(frame.begin(), frame.begin() + 1)));
+    EXPECT_FALSE(response.Parse(ByteArray(frame.begin(), frame.end() - 1)));
+    ASSERT_TRUE(response.Parse(frame));
+    EXPECT_EQ(response.GetMessageType(), MessageType::Text);
+    EXPECT_EQ(response.GetSize(), frame.size());
+    EXPECT_EQ(response.GetData(), payload);
+}
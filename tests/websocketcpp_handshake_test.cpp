@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "Data.h"
+#include "FileSystem.h"
+#include "HandshakeResponse.h"
+#include "Response.h"
+#include "Sha1.h"
+
+using namespace WebSocketCpp;
+
+static std::string ToHex(const uint8_t* data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string       str;
+    for (size_t i = 0; i < size; i++)
+    {
+        str += digits[data[i] >> 4];
+        str += digits[data[i] & 0x0f];
+    }
+    return str;
+}
+
+TEST(Handshake, Sha1KnownVectors)
+{
+    uint8_t digest[Data::SHA1_DIGEST_LENGTH];
+
+    SHA1::digest(reinterpret_cast<const uint8_t*>(""), 0, digest);
+    EXPECT_EQ(ToHex(digest, sizeof(digest)), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+
+    const std::string abc = "abc";
+    SHA1::digest(reinterpret_cast<const uint8_t*>(abc.data()), abc.size(), digest);
+    EXPECT_EQ(ToHex(digest, sizeof(digest)), "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    const std::string two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    SHA1::digest(reinterpret_cast<const uint8_t*>(two_blocks.data()), two_blocks.size(), digest);
+    EXPECT_EQ(ToHex(digest, sizeof(digest)), "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+}
+
+TEST(Handshake, Sha1OneShotMatchesStreaming)
+{
+    std::mt19937 rng(42);
+    for (size_t size = 0; size < 300; size++)
+    {
+        std::string str(size, '\0');
+        for (auto& c : str)
+        {
+            c = static_cast<char>(rng());
+        }
+
+        uint8_t digest[Data::SHA1_DIGEST_LENGTH];
+        SHA1::digest(reinterpret_cast<const uint8_t*>(str.data()), str.size(), digest);
+        auto expected = Data::Sha1Digest(str);
+
+        EXPECT_EQ(0, memcmp(digest, expected.data(), sizeof(digest))) << "size " << size;
+    }
+}
+
+TEST(Handshake, Sha1ChunkedUpdate)
+{
+    std::string    str(1000000, 'a');
+    SHA1           checksum;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(str.data());
+
+    // odd chunk sizes exercise the partial block buffer
+    size_t pos = 0;
+    for (size_t chunk = 1; pos < str.size(); chunk = chunk * 3 + 1)
+    {
+        size_t n = std::min(chunk % 1000 + 1, str.size() - pos);
+        checksum.update(data + pos, n);
+        pos += n;
+    }
+
+    EXPECT_EQ(checksum.final(), "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
+
+TEST(Handshake, Sha1HardwareMatchesPortable)
+{
+    if (SHA1::enable_hardware(true) == false)
+    {
+        GTEST_SKIP() << "SHA extensions are not available";
+    }
+
+    std::mt19937 rng(7);
+    for (size_t size = 0; size < 1100; size += 13)
+    {
+        std::string str(size, '\0');
+        for (auto& c : str)
+        {
+            c = static_cast<char>(rng());
+        }
+
+        uint8_t hardware[Data::SHA1_DIGEST_LENGTH];
+        uint8_t portable[Data::SHA1_DIGEST_LENGTH];
+
+        SHA1::enable_hardware(true);
+        SHA1::digest(reinterpret_cast<const uint8_t*>(str.data()), str.size(), hardware);
+        SHA1::enable_hardware(false);
+        SHA1::digest(reinterpret_cast<const uint8_t*>(str.data()), str.size(), portable);
+
+        EXPECT_EQ(0, memcmp(hardware, portable, sizeof(hardware))) << "size " << size;
+    }
+
+    SHA1::enable_hardware(true);
+}
+
+TEST(Handshake, Base64FixedBuffer)
+{
+    const char* inputs[]   = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char* expected[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    {
+        char   out[16];
+        size_t len = Data::Base64Encode(reinterpret_cast<const uint8_t*>(inputs[i]), strlen(inputs[i]), out);
+        EXPECT_EQ(len, Data::Base64EncodedLength(strlen(inputs[i])));
+        EXPECT_EQ(std::string(out, len), expected[i]);
+        EXPECT_EQ(Data::Base64Encode(inputs[i]), expected[i]);
+    }
+}
+
+TEST(Handshake, AcceptKeyRfcSample)
+{
+    const std::string key = "dGhlIHNhbXBsZSBub25jZQ==";
+    char              accept[HandshakeResponse::ACCEPT_KEY_LENGTH];
+
+    ASSERT_TRUE(HandshakeResponse::ComputeAcceptKey(key.data(), key.size(), accept));
+    EXPECT_EQ(std::string(accept, sizeof(accept)), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(Handshake, AcceptKeyTooLong)
+{
+    std::string key(HandshakeResponse::MAX_KEY_LENGTH + 1, 'a');
+    char        accept[HandshakeResponse::ACCEPT_KEY_LENGTH];
+
+    EXPECT_FALSE(HandshakeResponse::ComputeAcceptKey(key.data(), key.size(), accept));
+}
+
+TEST(Handshake, CachedDateTime)
+{
+    char   buffer[FileSystem::DATE_TIME_LENGTH + 1];
+    size_t size = FileSystem::GetDateTime(buffer, sizeof(buffer));
+
+    EXPECT_EQ(size, FileSystem::DATE_TIME_LENGTH);
+    EXPECT_EQ(strlen(buffer), size);
+    EXPECT_EQ(std::string(buffer + size - 4), " GMT");
+}
+
+TEST(Handshake, TemplateIsValidResponse)
+{
+    HandshakeResponse handshake;
+    handshake.Init(Config::Instance().GetServerName());
+    ASSERT_TRUE(handshake.Build("dGhlIHNhbXBsZSBub25jZQ=="));
+
+    Response response(0, Config::Instance());
+    ASSERT_TRUE(response.Parse(handshake.GetData())) << response.GetLastError();
+    EXPECT_EQ(response.GetResponseCode(), 101);
+    EXPECT_EQ(response.GetResponseSize(), handshake.GetData().size());
+
+    auto& header = response.GetHeader();
+    EXPECT_EQ(header.GetHeader(Header::HeaderType::Server), Config::Instance().GetServerName());
+    EXPECT_EQ(header.GetHeader(Header::HeaderType::Upgrade), "websocket");
+    EXPECT_EQ(header.GetHeader(Header::HeaderType::Connection), "Upgrade");
+    EXPECT_EQ(header.GetHeader(Header::HeaderType::Date).size(), FileSystem::DATE_TIME_LENGTH);
+    EXPECT_EQ(header.GetHeader("Sec-WebSocket-Accept"), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+    EXPECT_EQ(header.GetHeader("Sec-WebSocket-Version"), "13");
+}
+
+TEST(Handshake, ResponseParsedIncrementally)
+{
+    HandshakeResponse handshake;
+    handshake.Init(Config::Instance().GetServerName());
+    ASSERT_TRUE(handshake.Build("dGhlIHNhbXBsZSBub25jZQ=="));
+    const ByteArray& full = handshake.GetData();
+
+    // the first frame may share the read with the end of the handshake
+    const ByteArray frame = {0x81, 0x02, 'h', 'i'};
+
+    Response  response(0, Config::Instance());
+    ByteArray data;
+    for (size_t i = 0; i < full.size() - 1; i++)
+    {
+        data.push_back(full[i]);
+        EXPECT_FALSE(response.Parse(data));
+        EXPECT_NE(response.GetParseState(), Response::ParseState::Error);
+    }
+
+    data.push_back(full.back());
+    data.insert(data.end(), frame.begin(), frame.end());
+    ASSERT_TRUE(response.Parse(data)) << response.GetLastError();
+    EXPECT_EQ(response.GetParseState(), Response::ParseState::Complete);
+    EXPECT_EQ(response.GetResponseCode(), 101);
+    EXPECT_EQ(response.GetResponseSize(), full.size());
+    EXPECT_EQ(response.GetHeader().GetHeader("Sec-WebSocket-Accept"), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(Handshake, ResponseMalformedStatusLine)
+{
+    const std::string str = "HTTP/1.1 abc Switching\r\n\r\n";
+    ByteArray         data(str.begin(), str.end());
+
+    Response response(0, Config::Instance());
+    EXPECT_FALSE(response.Parse(data));
+    EXPECT_EQ(response.GetParseState(), Response::ParseState::Error);
+}
+
+TEST(Handshake, BuildWithoutInitFails)
+{
+    HandshakeResponse handshake;
+    EXPECT_FALSE(handshake.Build("dGhlIHNhbXBsZSBub25jZQ=="));
+}
@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+#include "AccessLog.h"
+#include "Config.h"
+#include "FileSystem.h"
+#include "LogWriter.h"
+#include "MpscQueue.h"
+#include <arpa/inet.h>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+using WebSocketCpp::AccessLog;
+using WebSocketCpp::FileSystem;
+using WebSocketCpp::MpscQueue;
+
+static std::string TestFolder(const std::string& name) {
+    // TempFolder() returns a new random path
+    std::string folder = FileSystem::TempFolder() + "_" + name;
+    FileSystem::CreateFolder(folder);
+    return folder;
+}
+
+TEST(MpscQueue, CapacityRoundsUpToPowerOfTwo) {
+    MpscQueue<int> queue(100);
+    EXPECT_EQ(queue.capacity(), 128u);
+}
+
+TEST(MpscQueue, PopFromEmptyQueueFails) {
+    MpscQueue<int> queue(4);
+    int value = 0;
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(MpscQueue, RejectsPushWhenFull) {
+    MpscQueue<int> queue(4);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.TryPush(std::move(i)));
+    }
+    EXPECT_FALSE(queue.TryPush(42));
+
+    int value = -1;
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.TryPush(42));
+}
+
+TEST(MpscQueue, ManyProducersKeepPerProducerOrder) {
+    const int producers = 4;
+    const int perProducer = 20000;
+    MpscQueue<int> queue(256);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p, perProducer]() {
+            for (int i = 0; i < perProducer; i++) {
+                int value = p * perProducer + i;
+                while (!queue.TryPush(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> last(producers, -1);
+    int received = 0;
+    while (received < producers * perProducer) {
+        int value;
+        if (!queue.TryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int p = value / perProducer;
+        int i = value % perProducer;
+        ASSERT_EQ(i, last[p] + 1);
+        last[p] = i;
+        received++;
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    int value;
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(LogWriter, DisabledTypeIsSkipped) {
+    auto& writer = LogWriter::Instance();
+    writer.SetEnabled(LogWriter::LogType::Info, false);
+    EXPECT_FALSE(writer.IsEnabled(LogWriter::LogType::Info));
+
+    bool built = false;
+    LOG((built = true, std::string("never")), LogWriter::LogType::Info);
+    EXPECT_FALSE(built);
+
+    writer.SetEnabled(LogWriter::LogType::Info, true);
+    LOG((built = true, std::string("logged")), LogWriter::LogType::Info);
+    EXPECT_TRUE(built);
+    writer.Flush();
+}
+
+TEST(LogWriter, ConcurrentWritersAreAccounted) {
+    auto& writer = LogWriter::Instance();
+    uint64_t droppedBefore = writer.GetDropped(LogWriter::LogType::Access);
+
+    const int threads = 4;
+    const int perThread = 5000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t, perThread]() {
+            for (int i = 0; i < perThread; i++) {
+                LOG("writer " + std::to_string(t) + " line " + std::to_string(i), LogWriter::LogType::Access);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    writer.Flush();
+
+    uint64_t dropped = writer.GetDropped(LogWriter::LogType::Access) - droppedBefore;
+    EXPECT_LE(dropped, static_cast<uint64_t>(threads * perThread));
+}
+
+TEST(AccessLog, RecordParsesRemote) {
+    auto v4 = AccessLog::MakeRecord(AccessLog::Event::Connect, 7, "10.1.2.3:4567");
+    EXPECT_EQ(v4.connID, 7u);
+    EXPECT_EQ(v4.event, static_cast<uint8_t>(AccessLog::Event::Connect));
+    EXPECT_EQ(v4.family, AF_INET);
+    EXPECT_EQ(v4.port, 4567);
+    EXPECT_EQ(v4.address[0], 10);
+    EXPECT_EQ(v4.address[3], 3);
+
+    auto v6 = AccessLog::MakeRecord(AccessLog::Event::Disconnect, 8, "[::1]:80");
+    EXPECT_EQ(v6.family, AF_INET6);
+    EXPECT_EQ(v6.port, 80);
+    EXPECT_EQ(v6.address[15], 1);
+
+    auto none = AccessLog::MakeRecord(AccessLog::Event::Disconnect, 9, "");
+    EXPECT_EQ(none.family, 0);
+    EXPECT_NE(none.timeUs, 0u);
+}
+
+TEST(AccessLog, AppendAndLoadBack) {
+    std::string file = TestFolder("append") + "/access.bin";
+    {
+        AccessLog log;
+        ASSERT_TRUE(log.Open(file, 4096));
+        for (int i = 0; i < 10; i++) {
+            EXPECT_TRUE(log.Append(AccessLog::MakeRecord(AccessLog::Event::Connect, i, "127.0.0.1:1000")));
+        }
+    }
+    {
+        // reopening continues after the stored records
+        AccessLog log;
+        ASSERT_TRUE(log.Open(file, 4096));
+        EXPECT_EQ(log.GetCount(), 10u);
+        EXPECT_TRUE(log.Append(AccessLog::MakeRecord(AccessLog::Event::Disconnect, 10, "")));
+    }
+
+    EXPECT_EQ(FileSystem::GetFileSize(file), static_cast<int>(sizeof(AccessLog::FileHeader) + 11 * sizeof(AccessLog::Record)));
+
+    std::vector<AccessLog::Record> records;
+    ASSERT_TRUE(AccessLog::Load(file, records));
+    ASSERT_EQ(records.size(), 11u);
+    EXPECT_EQ(records[3].connID, 3u);
+    EXPECT_EQ(records[10].event, static_cast<uint8_t>(AccessLog::Event::Disconnect));
+    EXPECT_NE(AccessLog::ToString(records[0]).find("connect #0, 127.0.0.1:1000"), std::string::npos);
+}
+
+TEST(AccessLog, RejectsAppendWhenFull) {
+    std::string file = TestFolder("full") + "/access.bin";
+    AccessLog log;
+    ASSERT_TRUE(log.Open(file, sizeof(AccessLog::FileHeader) + 2 * sizeof(AccessLog::Record)));
+    EXPECT_TRUE(log.Append(AccessLog::MakeRecord(AccessLog::Event::Connect, 1, "")));
+    EXPECT_TRUE(log.Append(AccessLog::MakeRecord(AccessLog::Event::Connect, 2, "")));
+    EXPECT_TRUE(log.IsFull());
+    EXPECT_FALSE(log.Append(AccessLog::MakeRecord(AccessLog::Event::Connect, 3, "")));
+}
+
+TEST(FileSystem, RotateFileKeepsLimitedHistory) {
+    std::string folder = TestFolder("rotate");
+    std::string file = folder + "/info.log";
+    for (int i = 0; i < 4; i++) {
+        std::ofstream(file) << i;
+        ASSERT_TRUE(FileSystem::RotateFile(file, 2));
+    }
+    EXPECT_FALSE(FileSystem::IsFileExist(file));
+    EXPECT_FALSE(FileSystem::IsFileExist(file + ".3"));
+
+    std::string text;
+    std::ifstream(file + ".1") >> text;
+    EXPECT_EQ(text, "3");
+    std::ifstream(file + ".2") >> text;
+    EXPECT_EQ(text, "2");
+}
+
+TEST(LogWriter, RotatesBySizeAndWritesBinaryAccess) {
+    auto& config = WebSocketCpp::Config::Instance();
+    std::string folder = TestFolder("writer");
+    std::string savedFolder = config.GetLogFolder();
+    size_t savedSize = config.GetLogMaxFileSize();
+    size_t savedFiles = config.GetLogMaxFiles();
+    config.SetLogFolder(folder);
+    config.SetLogMaxFileSize(256);
+    config.SetLogMaxFiles(3);
+    config.SetLogBinaryAccess(true);
+
+    auto& writer = LogWriter::Instance();
+    writer.Reopen();
+    writer.Flush();
+    for (int i = 0; i < 20; i++) {
+        LOG("rotation line " + std::to_string(i), LogWriter::LogType::Info);
+        writer.Flush();
+    }
+    LOG_ACCESS(AccessLog::Event::Connect, 5, "192.168.0.1:5555");
+    LOG_ACCESS(AccessLog::Event::Disconnect, 5, "");
+    writer.Flush();
+
+    EXPECT_TRUE(FileSystem::IsFileExist(folder + "/info.log.1"));
+    EXPECT_FALSE(FileSystem::IsFileExist(folder + "/info.log.4"));
+    EXPECT_LE(FileSystem::GetFileSize(folder + "/info.log"), 256);
+
+    // the file is live, the header already holds the count
+    std::vector<AccessLog::Record> records;
+    ASSERT_TRUE(AccessLog::Load(folder + "/access.bin", records));
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].port, 5555);
+
+    config.SetLogFolder(savedFolder);
+    config.SetLogMaxFileSize(savedSize);
+    config.SetLogMaxFiles(savedFiles);
+    config.SetLogBinaryAccess(false);
+    writer.Reopen();
+    writer.Flush();
+}
@@ -113,6 +113,23 @@ TEST(MemoryPool, FullBufferAfterAllFrees) {
     pool.free(full);
 }
 
+TEST(MemoryPool, ShrinkReleasesTail) {
+    MemoryPool pool(200);
+    uint8_t* a = pool.allocate(150);   // [0..150)
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(pool.allocate(100), nullptr);
+    pool.shrink(a, 40);                 // [0..40), tail [40..200)
+    EXPECT_EQ(pool.used_size(), 40u);
+    uint8_t* b = pool.allocate(100);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(b, a + 40);
+    pool.shrink(a, 100);                // growing is a no-op
+    EXPECT_EQ(pool.used_size(), 140u);
+    pool.free(a);
+    pool.free(b);
+    EXPECT_TRUE(pool.empty());
+}
+
 TEST(MemoryPool, AllocatedMemoryIsWritable) {
     MemoryPool pool(256);
     uint8_t* p = pool.allocate(256);
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Config.h"
+#include "DebugPrint.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "WebSocketClient.h"
+#include "WebSocketServer.h"
+
+using namespace WebSocketCpp;
+
+static int FindFreePort()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+    int port = ntohs(addr.sin_port);
+    ::close(fd);
+    return port;
+}
+
+TEST(Metrics, BucketsAreContiguous)
+{
+    EXPECT_EQ(Metrics::BucketIndex(0), 0u);
+    EXPECT_EQ(Metrics::BucketIndex(7), 7u);
+    EXPECT_EQ(Metrics::BucketIndex(8), 8u);
+    EXPECT_EQ(Metrics::BucketIndex(UINT64_MAX), Metrics::BUCKET_COUNT - 1);
+
+    for (size_t i = 1; i < Metrics::BUCKET_COUNT; i++)
+    {
+        ASSERT_EQ(Metrics::BucketLowerBound(i), Metrics::BucketUpperBound(i - 1) + 1) << "bucket " << i;
+        ASSERT_EQ(Metrics::BucketIndex(Metrics::BucketLowerBound(i)), i);
+        ASSERT_EQ(Metrics::BucketIndex(Metrics::BucketUpperBound(i)), i);
+    }
+}
+
+TEST(Metrics, BucketPrecision)
+{
+    for (uint64_t value : {9ull, 100ull, 12345ull, 1000000ull, 987654321ull})
+    {
+        size_t index = Metrics::BucketIndex(value);
+        EXPECT_LE(Metrics::BucketLowerBound(index), value);
+        EXPECT_GE(Metrics::BucketUpperBound(index), value);
+        EXPECT_LE(Metrics::BucketUpperBound(index) - Metrics::BucketLowerBound(index), value / 8);
+    }
+}
+
+TEST(Metrics, PercentileOfUniformValues)
+{
+    Metrics::HistogramData data;
+    data.buckets.assign(Metrics::BUCKET_COUNT, 0);
+    for (uint64_t v = 1; v <= 1000; v++)
+    {
+        data.buckets[Metrics::BucketIndex(v)]++;
+        data.count++;
+        data.sum += v;
+    }
+
+    EXPECT_NEAR(static_cast<double>(data.Percentile(50)), 500.0, 500.0 / 8);
+    EXPECT_NEAR(static_cast<double>(data.Percentile(99)), 990.0, 990.0 / 8);
+    EXPECT_DOUBLE_EQ(data.Mean(), 500.5);
+
+    Metrics::HistogramData empty;
+    EXPECT_EQ(empty.Percentile(99), 0u);
+}
+
+TEST(Metrics, ThreadsAreSummedUp)
+{
+    auto&    metrics = Metrics::Instance();
+    auto     before  = metrics.GetSnapshot();
+    const int threads   = 8;
+    const int perThread = 10000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&metrics, perThread]() {
+            for (int i = 0; i < perThread; i++)
+            {
+                metrics.Add(Metrics::Counter::BytesIn, 2);
+                metrics.Add(Metrics::Gauge::RequestQueueDepth, 1);
+                metrics.Add(Metrics::Gauge::RequestQueueDepth, -1);
+                metrics.Record(Metrics::Histogram::MessageSizeBytes, 100);
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    auto after = metrics.GetSnapshot();
+    EXPECT_EQ(after.Get(Metrics::Counter::BytesIn) - before.Get(Metrics::Counter::BytesIn), 2u * threads * perThread);
+    EXPECT_EQ(after.Get(Metrics::Gauge::RequestQueueDepth), before.Get(Metrics::Gauge::RequestQueueDepth));
+
+    auto& histogram = after.Get(Metrics::Histogram::MessageSizeBytes);
+    EXPECT_EQ(histogram.count - before.Get(Metrics::Histogram::MessageSizeBytes).count, static_cast<uint64_t>(threads * perThread));
+}
+
+TEST(Metrics, FrameCounterByOpcode)
+{
+    EXPECT_EQ(Metrics::FrameCounter(MessageType::Text, true), Metrics::Counter::FramesInText);
+    EXPECT_EQ(Metrics::FrameCounter(MessageType::Pong, true), Metrics::Counter::FramesInPong);
+    EXPECT_EQ(Metrics::FrameCounter(MessageType::Binary, false), Metrics::Counter::FramesOutBinary);
+    EXPECT_EQ(Metrics::FrameCounter(MessageType::Undefined, false), Metrics::Counter::FramesOutOther);
+}
+
+TEST(Metrics, PrometheusFormat)
+{
+    Metrics::Instance().Add(Metrics::Counter::FramesInPing);
+    std::string text = Metrics::Instance().ToPrometheus();
+
+    EXPECT_NE(text.find("# TYPE websocketcpp_frames_in_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("websocketcpp_frames_in_total{opcode=\"ping\"} "), std::string::npos);
+    EXPECT_NE(text.find("# TYPE websocketcpp_handler_latency_seconds summary\n"), std::string::npos);
+    EXPECT_NE(text.find("websocketcpp_handler_latency_seconds{quantile=\"0.99\"} "), std::string::npos);
+    EXPECT_NE(text.find("websocketcpp_message_size_bytes_count "), std::string::npos);
+
+    // HELP and TYPE only once per metric family
+    size_t first = text.find("# TYPE websocketcpp_frames_in_total");
+    EXPECT_EQ(text.find("# TYPE websocketcpp_frames_in_total", first + 1), std::string::npos);
+}
+
+TEST(Metrics, ServedOnConfiguredRoute)
+{
+    WebSocketCpp::DebugPrint::AllowPrint = false;
+
+    int   port   = FindFreePort();
+    auto& config = Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(port);
+    config.SetMetricsRoute("/metrics");
+
+    WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+
+    struct timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // two requests on the same connection, the second one must be answered as well
+    std::string answer;
+    for (int i = 0; i < 2; i++)
+    {
+        std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        ASSERT_EQ(::send(fd, request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+
+        answer.clear();
+        char   buffer[4096];
+        size_t expected = std::string::npos;
+        while (answer.size() < expected)
+        {
+            ssize_t size = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (size <= 0)
+            {
+                break;
+            }
+            answer.append(buffer, static_cast<size_t>(size));
+
+            size_t headerEnd = answer.find("\r\n\r\n");
+            size_t length    = answer.find("Content-Length: ");
+            if (expected == std::string::npos && headerEnd != std::string::npos && length < headerEnd)
+            {
+                expected = headerEnd + 4 + std::stoul(answer.substr(length + 16));
+            }
+        }
+        EXPECT_EQ(answer.size(), expected);
+        EXPECT_EQ(answer.compare(0, 15, "HTTP/1.1 200 OK"), 0) << answer.substr(0, 64);
+        EXPECT_NE(answer.find("websocketcpp_accepts_total "), std::string::npos);
+    }
+    ::close(fd);
+
+    auto snapshot = Metrics::Instance().GetSnapshot();
+    EXPECT_GE(snapshot.Get(Metrics::Counter::MetricsRequests), 2u);
+    EXPECT_GE(snapshot.Get(Metrics::Counter::Accepts), 1u);
+
+    config.SetMetricsRoute("");
+    server.Close();
+}
+
+TEST(Trace, SampleRate)
+{
+    uint32_t saved = Trace::GetSampleRate();
+    Trace::SetSampleRate(4);
+    EXPECT_EQ(Trace::GetSampleRate(), 4u);
+
+#ifdef WITH_TRACING
+    // the countdown is per thread, a new thread starts with a sampled read
+    int sampled = 0;
+    std::thread([&sampled]() {
+        for (int i = 0; i < 100; i++)
+        {
+            sampled += Trace::Sample() ? 1 : 0;
+        }
+    }).join();
+    EXPECT_EQ(sampled, 25);
+
+    Trace::SetSampleRate(0);
+    std::thread([&sampled]() {
+        for (int i = 0; i < 100; i++)
+        {
+            EXPECT_FALSE(Trace::Sample());
+        }
+    }).join();
+#endif
+
+    Trace::SetSampleRate(saved);
+}
+
+#ifdef WITH_TRACING
+TEST(Trace, FinishRecordsPassedStages)
+{
+    auto before = Metrics::Instance().GetSnapshot();
+
+    Trace::Context context;
+    context.active = true;
+    for (size_t i = 0; i < Trace::POINT_COUNT; i++)
+    {
+        context.stamps[i] = 1000 + i * 100;
+    }
+    context.stamps[static_cast<size_t>(Trace::Point::Woken)] = 0; // the signal stage wasn't passed
+    context.Finish();
+    EXPECT_FALSE(context.active);
+
+    auto after = Metrics::Instance().GetSnapshot();
+    auto delta = [&](Metrics::Histogram h) {
+        return after.Get(h).count - before.Get(h).count;
+    };
+    EXPECT_EQ(delta(Metrics::Histogram::TraceReadNs), 1u);
+    EXPECT_EQ(delta(Metrics::Histogram::TraceSignalNs), 0u);
+    EXPECT_EQ(delta(Metrics::Histogram::TraceParseNs), 0u);
+    EXPECT_EQ(delta(Metrics::Histogram::TraceHandlerNs), 1u);
+    EXPECT_EQ(delta(Metrics::Histogram::TraceTotalNs), 1u);
+    EXPECT_EQ(after.Get(Metrics::Histogram::TraceTotalNs).sum - before.Get(Metrics::Histogram::TraceTotalNs).sum, 700u);
+}
+
+TEST(Trace, EchoMessagesAreTraced)
+{
+    WebSocketCpp::DebugPrint::AllowPrint = false;
+
+    int   port   = FindFreePort();
+    auto& config = Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(port);
+    config.SetTraceSampleRate(1);
+
+    auto before = Metrics::Instance().GetSnapshot();
+
+    WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const Request&, ResponseWebSocket& response, const ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    std::atomic<int> received{0};
+    WebSocketClient  client;
+    client.SetOnMessage([&received](ResponseWebSocket&) -> bool {
+        received++;
+        return true;
+    });
+    ASSERT_TRUE(client.Init());
+    ASSERT_TRUE(client.Open("ws://127.0.0.1:" + std::to_string(port) + "/ws")) << client.GetLastError();
+
+    const int count = 10;
+    for (int i = 0; i < count; i++)
+    {
+        client.SendText("trace " + std::to_string(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    for (int i = 0; i < 100 && received < count; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    client.Close();
+    server.Close();
+    EXPECT_EQ(received.load(), count);
+
+    auto after = Metrics::Instance().GetSnapshot();
+    auto total = after.Get(Metrics::Histogram::TraceTotalNs).count - before.Get(Metrics::Histogram::TraceTotalNs).count;
+    auto queue = after.Get(Metrics::Histogram::TraceConnectionQueueNs).count - before.Get(Metrics::Histogram::TraceConnectionQueueNs).count;
+    EXPECT_GE(total, 1u);
+    EXPECT_GE(queue, total);
+
+    config.SetTraceSampleRate(64);
+}
+#else
+TEST(Trace, CompiledOut)
+{
+    EXPECT_TRUE(std::is_empty<Trace::Context>::value);
+}
+#endif
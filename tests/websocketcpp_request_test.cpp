@@ -332,6 +332,56 @@ TEST_F(RequestTest, SetHeader_ModifiesHeader)
     EXPECT_EQ(request.GetHeader().GetHeader(Header::HeaderType::UserAgent), userAgent);
 }
 
+TEST_F(RequestTest, SetHeader_ReplacesParsedValue)
+{
+    std::string path = rand.Path();
+    std::string host = rand.Host();
+    ByteArray   data = BuildBasicRequest("GET", path, host);
+    EXPECT_TRUE(request.Parse(data));
+    size_t count = request.GetHeader().GetCount();
+
+    request.GetHeader().SetHeader("host", "a");
+    EXPECT_EQ(request.GetHeader().GetHeader(Header::HeaderType::Host), "a");
+    request.GetHeader().SetHeader(Header::HeaderType::Host, host + host);
+    EXPECT_EQ(request.GetHeader().GetHeader("HOST"), host + host);
+    EXPECT_EQ(request.GetHeader().GetCount(), count);
+}
+
+TEST_F(RequestTest, GetHeader_NamesAreCaseInsensitive)
+{
+    std::string req = "GET / HTTP/1.1\r\n"
+                      "hOsT: example.com\r\n"
+                      "sec-websocket-key:\tabc  \r\n"
+                      "X-Custom: 1\r\n"
+                      "x-custom: 2\r\n"
+                      "\r\n";
+    ByteArray   data(req.begin(), req.end());
+    EXPECT_TRUE(request.Parse(data));
+
+    auto& header = request.GetHeader();
+    EXPECT_EQ(header.GetHeader(Header::HeaderType::Host), "example.com");
+    EXPECT_EQ(header.GetHeader("Sec-WebSocket-Key"), "abc");
+    EXPECT_TRUE(header.HasHeader(Header::HeaderType::SecWebSocketKey));
+    EXPECT_TRUE(header.CompareHeader(Header::HeaderType::Host, "EXAMPLE.COM"));
+    EXPECT_FALSE(header.HasHeader(Header::HeaderType::Origin));
+    EXPECT_EQ(header.GetHeader("X-CUSTOM"), "2");
+    EXPECT_EQ(header.GetAllHeaders("X-Custom").size(), 2u);
+}
+
+TEST(Header, InternKnownNames)
+{
+    EXPECT_EQ(Header::Intern("content-length", 14), Header::HeaderType::ContentLength);
+    EXPECT_EQ(Header::Intern("SEC-WEBSOCKET-ACCEPT", 20), Header::HeaderType::SecWebSocketAccept);
+    EXPECT_EQ(Header::Intern("Content-Lengt", 13), Header::HeaderType::Undefined);
+    EXPECT_EQ(Header::Intern("", 0), Header::HeaderType::Undefined);
+
+    for (size_t i = 1; i < Header::HEADER_TYPE_COUNT; i++)
+    {
+        auto type = static_cast<Header::HeaderType>(i);
+        EXPECT_EQ(Header::String2HeaderType(Header::HeaderType2String(type)), type);
+    }
+}
+
 TEST_F(RequestTest, GetHeader_NonExistent_ReturnsEmpty)
 {
     std::string path = rand.Path();
@@ -470,6 +520,43 @@ TEST_F(RequestTest, Parse_MultipleCalls_Idempotent)
     EXPECT_EQ(request.GetProtocol(), Protocol::WS);
 }
 
+TEST_F(RequestTest, Parse_Trickled_ResumesWhereItStopped)
+{
+    std::string path  = rand.Path();
+    std::string host  = rand.Host();
+    std::string wsKey = rand.Base64(22);
+    ByteArray   full  = BuildWebSocketUpgradeRequest(path, host, wsKey);
+
+    ByteArray data;
+    for (size_t i = 0; i < full.size() - 1; i++)
+    {
+        data.push_back(full[i]);
+        EXPECT_FALSE(request.Parse(data));
+        EXPECT_NE(request.GetParseState(), Request::ParseState::Error);
+    }
+
+    data.push_back(full.back());
+    EXPECT_TRUE(request.Parse(data));
+    EXPECT_EQ(request.GetParseState(), Request::ParseState::Complete);
+    EXPECT_EQ(request.GetRequestSize(), full.size());
+    EXPECT_EQ(request.GetUrl().GetPath(), path);
+    EXPECT_EQ(request.GetHeader().GetHeader(Header::HeaderType::Host), host);
+    EXPECT_EQ(request.GetHeader().GetHeader("Sec-WebSocket-Key"), wsKey);
+    EXPECT_EQ(request.GetProtocol(), Protocol::WS);
+}
+
+TEST_F(RequestTest, Parse_MalformedRequestLine_StaysFailed)
+{
+    std::string req = "BROKEN\r\nHost: localhost\r\n\r\n";
+    ByteArray   data(req.begin(), req.end());
+    EXPECT_FALSE(request.Parse(data));
+    EXPECT_EQ(request.GetParseState(), Request::ParseState::Error);
+    EXPECT_FALSE(request.Parse(data));
+
+    request.Clear();
+    EXPECT_EQ(request.GetParseState(), Request::ParseState::RequestLine);
+}
+
 TEST_F(RequestTest, Parse_WebSocketWithoutSecKey_StillParsable)
 {
     std::string path = rand.Path();
@@ -4,6 +4,7 @@
 
 #include "Request.h"
 #include "Route.h"
+#include "RouteTable.h"
 
 using namespace WebSocketCpp;
 
@@ -174,6 +175,23 @@ TEST_F(RouteTest, IsMatch_MultipleVariables)
     EXPECT_EQ(req.GetArg("postId"), postId);
 }
 
+TEST_F(RouteTest, IsMatch_TooManyVariables_NoMatch)
+{
+    std::string path = "";
+    std::string uri  = "";
+    for (size_t i = 0; i <= RouteArgs::MAX_COUNT; i++)
+    {
+        path += "/{v" + std::to_string(i) + "}";
+        uri += "/" + rand.AlphaNumeric(3, 6);
+    }
+    Route   route(path, Method::GET);
+    Request req;
+    req.SetMethod(Method::GET);
+    req.GetUrl().Parse(uri, false);
+
+    EXPECT_FALSE(route.IsMatch(req));
+}
+
 TEST_F(RouteTest, IsMatch_VariableAtEnd)
 {
     std::string filename = rand.AlphaNumeric(8, 15);
@@ -619,3 +637,131 @@ TEST_F(RouteTest, WebSocket_OptionalToken)
     EXPECT_TRUE(route.IsMatch(req2));
     EXPECT_EQ(req2.GetArg("token"), token);
 }
+
+TEST_F(RouteTest, LiteralPrefix)
+{
+    EXPECT_TRUE(Route("/ws/chat", Method::WEBSOCKET).IsLiteral());
+    EXPECT_EQ(Route("/ws/chat", Method::WEBSOCKET).GetLiteralPrefix(), "/ws/chat");
+    EXPECT_FALSE(Route("/ws/{room}", Method::WEBSOCKET).IsLiteral());
+    EXPECT_EQ(Route("/ws/{room}", Method::WEBSOCKET).GetLiteralPrefix(), "/ws/");
+    EXPECT_EQ(Route("*/chat", Method::WEBSOCKET).GetLiteralPrefix(), "");
+    EXPECT_EQ(Route("[/ws]/chat", Method::WEBSOCKET).GetLiteralPrefix(), "");
+}
+
+TEST_F(RouteTest, RouteTable_MatchesInRegistrationOrder)
+{
+    RouteTable table;
+    table.Add(std::make_shared<RouteWebSocket>("/ws/chat/{room}", nullptr));
+    table.Add(std::make_shared<RouteWebSocket>("/ws/chat", nullptr));
+    table.Add(std::make_shared<RouteWebSocket>("*", nullptr));
+    table.Add(std::make_shared<RouteWebSocket>("/ws/{name:alpha}/{room}", nullptr));
+    table.Add(std::make_shared<RouteWebSocket>("/api", nullptr));
+
+    std::string room = rand.AlphaNumeric(5, 10);
+    Request     req;
+    req.SetMethod(Method::WEBSOCKET);
+    req.GetUrl().Parse("/ws/chat/" + room, false);
+
+    RouteTable::Matches matches;
+    EXPECT_TRUE(table.Match(req, matches));
+    ASSERT_EQ(matches.bindings.size(), 3u);
+    EXPECT_EQ(matches.bindings[0].route, 0u);
+    EXPECT_EQ(matches.bindings[1].route, 2u);
+    EXPECT_EQ(matches.bindings[2].route, 3u);
+    EXPECT_TRUE(req.GetArg("room").empty());
+
+    req.SetRouteArgs(&matches.path, &matches.bindings[0].args);
+    EXPECT_EQ(req.GetArg("room"), room);
+    EXPECT_TRUE(req.GetArg("name").empty());
+    req.SetRouteArgs(&matches.path, &matches.bindings[2].args);
+    EXPECT_EQ(req.GetArg("name"), "chat");
+    EXPECT_EQ(req.GetArg("room"), room);
+
+    Request exact;
+    exact.SetMethod(Method::WEBSOCKET);
+    exact.GetUrl().Parse("/ws/chat", false);
+    EXPECT_TRUE(table.Match(exact, matches));
+    ASSERT_EQ(matches.bindings.size(), 2u);
+    EXPECT_EQ(matches.bindings[0].route, 1u);
+    EXPECT_EQ(matches.bindings[1].route, 2u);
+}
+
+TEST_F(RouteTest, Match_CapturesWithoutRequest)
+{
+    Route       route("/ws/user/{id:numeric}[/{room}]", Method::WEBSOCKET);
+    std::string path = "/ws/user/42/lobby";
+    RouteArgs   args;
+
+    ASSERT_TRUE(route.Match(path, Method::WEBSOCKET, args));
+    ASSERT_EQ(args.count, 2u);
+    EXPECT_EQ(*args.args[0].name, "id");
+    EXPECT_EQ(path.substr(args.args[0].start, args.args[0].length), "42");
+    EXPECT_EQ(*args.args[1].name, "room");
+    EXPECT_EQ(path.substr(args.args[1].start, args.args[1].length), "lobby");
+
+    EXPECT_FALSE(route.Match(path, Method::GET, args));
+    EXPECT_FALSE(route.Match("/ws/user/x", Method::WEBSOCKET, args));
+}
+
+TEST_F(RouteTest, SetRouteArgs_FallsBackToSetArg)
+{
+    Route       route("/ws/{id}", Method::WEBSOCKET);
+    std::string path = "/ws/abc";
+    RouteArgs   args;
+    ASSERT_TRUE(route.Match(path, Method::WEBSOCKET, args));
+
+    Request req;
+    req.SetArg("user", "bob");
+    req.SetRouteArgs(&path, &args);
+    EXPECT_EQ(req.GetArg("id"), "abc");
+    EXPECT_EQ(req.GetArg("user"), "bob");
+
+    req.SetRouteArgs(nullptr, nullptr);
+    EXPECT_TRUE(req.GetArg("id").empty());
+}
+
+TEST_F(RouteTest, RouteTable_NoMatch)
+{
+    RouteTable table;
+    table.Add(std::make_shared<RouteWebSocket>("/ws/chat", nullptr));
+    table.Add(std::make_shared<RouteWebSocket>("/ws/{id:numeric}", nullptr));
+
+    Request req;
+    req.SetMethod(Method::WEBSOCKET);
+    req.GetUrl().Parse("/ws/chat2", false);
+
+    RouteTable::Matches matches;
+    EXPECT_FALSE(table.Match(req, matches));
+    EXPECT_TRUE(matches.bindings.empty());
+
+    req.SetMethod(Method::GET);
+    req.GetUrl().Parse("/ws/chat", false);
+    EXPECT_FALSE(table.Match(req, matches));
+}
+
+TEST_F(RouteTest, RouteTable_CopyIsIndependent)
+{
+    RouteTable table;
+    table.Add(std::make_shared<RouteWebSocket>("/ws", nullptr));
+
+    RouteTable copy(table);
+    copy.Add(std::make_shared<RouteWebSocket>("/ws/{id}", nullptr));
+    EXPECT_EQ(table.GetCount(), 1u);
+    EXPECT_EQ(copy.GetCount(), 2u);
+    EXPECT_EQ(table.Find("/ws/{id}"), nullptr);
+    EXPECT_EQ(copy.Find("/ws"), table.Find("/ws"));
+
+    auto replacement = std::make_shared<RouteWebSocket>("/ws", nullptr);
+    EXPECT_TRUE(copy.Replace(replacement));
+    EXPECT_EQ(copy.Find("/ws"), replacement);
+    EXPECT_NE(table.Find("/ws"), replacement);
+    EXPECT_FALSE(copy.Replace(std::make_shared<RouteWebSocket>("/none", nullptr)));
+
+    Request req;
+    req.SetMethod(Method::WEBSOCKET);
+    req.GetUrl().Parse("/ws/1", false);
+
+    RouteTable::Matches matches;
+    EXPECT_FALSE(table.Match(req, matches));
+    EXPECT_TRUE(copy.Match(req, matches));
+}
@@ -2,7 +2,7 @@
  * Copyright (c) 2026 ruslan@muhlinin.com
  * MIT License
  *
- * Deep integration tests for ServerSocket and ClientSocket.
+ * Deep integration tests for ServerSocket, ClientSocket and ClientReactor.
  */
 
 #include <gtest/gtest.h>
@@ -21,7 +21,9 @@
 #include <thread>
 #include <vector>
 
+#include "ClientReactor.h"
 #include "ClientSocket.h"
+#include "Resolver.h"
 #include "ServerSocket.h"
 
 using namespace WebSocketCpp;
@@ -158,6 +160,38 @@ TEST(ClientSocketUnit, DoubleConnectFails)
     server.Close(true);
 }
 
+TEST(ClientSocketUnit, StalledPeer_WriteTimesOut)
+{
+    // a listener that accepts but never reads
+    int port = FindFreePort();
+    int lfd  = ::socket(AF_INET, SOCK_STREAM, 0);
+    int opt  = 1;
+    ::setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(lfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(::listen(lfd, 1), 0);
+
+    ClientSocket client;
+    ASSERT_TRUE(client.Init());
+    ASSERT_TRUE(client.Connect("127.0.0.1", port));
+    ASSERT_TRUE(client.Run());
+    int fd = ::accept(lfd, nullptr, nullptr);
+    ASSERT_GE(fd, 0);
+
+    std::vector<uint8_t> payload(64 * 1024 * 1024, 'x');
+    auto                 start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(client.Write(payload.data(), payload.size()));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_FALSE(client.GetLastError().empty());
+
+    client.Close(true);
+    ::close(fd);
+    ::close(lfd);
+}
+
 class ServerClientTest : public ::testing::Test
 {
 protected:
@@ -196,8 +230,8 @@ TEST_F(ServerClientTest, ClientConnect_OnConnectFires)
 
     m_server->OnConnected([&](int32_t)
     {
-        connect_count++;
         std::lock_guard<std::mutex> lock(mtx);
+        connect_count++;
         cv.notify_all();
     });
 
@@ -218,8 +252,8 @@ TEST_F(ServerClientTest, ClientDisconnect_OnDisconnectFires)
 
     m_server->OnDisconnected([&](int32_t)
     {
-        disconnect_count++;
         std::lock_guard<std::mutex> lock(mtx);
+        disconnect_count++;
         cv.notify_all();
     });
 
@@ -412,8 +446,8 @@ TEST_F(ServerClientTest, MultipleClients_AllConnect)
 
     m_server->OnConnected([&](int32_t)
     {
-        connect_count++;
         std::lock_guard<std::mutex> lock(mtx);
+        connect_count++;
         cv.notify_all();
     });
 
@@ -447,8 +481,8 @@ TEST_F(ServerClientTest, MultipleClients_ConcurrentSend)
 
     m_server->OnDataReady([&](int32_t, ByteArray&&)
     {
-        recv_count++;
         std::lock_guard<std::mutex> lock(mtx);
+        recv_count++;
         cv.notify_all();
     });
 
@@ -540,3 +574,358 @@ TEST_F(ServerClientTest, WriteAfterClose_ReturnsFalse)
     uint8_t buf[] = {'x'};
     EXPECT_FALSE(client->Write(buf, sizeof(buf)));
 }
+
+TEST_F(ServerClientTest, StalledWriter_DoesNotBlockClose)
+{
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::atomic<int32_t>    client_idx{-1};
+    std::atomic<bool>       disconnected{false};
+
+    m_server->OnConnected([&](int32_t idx)
+    {
+        client_idx = idx;
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    });
+    m_server->OnDisconnected([&](int32_t)
+    {
+        disconnected = true;
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    });
+
+    // a peer that never reads, the server's socket buffer fills up quickly
+    int fd  = ::socket(AF_INET, SOCK_STREAM, 0);
+    int buf = 4096;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(m_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_TRUE(WaitFor(mtx, cv, [&]{ return client_idx.load() != -1; }));
+
+    std::vector<uint8_t> payload(64 * 1024 * 1024, 'x');
+    std::atomic<bool>    written{true};
+    std::atomic<bool>    done{false};
+    std::thread writer([&]()
+    {
+        written = m_server->Write(client_idx.load(), payload.data(), payload.size());
+        done    = true;
+    });
+    Yield();
+    EXPECT_FALSE(done.load());
+
+    // the epoll thread closes the connection while the writer is waiting for the socket
+    ::shutdown(fd, SHUT_WR);
+    EXPECT_TRUE(WaitFor(mtx, cv, [&]{ return disconnected.load(); }, 500));
+
+    writer.join();
+    EXPECT_FALSE(written.load());
+    ::close(fd);
+}
+
+TEST_F(ServerClientTest, Reactor_ManyClientsShareThreads)
+{
+    const int count = 20;
+
+    m_server->OnDataReady([&](int32_t idx, ByteArray&& data)
+    {
+        m_server->Write(idx, data.data(), data.size());
+    });
+
+    auto reactor = std::make_shared<ClientReactor>(2);
+    ASSERT_TRUE(reactor->Init());
+    ASSERT_TRUE(reactor->Run());
+
+    std::mutex                                 mtx;
+    std::condition_variable                    cv;
+    std::atomic<int>                           echoed{0};
+    std::vector<std::unique_ptr<ClientSocket>> clients;
+    for (int i = 0; i < count; i++)
+    {
+        std::unique_ptr<ClientSocket> client(new ClientSocket());
+        client->SetReactor(reactor);
+        client->SetOnData([&](ByteArray&&)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            echoed++;
+            cv.notify_all();
+        });
+        ASSERT_TRUE(client->Init());
+        ASSERT_TRUE(client->Connect("127.0.0.1", m_port));
+        ASSERT_TRUE(client->Run());
+        clients.push_back(std::move(client));
+    }
+    EXPECT_EQ(reactor->GetThreadCount(), 2u);
+    EXPECT_EQ(reactor->GetHandlerCount(), static_cast<size_t>(count));
+
+    Yield();
+    uint8_t byte = 'x';
+    for (auto& c : clients) { ASSERT_TRUE(c->Write(&byte, 1)); }
+
+    EXPECT_TRUE(WaitFor(mtx, cv, [&]{ return echoed.load() >= count; }, 5000));
+    EXPECT_EQ(echoed.load(), count);
+
+    for (auto& c : clients) { c->Close(true); }
+    EXPECT_EQ(reactor->GetHandlerCount(), 0u);
+    reactor->Close(true);
+}
+
+TEST_F(ServerClientTest, Reactor_CloseWaitsForRunningCallback)
+{
+    std::atomic<int32_t> client_idx{-1};
+    m_server->OnConnected([&](int32_t idx) { client_idx = idx; });
+
+    auto client = MakeClient();
+    ASSERT_NE(client, nullptr);
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> finished{false};
+    client->SetOnData([&](ByteArray&&)
+    {
+        entered = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        finished = true;
+    });
+
+    for (int i = 0; i < 40 && client_idx.load() == -1; i++) { Yield(); }
+    uint8_t byte = 'x';
+    ASSERT_TRUE(m_server->Write(client_idx.load(), &byte, 1));
+    for (int i = 0; i < 40 && !entered; i++) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+    ASSERT_TRUE(entered.load());
+
+    client->Close(true);
+    EXPECT_TRUE(finished.load());
+}
+
+TEST_F(ServerClientTest, Reactor_CloseFromOwnCallback)
+{
+    std::atomic<int32_t> client_idx{-1};
+    m_server->OnConnected([&](int32_t idx) { client_idx = idx; });
+
+    auto client = MakeClient();
+    ASSERT_NE(client, nullptr);
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::atomic<bool>       closed{false};
+    ClientSocket*           ptr = client.get();
+    client->SetOnData([&, ptr](ByteArray&&)
+    {
+        ptr->Close(false);
+        closed = true;
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    });
+
+    for (int i = 0; i < 40 && client_idx.load() == -1; i++) { Yield(); }
+    uint8_t byte = 'x';
+    ASSERT_TRUE(m_server->Write(client_idx.load(), &byte, 1));
+
+    EXPECT_TRUE(WaitFor(mtx, cv, [&]{ return closed.load(); }));
+    EXPECT_TRUE(client->WaitFor());
+    EXPECT_FALSE(client->IsRunning());
+}
+
+TEST_F(ServerClientTest, Reactor_WaitForReturnsOnServerClose)
+{
+    auto client = MakeClient();
+    ASSERT_NE(client, nullptr);
+    Yield();
+
+    std::thread closer([this]()
+    {
+        Yield();
+        m_server->Close(true);
+    });
+
+    EXPECT_TRUE(client->WaitFor());
+    EXPECT_FALSE(client->IsConnected());
+    closer.join();
+    client->Close(true);
+}
+
+class SilentResolver : public IResolver
+{
+public:
+    void Resolve(const std::string&, int32_t, Callback) override {}
+};
+
+struct AsyncResult
+{
+    std::mutex              mtx;
+    std::condition_variable cv;
+    int                     calls{0};
+    bool                    ok{false};
+
+    std::function<void(bool)> Callback()
+    {
+        return [this](bool connected)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            calls++;
+            ok = connected;
+            cv.notify_all();
+        };
+    }
+
+    bool Wait(int timeout_ms = 2000)
+    {
+        return WaitFor(mtx, cv, [this]{ return calls > 0; }, timeout_ms);
+    }
+};
+
+TEST_F(ServerClientTest, Async_ConnectViaStubResolver)
+{
+    m_server->OnDataReady([&](int32_t idx, ByteArray&& data)
+    {
+        m_server->Write(idx, data.data(), data.size());
+    });
+
+    auto resolver = std::make_shared<StaticResolver>();
+    resolver->Add("echo.test", "127.0.0.1");
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::atomic<bool>       echoed{false};
+    ClientSocket            client;
+    client.SetResolver(resolver);
+    client.SetOnData([&](ByteArray&&)
+    {
+        echoed = true;
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    });
+    ASSERT_TRUE(client.Init());
+
+    AsyncResult result;
+    ASSERT_TRUE(client.ConnectAsync("echo.test", m_port, result.Callback()));
+    ASSERT_TRUE(result.Wait());
+    ASSERT_TRUE(result.ok);
+    EXPECT_TRUE(client.IsConnected());
+
+    uint8_t byte = 'x';
+    ASSERT_TRUE(client.Write(&byte, 1));
+    EXPECT_TRUE(WaitFor(mtx, cv, [&]{ return echoed.load(); }));
+
+    client.Close(true);
+}
+
+TEST_F(ServerClientTest, Async_UnknownHostFails)
+{
+    ClientSocket client;
+    client.SetResolver(std::make_shared<StaticResolver>());
+    ASSERT_TRUE(client.Init());
+
+    AsyncResult result;
+    ASSERT_TRUE(client.ConnectAsync("nowhere.test", m_port, result.Callback()));
+    ASSERT_TRUE(result.Wait());
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(client.IsConnected());
+    EXPECT_FALSE(client.IsRunning());
+    EXPECT_FALSE(client.GetLastError().empty());
+}
+
+TEST_F(ServerClientTest, Async_RefusedPortFails)
+{
+    int port = FindFreePort();
+
+    ClientSocket client;
+    ASSERT_TRUE(client.Init());
+
+    AsyncResult result;
+    ASSERT_TRUE(client.ConnectAsync("127.0.0.1", port, result.Callback()));
+    ASSERT_TRUE(result.Wait());
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(client.IsConnected());
+}
+
+TEST_F(ServerClientTest, Async_ConnectTimeout)
+{
+    ClientSocket client;
+    client.SetResolver(std::make_shared<SilentResolver>());
+    ASSERT_TRUE(client.Init());
+
+    AsyncResult result;
+    ASSERT_TRUE(client.ConnectAsync("slow.test", m_port, result.Callback(), 100));
+    ASSERT_TRUE(result.Wait());
+    EXPECT_FALSE(result.ok);
+    EXPECT_EQ(client.GetLastError(), "connect timeout");
+    EXPECT_FALSE(client.IsRunning());
+}
+
+TEST_F(ServerClientTest, Async_CloseWhileResolving)
+{
+    std::unique_ptr<ClientSocket> client(new ClientSocket());
+    client->SetResolver(std::make_shared<SilentResolver>());
+    ASSERT_TRUE(client->Init());
+
+    AsyncResult result;
+    ASSERT_TRUE(client->ConnectAsync("slow.test", m_port, result.Callback(), 100));
+    client->Close(true);
+    client.reset();
+
+    EXPECT_FALSE(result.Wait(300));
+}
+
+TEST_F(ServerClientTest, Async_ManyConcurrentConnects)
+{
+    const int count = 50;
+
+    auto reactor = std::make_shared<ClientReactor>(2);
+    ASSERT_TRUE(reactor->Init());
+    ASSERT_TRUE(reactor->Run());
+
+    std::mutex                                 mtx;
+    std::condition_variable                    cv;
+    std::atomic<int>                           connected{0};
+    std::atomic<int>                           failed{0};
+    std::vector<std::unique_ptr<ClientSocket>> clients;
+    for (int i = 0; i < count; i++)
+    {
+        std::unique_ptr<ClientSocket> client(new ClientSocket());
+        client->SetReactor(reactor);
+        ASSERT_TRUE(client->Init());
+        ASSERT_TRUE(client->ConnectAsync("localhost", m_port, [&](bool ok)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            (ok ? connected : failed)++;
+            cv.notify_all();
+        }));
+        clients.push_back(std::move(client));
+    }
+
+    EXPECT_TRUE(WaitFor(mtx, cv, [&]{ return connected.load() + failed.load() == count; }, 5000));
+    EXPECT_EQ(connected.load(), count);
+    EXPECT_EQ(reactor->GetHandlerCount(), static_cast<size_t>(count));
+
+    for (auto& c : clients) { c->Close(true); }
+    EXPECT_EQ(reactor->GetHandlerCount(), 0u);
+    reactor->Close(true);
+}
+
+TEST_F(ServerClientTest, Async_SetTimeoutFires)
+{
+    auto client = MakeClient();
+    ASSERT_NE(client, nullptr);
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::atomic<int>        fired{0};
+    ASSERT_TRUE(client->SetTimeout(50, [&]()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        fired++;
+        cv.notify_all();
+    }));
+    EXPECT_TRUE(WaitFor(mtx, cv, [&]{ return fired.load() == 1; }));
+
+    ASSERT_TRUE(client->SetTimeout(50, [&]() { fired++; }));
+    ASSERT_TRUE(client->SetTimeout(0, nullptr));
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_EQ(fired.load(), 1);
+
+    client->Close(true);
+}
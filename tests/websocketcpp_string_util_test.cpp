@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <thread>
+
+#include "StringUtil.h"
+#include "common.h"
+
+using namespace WebSocketCpp;
+
+static size_t NaiveSearch(const ByteArray& str, const ByteArray& substring, size_t start, size_t end)
+{
+    if (str.empty() || substring.empty())
+    {
+        return SIZE_MAX;
+    }
+    if (end >= str.size())
+    {
+        end = str.size() - 1;
+    }
+    for (size_t pos = start; pos + substring.size() <= end + 1; pos++)
+    {
+        if (std::equal(substring.begin(), substring.end(), str.begin() + pos))
+        {
+            return pos;
+        }
+    }
+    return SIZE_MAX;
+}
+
+TEST(StringUtil, SearchPositionBasic)
+{
+    ByteArray str = StringUtil::String2ByteArray("GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+
+    EXPECT_EQ(StringUtil::SearchPosition(str, {CR, LF}), 14u);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {CRLFCRLF}), 23u);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'H'}, 5), 6u);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'x', 'y'}), SIZE_MAX);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {}), SIZE_MAX);
+    EXPECT_EQ(StringUtil::SearchPosition(ByteArray{}, {'a'}), SIZE_MAX);
+}
+
+TEST(StringUtil, SearchPositionRespectsRange)
+{
+    ByteArray str = StringUtil::String2ByteArray("abcabcabc");
+
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'a', 'b', 'c'}, 1), 3u);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'a', 'b', 'c'}, 1, 4), SIZE_MAX); // match would cross the end
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'a', 'b', 'c'}, 1, 5), 3u);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'a', 'b', 'c'}, 7), SIZE_MAX);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'a'}, 5, 100), 6u);
+    EXPECT_EQ(StringUtil::SearchPosition(str, {'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a'}), SIZE_MAX);
+}
+
+TEST(StringUtil, SearchPositionMatchesNaive)
+{
+    std::mt19937 rng(1);
+    for (int i = 0; i < 2000; i++)
+    {
+        // a small alphabet produces lots of partial matches
+        ByteArray str(rng() % 300);
+        for (auto& c : str)
+        {
+            c = 'a' + rng() % 3;
+        }
+        ByteArray needle(1 + rng() % 6);
+        for (auto& c : needle)
+        {
+            c = 'a' + rng() % 3;
+        }
+        size_t start = str.empty() ? 0 : rng() % str.size();
+        size_t end   = (rng() % 4 == 0) ? SIZE_MAX : start + rng() % 300;
+
+        EXPECT_EQ(StringUtil::SearchPosition(str, needle, start, end), NaiveSearch(str, needle, start, end));
+    }
+}
+
+TEST(StringUtil, TokenizeLines)
+{
+    ByteArray          str = StringUtil::String2ByteArray("GET / HTTP/1.1\r\nHost: x\r\nUpgrade: websocket\r\n\r\nbody");
+    StringUtil::Ranges lines;
+
+    size_t end = StringUtil::TokenizeLines(str, 0, lines);
+    ASSERT_EQ(end, 45u);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(std::string(str.begin() + lines[0].start, str.begin() + lines[0].end + 1), "GET / HTTP/1.1");
+    EXPECT_EQ(std::string(str.begin() + lines[1].start, str.begin() + lines[1].end + 1), "Host: x");
+    EXPECT_EQ(std::string(str.begin() + lines[2].start, str.begin() + lines[2].end + 1), "Upgrade: websocket");
+}
+
+TEST(StringUtil, TokenizeLinesIncomplete)
+{
+    ByteArray          str = StringUtil::String2ByteArray("GET / HTTP/1.1\r\nHost: x\r\nUpgr");
+    StringUtil::Ranges lines;
+
+    EXPECT_EQ(StringUtil::TokenizeLines(str, 0, lines), SIZE_MAX);
+    EXPECT_EQ(lines.size(), 2u);
+}
+
+TEST(StringUtil, MaskCopyMatchesBytewise)
+{
+    std::mt19937 rng(7);
+    ByteArray    src(300);
+    for (auto& c : src)
+    {
+        c = static_cast<uint8_t>(rng());
+    }
+
+    const uint32_t key      = 0xA1B2C3D4;
+    const uint8_t* keyBytes = reinterpret_cast<const uint8_t*>(&key);
+    for (size_t offset = 0; offset < 4; offset++)
+    {
+        for (size_t size = 0; size + offset <= 100; size++)
+        {
+            ByteArray dst(size + 1, 0xEE);
+            StringUtil::MaskCopy(dst.data(), src.data() + offset, size, key);
+            for (size_t i = 0; i < size; i++)
+            {
+                ASSERT_EQ(dst[i], src[offset + i] ^ keyBytes[i % 4]) << "size " << size << " offset " << offset << " at " << i;
+            }
+            EXPECT_EQ(dst[size], 0xEE);
+        }
+    }
+}
+
+TEST(StringUtil, MaskCopyInPlaceRoundTrip)
+{
+    ByteArray data = StringUtil::String2ByteArray("in place masking must give the original bytes back");
+    ByteArray copy = data;
+
+    StringUtil::MaskCopy(copy.data(), copy.data(), copy.size(), 0x12345678);
+    EXPECT_NE(copy, data);
+    StringUtil::MaskCopy(copy.data(), copy.data(), copy.size(), 0x12345678);
+    EXPECT_EQ(copy, data);
+}
+
+TEST(StringUtil, MaskKeyPerThread)
+{
+    std::set<uint32_t> keys;
+    for (int i = 0; i < 1000; i++)
+    {
+        keys.insert(StringUtil::MaskKey());
+    }
+    EXPECT_GT(keys.size(), 990u);
+
+    // every thread has its own independently seeded generator
+    uint32_t other[4];
+    std::thread([&other]() {
+        for (auto& key : other)
+        {
+            key = StringUtil::MaskKey();
+        }
+    }).join();
+    size_t repeated = 0;
+    for (auto key : other)
+    {
+        repeated += keys.count(key);
+    }
+    EXPECT_LT(repeated, 4u);
+}
@@ -22,6 +22,11 @@
 
 #include <gtest/gtest.h>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <condition_variable>
 #include <csignal>
 #include <future>
@@ -30,6 +35,7 @@
 #include <thread>
 
 #include "DebugPrint.h"
+#include "Metrics.h"
 #include "Request.h"
 #include "ResponseWebSocket.h"
 #include "StringUtil.h"
@@ -304,6 +310,379 @@ TEST_F(WebSocketFixture, OneServerNClient)
     server.Close();
 }
 
+// Open clients asynchronously through a stub resolver, every one reports the
+// result via OnConnect and gets its message echoed back
+TEST_F(WebSocketFixture, OneServerAsyncClients)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(8080);
+    config.SetMaxClientCount(client_count);
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    });
+
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    auto resolver = std::make_shared<WebSocketCpp::StaticResolver>();
+    resolver->Add("ws.test", "127.0.0.1");
+
+    std::atomic<size_t> opened{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> echoed{0};
+
+    std::vector<std::unique_ptr<WebSocketCpp::WebSocketClient>> clients;
+    for (size_t i = 0; i < client_count; i++)
+    {
+        std::unique_ptr<WebSocketCpp::WebSocketClient> client(new WebSocketCpp::WebSocketClient());
+        WebSocketCpp::WebSocketClient*                 ptr = client.get();
+        client->SetResolver(resolver);
+        client->SetOnConnect([this, ptr, &opened, &failed](bool ok) {
+            (ok ? opened : failed)++;
+            if (ok)
+            {
+                ptr->SendText("async");
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            cv.notify_all();
+        });
+        client->SetOnMessage([this, &echoed](WebSocketCpp::ResponseWebSocket& response) -> bool {
+            if (StringUtil::ByteArray2String(response.GetData()) == "async")
+            {
+                echoed++;
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            cv.notify_all();
+            return true;
+        });
+        ASSERT_TRUE(client->Init());
+        ASSERT_TRUE(client->OpenAsync("ws://ws.test:8080/ws")) << client->GetLastError();
+        clients.push_back(std::move(client));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return echoed.load() == client_count; }));
+    }
+    EXPECT_EQ(opened.load(), client_count);
+    EXPECT_EQ(failed.load(), 0u);
+
+    WebSocketCpp::WebSocketClient missing;
+    missing.SetResolver(resolver);
+    std::atomic<int> missing_result{-1};
+    missing.SetOnConnect([this, &missing_result](bool ok) {
+        missing_result = ok ? 1 : 0;
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    });
+    ASSERT_TRUE(missing.Init());
+    ASSERT_TRUE(missing.OpenAsync("ws://nowhere.test:8080/ws"));
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(2), [&]() { return missing_result.load() != -1; }));
+    }
+    EXPECT_EQ(missing_result.load(), 0);
+
+    for (auto& client : clients)
+    {
+        client->Close();
+    }
+    server.Close();
+}
+
+// Kill the server under a reconnecting client and start it again: the messages
+// sent meanwhile are queued up to ClientSendQueueSize and delivered after the
+// new handshake
+TEST_F(WebSocketFixture, ReconnectAfterServerRestart)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(8080);
+    config.SetClientReconnect(true);
+    config.SetClientReconnectMinMs(20);
+    config.SetClientReconnectMaxMs(100);
+    config.SetClientSendQueueSize(2);
+
+    auto handler = [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    };
+
+    std::unique_ptr<WebSocketCpp::WebSocketServer> server(new WebSocketCpp::WebSocketServer());
+    ASSERT_TRUE(server->Init()) << server->GetLastError();
+    server->OnMessage("/ws", handler);
+    ASSERT_TRUE(server->Run()) << server->GetLastError();
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    std::atomic<int> connects{0};
+    std::atomic<int> closes{0};
+
+    WebSocketCpp::WebSocketClient client;
+    client.SetOnConnect([this, &connects](bool ok) {
+        if (ok)
+        {
+            connects++;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    });
+    client.SetOnClose([this, &closes]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closes++;
+        cv.notify_all();
+    });
+    client.SetOnMessage([this](WebSocketCpp::ResponseWebSocket& response) -> bool {
+        std::lock_guard<std::mutex> lock(mtx);
+        arr_client.push_back(StringUtil::ByteArray2String(response.GetData()));
+        cv.notify_all();
+        return true;
+    });
+    ASSERT_TRUE(client.Init());
+    ASSERT_TRUE(client.Open("ws://127.0.0.1:8080/ws")) << client.GetLastError();
+
+    auto wait = [this](std::function<bool()> pred) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock, std::chrono::seconds(5), pred);
+    };
+
+    ASSERT_TRUE(client.SendText("before"));
+    EXPECT_TRUE(wait([this]() { return arr_client.size() == 1; }));
+
+    server->Close();
+    server.reset();
+    EXPECT_TRUE(wait([&closes]() { return closes.load() >= 1; }));
+
+    EXPECT_TRUE(client.SendText("queued 1"));
+    EXPECT_TRUE(client.SendText("queued 2"));
+    EXPECT_FALSE(client.SendText("dropped"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    server.reset(new WebSocketCpp::WebSocketServer());
+    ASSERT_TRUE(server->Init()) << server->GetLastError();
+    server->OnMessage("/ws", handler);
+    ASSERT_TRUE(server->Run()) << server->GetLastError();
+
+    EXPECT_TRUE(wait([this, &connects]() { return connects.load() == 2 && arr_client.size() == 3; }));
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        EXPECT_EQ(arr_client, (std::vector<std::string>{"before", "queued 1", "queued 2"}));
+    }
+
+    ASSERT_TRUE(client.SendText("after"));
+    EXPECT_TRUE(wait([this]() { return arr_client.size() == 4; }));
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::ClientReconnects) - before.Get(WebSocketCpp::Metrics::Counter::ClientReconnects), 1u);
+    EXPECT_GE(after.Get(WebSocketCpp::Metrics::Counter::ClientReconnectAttempts) - before.Get(WebSocketCpp::Metrics::Counter::ClientReconnectAttempts), 2u);
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::ClientSendQueueDropped) - before.Get(WebSocketCpp::Metrics::Counter::ClientSendQueueDropped), 1u);
+    const auto& latency = after.Get(WebSocketCpp::Metrics::Histogram::ClientReconnectNs);
+    EXPECT_EQ(latency.count - before.Get(WebSocketCpp::Metrics::Histogram::ClientReconnectNs).count, 1u);
+
+    client.Close();
+    server->Close();
+
+    config.SetClientReconnect(false);
+}
+
+// a plain TCP peer that reads until the server closes, whatever it's sent
+static int RawConnect(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    struct timeval timeout{3, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static bool ReadUntilClosed(int fd)
+{
+    char    buffer[256];
+    ssize_t size;
+    while ((size = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    {
+    }
+    close(fd);
+    return size == 0;
+}
+
+// A connection that never upgrades is dropped at the handshake deadline, an upgraded
+// one that doesn't answer the ping at the pong deadline, WebSocketClient answers and stays
+TEST_F(WebSocketFixture, TimersPingAndHandshakeDeadline)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(8090);
+    config.SetMaxClientCount(4);
+    config.SetWsHandshakeTimeoutMs(200);
+    config.SetWsPingIntervalMs(100);
+    config.SetWsPongTimeoutMs(150);
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    int silent = RawConnect(8090);
+    ASSERT_GE(silent, 0);
+
+    // upgrades but never answers the pings
+    int         deaf    = RawConnect(8090);
+    std::string upgrade = "GET /ws HTTP/1.1\r\nHost: 127.0.0.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    ASSERT_GE(deaf, 0);
+    ASSERT_EQ(send(deaf, upgrade.data(), upgrade.size(), 0), static_cast<ssize_t>(upgrade.size()));
+
+    WebSocketCpp::WebSocketClient client;
+    client.SetOnMessage([this](WebSocketCpp::ResponseWebSocket& response) -> bool {
+        if (response.GetMessageType() == MessageType::Text)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            arr_client.push_back(StringUtil::ByteArray2String(response.GetData()));
+            cv.notify_all();
+        }
+        return true;
+    });
+    ASSERT_TRUE(client.Init());
+    ASSERT_TRUE(client.Open("ws://127.0.0.1:8090/ws")) << client.GetLastError();
+
+    EXPECT_TRUE(ReadUntilClosed(silent));
+    EXPECT_TRUE(ReadUntilClosed(deaf));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    ASSERT_TRUE(client.SendText("alive"));
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(2), [this]() { return arr_client.size() == 1; }));
+    }
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::HandshakeTimeouts) - before.Get(WebSocketCpp::Metrics::Counter::HandshakeTimeouts), 1u);
+    EXPECT_GE(after.Get(WebSocketCpp::Metrics::Counter::FramesOutPing) - before.Get(WebSocketCpp::Metrics::Counter::FramesOutPing), 2u);
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::PongTimeouts) - before.Get(WebSocketCpp::Metrics::Counter::PongTimeouts), 1u);
+
+    client.Close();
+    server.Close();
+
+    config.SetWsHandshakeTimeoutMs(0);
+    config.SetWsPingIntervalMs(0);
+    config.SetWsPongTimeoutMs(0);
+}
+
+TEST_F(WebSocketFixture, IdleTimeoutClosesConnection)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(8091);
+    config.SetWsPingIntervalMs(0);
+    config.SetWsIdleTimeoutMs(200);
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket&, const WebSocketCpp::ByteArray&) -> bool {
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    std::atomic<int>              closes{0};
+    WebSocketCpp::WebSocketClient client;
+    client.SetOnClose([this, &closes]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closes++;
+        cv.notify_all();
+    });
+    ASSERT_TRUE(client.Init());
+    ASSERT_TRUE(client.Open("ws://127.0.0.1:8091/ws")) << client.GetLastError();
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(2), [&closes]() { return closes.load() == 1; }));
+    }
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::IdleTimeouts) - before.Get(WebSocketCpp::Metrics::Counter::IdleTimeouts), 1u);
+
+    client.Close();
+    server.Close();
+
+    config.SetWsIdleTimeoutMs(0);
+}
+
+// A broken request line gets a 400 and the connection is closed, the server goes on
+TEST_F(WebSocketFixture, BrokenRequestIsRejected)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WS);
+    config.SetWsServerPort(8092);
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    int         broken  = RawConnect(8092);
+    std::string request = "BROKEN\r\n\r\n";
+    ASSERT_GE(broken, 0);
+    ASSERT_EQ(send(broken, request.data(), request.size(), MSG_NOSIGNAL), static_cast<ssize_t>(request.size()));
+
+    std::string answer;
+    char        buffer[256];
+    ssize_t     size;
+    while ((size = recv(broken, buffer, sizeof(buffer), 0)) > 0)
+    {
+        answer.append(buffer, static_cast<size_t>(size));
+    }
+    close(broken);
+    EXPECT_EQ(size, 0);
+    EXPECT_EQ(answer.compare(0, 12, "HTTP/1.1 400"), 0) << answer;
+
+    WebSocketCpp::WebSocketClient client;
+    client.SetOnMessage([this](WebSocketCpp::ResponseWebSocket& response) -> bool {
+        std::lock_guard<std::mutex> lock(mtx);
+        arr_client.push_back(StringUtil::ByteArray2String(response.GetData()));
+        cv.notify_all();
+        return true;
+    });
+    ASSERT_TRUE(client.Init());
+    ASSERT_TRUE(client.Open("ws://127.0.0.1:8092/ws")) << client.GetLastError();
+    ASSERT_TRUE(client.SendText("alive"));
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(2), [this]() { return arr_client.size() == 1; }));
+    }
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::ParseErrors) - before.Get(WebSocketCpp::Metrics::Counter::ParseErrors), 1u);
+
+    client.Close();
+    server.Close();
+}
+
 #ifdef WITH_OPENSSL
 // Same as OneServerNClient but over WSS (TLS)
 TEST_F(WebSocketFixture, OneServerNClientSsl)
@@ -388,4 +767,170 @@ TEST_F(WebSocketFixture, OneServerNClientSsl)
     // Reset protocol back to WS so other tests are not affected
     config.SetWsProtocol(Protocol::WS);
 }
+
+// kernel TLS is only asked for, without the kernel module OpenSSL keeps the records
+TEST_F(WebSocketFixture, SslKtlsLargeBinaryEcho)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WSS);
+    config.SetWsServerPort(8444);
+    config.SetSslSertificate(TEST_CERT_DIR "/test_cert.pem");
+    config.SetSslKey(TEST_CERT_DIR "/test_key.pem");
+    config.SetSslKtls(true);
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteBinary(data);
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    std::mutex               mtx;
+    std::condition_variable  cv;
+    WebSocketCpp::ByteArray  received;
+    WebSocketCpp::ByteArray  sent(64 * 1024);
+    for (size_t i = 0; i < sent.size(); i++)
+    {
+        sent[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    WebSocketCpp::WebSocketClient client;
+    client.SetOnMessage([&](WebSocketCpp::ResponseWebSocket& response) -> bool {
+        std::lock_guard<std::mutex> lock(mtx);
+        received = response.GetData();
+        cv.notify_one();
+        return true;
+    });
+    ASSERT_TRUE(client.Open("wss://127.0.0.1:8444/ws")) << client.GetLastError();
+    ASSERT_TRUE(client.SendBinary(sent));
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&received]() { return !received.empty(); }));
+        EXPECT_EQ(received, sent);
+    }
+    client.Close();
+    server.Close();
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    uint64_t kernel = after.Get(WebSocketCpp::Metrics::Counter::TlsKernelConnections) - before.Get(WebSocketCpp::Metrics::Counter::TlsKernelConnections);
+    uint64_t user   = after.Get(WebSocketCpp::Metrics::Counter::TlsUserConnections) - before.Get(WebSocketCpp::Metrics::Counter::TlsUserConnections);
+    EXPECT_EQ(kernel + user, 1u);
+
+    config.SetSslKtls(false);
+    config.SetWsProtocol(Protocol::WS);
+}
+
+// the first connection gets a ticket, the next ones resume the session with it
+TEST_F(WebSocketFixture, SslReconnectResumesSession)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WSS);
+    config.SetWsServerPort(8445);
+    config.SetSslSertificate(TEST_CERT_DIR "/test_cert.pem");
+    config.SetSslKey(TEST_CERT_DIR "/test_key.pem");
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    const size_t reconnects = 3;
+    for (size_t i = 0; i <= reconnects; i++)
+    {
+        std::mutex              mtx;
+        std::condition_variable cv;
+        bool                    echoed = false;
+
+        WebSocketCpp::WebSocketClient client;
+        client.SetOnMessage([&](WebSocketCpp::ResponseWebSocket&) -> bool {
+            std::lock_guard<std::mutex> lock(mtx);
+            echoed = true;
+            cv.notify_one();
+            return true;
+        });
+        ASSERT_TRUE(client.Open("wss://127.0.0.1:8445/ws")) << client.GetLastError();
+        ASSERT_TRUE(client.SendText("ping"));
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(2), [&echoed]() { return echoed; }));
+        }
+        client.Close();
+    }
+    server.Close();
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::ClientTlsResumed) - before.Get(WebSocketCpp::Metrics::Counter::ClientTlsResumed), reconnects);
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::TlsResumed) - before.Get(WebSocketCpp::Metrics::Counter::TlsResumed), reconnects);
+
+    config.SetWsProtocol(Protocol::WS);
+}
+
+// A failed TLS handshake, whether garbage or the handshake deadline, gives the only
+// slot back, so the next client still gets in
+TEST_F(WebSocketFixture, SslFailedHandshakeFreesSlot)
+{
+    WebSocketCpp::Config& config = WebSocketCpp::Config::Instance();
+    config.SetWsProtocol(Protocol::WSS);
+    config.SetWsServerPort(8446);
+    config.SetMaxClientCount(1);
+    config.SetWsHandshakeTimeoutMs(200);
+    config.SetSslSertificate(TEST_CERT_DIR "/test_cert.pem");
+    config.SetSslKey(TEST_CERT_DIR "/test_key.pem");
+
+    WebSocketCpp::WebSocketServer server;
+    ASSERT_TRUE(server.Init()) << server.GetLastError();
+    server.OnMessage("/ws", [](const WebSocketCpp::Request&, WebSocketCpp::ResponseWebSocket& response, const WebSocketCpp::ByteArray& data) -> bool {
+        response.WriteText(data);
+        return true;
+    });
+    ASSERT_TRUE(server.Run()) << server.GetLastError();
+
+    const WebSocketCpp::Metrics::Snapshot before = WebSocketCpp::Metrics::Instance().GetSnapshot();
+
+    int silent = RawConnect(8446);
+    ASSERT_GE(silent, 0);
+    EXPECT_TRUE(ReadUntilClosed(silent));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // the slot is given back just after the close
+
+    const char  request[] = "GET /ws HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    int         plain     = RawConnect(8446);
+    ASSERT_GE(plain, 0);
+    ASSERT_EQ(send(plain, request, sizeof(request) - 1, MSG_NOSIGNAL), static_cast<ssize_t>(sizeof(request) - 1));
+    EXPECT_TRUE(ReadUntilClosed(plain));
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+    bool                    echoed = false;
+
+    WebSocketCpp::WebSocketClient client;
+    client.SetOnMessage([&](WebSocketCpp::ResponseWebSocket&) -> bool {
+        std::lock_guard<std::mutex> lock(mtx);
+        echoed = true;
+        cv.notify_one();
+        return true;
+    });
+    ASSERT_TRUE(client.Open("wss://127.0.0.1:8446/ws")) << client.GetLastError();
+    ASSERT_TRUE(client.SendText("ping"));
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(2), [&echoed]() { return echoed; }));
+    }
+    client.Close();
+    server.Close();
+
+    const WebSocketCpp::Metrics::Snapshot after = WebSocketCpp::Metrics::Instance().GetSnapshot();
+    EXPECT_EQ(after.Get(WebSocketCpp::Metrics::Counter::HandshakeTimeouts) - before.Get(WebSocketCpp::Metrics::Counter::HandshakeTimeouts), 1u);
+
+    config.SetMaxClientCount(2);
+    config.SetWsHandshakeTimeoutMs(0);
+    config.SetWsProtocol(Protocol::WS);
+}
 #endif // WITH_OPENSSL
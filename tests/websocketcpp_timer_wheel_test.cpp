@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026 ruslan@muhlinin.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "TimerWheel.h"
+
+using namespace WebSocketCpp;
+
+static const uint64_t START = 1000000;
+static const uint64_t TICK  = 10;
+
+// steps the wheel the way the reactor does and records when each timer fired
+static std::vector<uint64_t> Drive(TimerWheel& wheel, size_t count, uint64_t until, uint64_t step = TICK)
+{
+    std::vector<uint64_t> fired(count, 0);
+    for (uint64_t now = START; now <= until; now += step)
+    {
+        wheel.Advance(now, [&fired, now](uint32_t id) { fired[id] = now; });
+    }
+    return fired;
+}
+
+TEST(TimerWheel, FiresOnTimeNotBefore)
+{
+    TimerWheel wheel(4, TICK, START);
+    wheel.Schedule(0, START + 5);
+    wheel.Schedule(1, START + 10);
+    wheel.Schedule(2, START + 155);
+    EXPECT_EQ(wheel.GetCount(), 3u);
+
+    auto fired = Drive(wheel, 4, START + 300);
+    EXPECT_EQ(fired[0], START + 10);
+    EXPECT_EQ(fired[1], START + 10);
+    EXPECT_EQ(fired[2], START + 160);
+    EXPECT_EQ(fired[3], 0u);
+    EXPECT_EQ(wheel.GetCount(), 0u);
+}
+
+TEST(TimerWheel, CancelAndReschedule)
+{
+    TimerWheel wheel(3, TICK, START);
+    wheel.Schedule(0, START + 100);
+    wheel.Schedule(1, START + 100);
+    wheel.Schedule(2, START + 100);
+    wheel.Cancel(1);
+    wheel.Schedule(2, START + 200); // replaces the first expiry
+    EXPECT_FALSE(wheel.IsScheduled(1));
+    EXPECT_TRUE(wheel.IsScheduled(2));
+    EXPECT_EQ(wheel.GetCount(), 2u);
+
+    auto fired = Drive(wheel, 3, START + 400);
+    EXPECT_EQ(fired[0], START + 100);
+    EXPECT_EQ(fired[1], 0u);
+    EXPECT_EQ(fired[2], START + 200);
+}
+
+TEST(TimerWheel, CascadesFromUpperLevels)
+{
+    // one timer per level and one past the whole range, each has to come down in time
+    const uint64_t delays[] = {630, 64 * 64 * TICK + 70, 64 * 64 * 64 * TICK + 30, 64ULL * 64 * 64 * 64 * TICK + 40};
+    TimerWheel     wheel(4, TICK, START);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        wheel.Schedule(i, START + delays[i]);
+    }
+
+    std::vector<uint64_t> fired(4, 0);
+    for (uint64_t now = START; wheel.GetCount() > 0 && now <= START + delays[3] + TICK; now += TICK)
+    {
+        wheel.Advance(now, [&fired, now](uint32_t id) { fired[id] = now; });
+    }
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(fired[i], START + delays[i]) << "timer " << i;
+    }
+}
+
+TEST(TimerWheel, CoarseAdvanceCatchesUp)
+{
+    TimerWheel wheel(64, TICK, START);
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        wheel.Schedule(i, START + i * 97);
+    }
+
+    size_t expired = wheel.Advance(START + 10000, [](uint32_t) {});
+    EXPECT_EQ(expired, 64u);
+    EXPECT_EQ(wheel.GetCount(), 0u);
+}
+
+TEST(TimerWheel, CallbackSchedulesAgain)
+{
+    TimerWheel wheel(2, TICK, START);
+    wheel.Schedule(0, START + 50);
+
+    size_t calls = 0;
+    for (uint64_t now = START; now <= START + 1000; now += TICK)
+    {
+        wheel.Advance(now, [&](uint32_t id) {
+            calls++;
+            // a whole turn of the lowest level later, lands in the slot being expired
+            wheel.Schedule(id, now + 64 * TICK);
+        });
+    }
+    EXPECT_EQ(calls, 2u); // at 50 and 690
+    EXPECT_TRUE(wheel.IsScheduled(0));
+}
+
+TEST(TimerWheel, NextTimeout)
+{
+    TimerWheel wheel(2, TICK, START);
+    EXPECT_EQ(wheel.NextTimeoutMs(START), UINT64_MAX);
+
+    wheel.Advance(START, [](uint32_t) {});
+    wheel.Schedule(0, START + 45);
+    EXPECT_EQ(wheel.NextTimeoutMs(START + 3), 47u);
+
+    // further than the lowest level, the wheel wakes up on its wrap around
+    wheel.Schedule(0, START + 100000);
+    EXPECT_EQ(wheel.NextTimeoutMs(START), 64 * TICK);
+}
@@ -0,0 +1,38 @@
+/*
+ * Prints the binary access log (Config::LogBinaryAccess) as text, one record per line.
+ * Usage: WebSocketCppAccessLogDecode access.bin [access.bin.1 ...]
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "AccessLog.h"
+
+using namespace WebSocketCpp;
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <access.bin> [...]" << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::vector<AccessLog::Record> records;
+        if (!AccessLog::Load(argv[i], records))
+        {
+            std::cerr << argv[i] << ": not an access log or truncated" << std::endl;
+            result = 1;
+        }
+
+        for (auto& record : records)
+        {
+            std::cout << AccessLog::ToString(record) << "\n";
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,529 @@
+/*
+ * Opens many WebSocketClient connections to an echo server and drives them with
+ * messages of the given size, either as fast as the echoes come back or at a fixed
+ * rate per connection. Reports the connection setup rate, the throughput and the
+ * round trip latency. Without --url an echo WebSocketServer is started in-process.
+ * Usage: WebSocketCppLoadGenerator [options], -h for the list
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DebugPrint.h"
+#include "Metrics.h"
+#include "WebSocketClient.h"
+#include "WebSocketServer.h"
+
+using namespace WebSocketCpp;
+
+struct Options
+{
+    std::string url;
+    size_t      connections      = 100;
+    size_t      size             = 64;
+    double      rate             = 0; // messages per second per connection, 0 - closed loop
+    size_t      window           = 1; // messages in flight per connection in the closed loop
+    double      duration         = 10;
+    double      warmup           = 1;
+    size_t      threads          = 4;
+    size_t      setupThreads     = 4;
+    size_t      reactorThreads   = 1; // threads of the client reactor driving all the connections
+    uint64_t    connectTimeoutMs = 5000;
+    bool        json             = false;
+};
+
+// in the open loop a connection falls behind when that many messages are unanswered
+static const uint32_t MAX_IN_FLIGHT = 1000;
+static const size_t   STAMP_SIZE    = sizeof(uint64_t);
+
+using Histogram = Metrics::HistogramData;
+
+struct LoadConnection
+{
+    WebSocketClient       client;
+    bool                  opened = false;
+    std::atomic<uint32_t> inFlight{0};
+    uint64_t              nextSend = 0;
+    uint64_t              late     = 0; // open loop sends skipped since MAX_IN_FLIGHT was reached
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> received{0};
+    Histogram             latency; // written by the client read thread only
+};
+
+static std::atomic<bool> recording{false};
+
+static void Reset(Histogram& histogram)
+{
+    histogram.count = 0;
+    histogram.sum   = 0;
+    histogram.buckets.assign(Metrics::BUCKET_COUNT, 0);
+}
+
+static void Record(Histogram& histogram, uint64_t value)
+{
+    histogram.buckets[Metrics::BucketIndex(value)]++;
+    histogram.count++;
+    histogram.sum += value;
+}
+
+static void Merge(Histogram& to, const Histogram& from)
+{
+    for (size_t i = 0; i < Metrics::BUCKET_COUNT; i++)
+    {
+        to.buckets[i] += from.buckets[i];
+    }
+    to.count += from.count;
+    to.sum += from.sum;
+}
+
+static int FindFreePort()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+    int port = ntohs(addr.sin_port);
+    ::close(fd);
+    return port;
+}
+
+// every connection takes a descriptor on both sides when the server is local
+static void RaiseFileLimit(size_t needed)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < needed)
+    {
+        fprintf(stderr, "warning: the descriptor limit is %llu, about %zu are needed\n", static_cast<unsigned long long>(limit.rlim_cur), needed);
+    }
+}
+
+static void OnMessage(LoadConnection* connection, ResponseWebSocket& response)
+{
+    const ByteArray& data = response.GetData();
+    if (data.size() >= STAMP_SIZE && recording)
+    {
+        uint64_t stamp;
+        std::memcpy(&stamp, data.data(), STAMP_SIZE);
+        uint64_t now = Metrics::Now();
+        Record(connection->latency, now > stamp ? now - stamp : 0);
+    }
+    connection->received++;
+    if (connection->inFlight > 0)
+    {
+        connection->inFlight--;
+    }
+}
+
+static bool Send(LoadConnection* connection, ByteArray& payload, uint64_t stamp)
+{
+    std::memcpy(payload.data(), &stamp, STAMP_SIZE);
+    connection->inFlight++;
+    if (!connection->client.SendBinary(payload))
+    {
+        connection->inFlight--;
+        return false;
+    }
+    connection->sent++;
+    return true;
+}
+
+/*
+ * In the open loop the message carries the time it was due, not the time it was sent,
+ * so a stalled connection shows up in the latency instead of just sending later.
+ */
+static void Drive(const Options& options, std::vector<LoadConnection*> connections, uint64_t end)
+{
+    ByteArray payload(options.size, 'x');
+    uint64_t  interval = options.rate > 0 ? static_cast<uint64_t>(1e9 / options.rate) : 0;
+    uint64_t  now      = Metrics::Now();
+
+    for (size_t i = 0; i < connections.size(); i++)
+    {
+        // spread the first messages over the interval
+        connections[i]->nextSend = now + (interval * i) / std::max<size_t>(connections.size(), 1);
+    }
+
+    while ((now = Metrics::Now()) < end)
+    {
+        bool busy = false;
+        for (auto connection : connections)
+        {
+            if (interval > 0)
+            {
+                while (connection->nextSend <= now)
+                {
+                    if (connection->inFlight >= MAX_IN_FLIGHT)
+                    {
+                        connection->late++;
+                    }
+                    else
+                    {
+                        Send(connection, payload, connection->nextSend);
+                    }
+                    connection->nextSend += interval;
+                    busy = true;
+                }
+            }
+            else
+            {
+                while (connection->inFlight < options.window)
+                {
+                    if (!Send(connection, payload, Metrics::Now()))
+                    {
+                        break;
+                    }
+                    busy = true;
+                }
+            }
+        }
+
+        if (!busy)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(interval > 0 ? 100 : 10));
+        }
+    }
+}
+
+static double Seconds(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e9;
+}
+
+static double Us(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e3;
+}
+
+static void PrintUsage(const char* exe)
+{
+    printf("Usage: %s [options]\n", exe);
+    printf("where [options] are:\n");
+    printf("\t--url <url>: echo server to load, ws://host:port/path, by default a local server is started\n");
+    printf("\t--connections <n>: connections to open, default 100\n");
+    printf("\t--size <bytes>: message size, at least 8, default 64\n");
+    printf("\t--rate <n>: messages per second per connection, default 0 - as fast as the echoes come back\n");
+    printf("\t--window <n>: messages in flight per connection if the rate is 0, default 1\n");
+    printf("\t--duration <sec>: measured time, default 10\n");
+    printf("\t--warmup <sec>: time before the measurement, default 1\n");
+    printf("\t--threads <n>: sending threads, default 4\n");
+    printf("\t--setup-threads <n>: threads opening the connections, default 4\n");
+    printf("\t--reactor-threads <n>: threads reading all the connections, default 1\n");
+    printf("\t--connect-timeout <ms>: handshake timeout, default 5000\n");
+    printf("\t--json: print the report as JSON\n");
+    printf("\t-h: print this message and exit\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg   = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--json")
+        {
+            options.json = true;
+            continue;
+        }
+        if (value == nullptr)
+        {
+            return false;
+        }
+        i++;
+
+        if (arg == "--url")
+        {
+            options.url = value;
+        }
+        else if (arg == "--connections")
+        {
+            options.connections = strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--size")
+        {
+            options.size = strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--rate")
+        {
+            options.rate = strtod(value, nullptr);
+        }
+        else if (arg == "--window")
+        {
+            options.window = strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--duration")
+        {
+            options.duration = strtod(value, nullptr);
+        }
+        else if (arg == "--warmup")
+        {
+            options.warmup = strtod(value, nullptr);
+        }
+        else if (arg == "--threads")
+        {
+            options.threads = strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--setup-threads")
+        {
+            options.setupThreads = strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--reactor-threads")
+        {
+            options.reactorThreads = strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--connect-timeout")
+        {
+            options.connectTimeoutMs = strtoull(value, nullptr, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.connections > 0 && options.size >= STAMP_SIZE && options.window > 0 && options.threads > 0 && options.setupThreads > 0 && options.duration > 0;
+}
+
+int main(int argc, char** argv)
+{
+    DebugPrint::AllowPrint = false;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage(argv[0]);
+        return (argc == 2 && std::string(argv[1]) == "-h") ? 0 : 1;
+    }
+
+    if (!options.url.empty())
+    {
+        Url url;
+        url.Parse(options.url);
+        if (!url.IsInitiaized() || (url.GetScheme() != Url::Scheme::WS && url.GetScheme() != Url::Scheme::WSS))
+        {
+            fprintf(stderr, "incorrect url: %s\n", options.url.c_str());
+            return 1;
+        }
+    }
+
+    Config& config = Config::Instance();
+    config.SetClientConnectTimeoutMs(options.connectTimeoutMs);
+    config.SetClientReactorThreads(options.reactorThreads);
+    RaiseFileLimit(options.connections * 2 + 64);
+
+    std::unique_ptr<WebSocketServer> server;
+    if (options.url.empty())
+    {
+        int port = FindFreePort();
+        config.SetWsProtocol(Protocol::WS);
+        config.SetWsServerPort(port);
+        config.SetMaxClientCount(options.connections);
+
+        server.reset(new WebSocketServer());
+        if (!server->Init())
+        {
+            fprintf(stderr, "server init failed: %s\n", server->GetLastError().c_str());
+            return 1;
+        }
+        server->OnMessage("/echo", [](const Request&, ResponseWebSocket& response, const ByteArray& data) -> bool {
+            response.WriteBinary(data);
+            return true;
+        });
+        if (!server->Run())
+        {
+            fprintf(stderr, "server run failed: %s\n", server->GetLastError().c_str());
+            return 1;
+        }
+        options.url = "ws://127.0.0.1:" + std::to_string(port) + "/echo";
+    }
+
+    std::vector<std::unique_ptr<LoadConnection>> connections;
+    connections.reserve(options.connections);
+    for (size_t i = 0; i < options.connections; i++)
+    {
+        connections.emplace_back(new LoadConnection());
+        LoadConnection* connection = connections.back().get();
+        Reset(connection->latency);
+        connection->client.SetOnMessage([connection](ResponseWebSocket& response) {
+            OnMessage(connection, response);
+        });
+        connection->client.Init();
+    }
+
+    // setup
+    std::atomic<size_t>      next{0};
+    std::vector<Histogram>   setupLatency(options.setupThreads);
+    std::vector<std::thread> threads;
+    uint64_t                 setupStart = Metrics::Now();
+    for (size_t t = 0; t < options.setupThreads; t++)
+    {
+        Reset(setupLatency[t]);
+        threads.emplace_back([&, t]() {
+            size_t index;
+            while ((index = next++) < connections.size())
+            {
+                uint64_t start             = Metrics::Now();
+                connections[index]->opened = connections[index]->client.Open(options.url);
+                if (connections[index]->opened)
+                {
+                    Record(setupLatency[t], Metrics::Now() - start);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+    uint64_t setupTime = Metrics::Now() - setupStart;
+
+    Histogram setup;
+    Reset(setup);
+    for (auto& histogram : setupLatency)
+    {
+        Merge(setup, histogram);
+    }
+
+    std::vector<std::vector<LoadConnection*>> slices(options.threads);
+    size_t                                    opened = 0;
+    for (auto& connection : connections)
+    {
+        if (connection->opened)
+        {
+            slices[opened % options.threads].push_back(connection.get());
+            opened++;
+        }
+    }
+    if (opened == 0)
+    {
+        fprintf(stderr, "no connection to %s was opened: %s\n", options.url.c_str(), connections[0]->client.GetLastError().c_str());
+        return 1;
+    }
+
+    // load
+    uint64_t loadStart    = Metrics::Now();
+    uint64_t measureStart = loadStart + static_cast<uint64_t>(options.warmup * 1e9);
+    uint64_t loadEnd      = measureStart + static_cast<uint64_t>(options.duration * 1e9);
+    for (auto& slice : slices)
+    {
+        threads.emplace_back(Drive, std::cref(options), slice, loadEnd);
+    }
+
+    uint64_t sentBefore     = 0;
+    uint64_t receivedBefore = 0;
+    std::this_thread::sleep_for(std::chrono::nanoseconds(measureStart - Metrics::Now()));
+    for (auto& connection : connections)
+    {
+        sentBefore += connection->sent;
+        receivedBefore += connection->received;
+    }
+    recording = true;
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    uint64_t measured = Metrics::Now() - measureStart;
+    recording         = false;
+
+    uint64_t received = 0;
+    uint64_t sent     = 0;
+    uint64_t late     = 0;
+    for (auto& connection : connections)
+    {
+        received += connection->received;
+        sent += connection->sent;
+        late += connection->late;
+    }
+    received -= receivedBefore;
+    sent -= sentBefore;
+
+    // let the messages in flight come back, they aren't counted
+    for (int i = 0; i < 100; i++)
+    {
+        bool empty = true;
+        for (auto& connection : connections)
+        {
+            empty = empty && connection->inFlight == 0;
+        }
+        if (empty)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    for (auto& connection : connections)
+    {
+        if (connection->opened)
+        {
+            connection->client.Close();
+        }
+    }
+
+    Histogram latency;
+    Reset(latency);
+    for (auto& connection : connections)
+    {
+        Merge(latency, connection->latency);
+    }
+
+    if (server != nullptr)
+    {
+        server->Close();
+    }
+
+    double seconds    = Seconds(measured);
+    double setupRate  = opened / Seconds(setupTime);
+    double messages   = received / seconds;
+    double throughput = messages * options.size;
+
+    if (options.json)
+    {
+        printf("{\"url\": \"%s\", \"connections\": %zu, \"opened\": %zu, \"size\": %zu, \"rate\": %.3f, \"window\": %zu, \"seconds\": %.3f,\n",
+            options.url.c_str(), options.connections, opened, options.size, options.rate, options.window, seconds);
+        printf(" \"setup_per_sec\": %.3f, \"setup_p50_us\": %.1f, \"setup_p99_us\": %.1f, \"setup_p999_us\": %.1f,\n",
+            setupRate, Us(setup.Percentile(50)), Us(setup.Percentile(99)), Us(setup.Percentile(99.9)));
+        printf(" \"sent\": %llu, \"received\": %llu, \"late\": %llu, \"messages_per_sec\": %.3f, \"bytes_per_sec\": %.3f,\n",
+            static_cast<unsigned long long>(sent), static_cast<unsigned long long>(received), static_cast<unsigned long long>(late), messages, throughput);
+        printf(" \"latency_mean_us\": %.1f, \"latency_p50_us\": %.1f, \"latency_p99_us\": %.1f, \"latency_p999_us\": %.1f}\n",
+            latency.Mean() / 1e3, Us(latency.Percentile(50)), Us(latency.Percentile(99)), Us(latency.Percentile(99.9)));
+    }
+    else
+    {
+        printf("target:      %s\n", options.url.c_str());
+        printf("connections: %zu of %zu opened in %.3f s, %.0f/s, p50 %.1f us p99 %.1f us p99.9 %.1f us\n",
+            opened, options.connections, Seconds(setupTime), setupRate, Us(setup.Percentile(50)), Us(setup.Percentile(99)), Us(setup.Percentile(99.9)));
+        printf("load:        %zu bytes, %s, %.1f s measured\n",
+            options.size, options.rate > 0 ? (std::to_string(options.rate) + " msg/s per connection").c_str() : (std::to_string(options.window) + " in flight per connection").c_str(), seconds);
+        printf("messages:    %llu sent, %llu received, %llu late\n", static_cast<unsigned long long>(sent), static_cast<unsigned long long>(received), static_cast<unsigned long long>(late));
+        printf("throughput:  %.0f msg/s, %.2f MB/s\n", messages, throughput / (1024 * 1024));
+        printf("latency:     mean %.1f us p50 %.1f us p99 %.1f us p99.9 %.1f us\n",
+            latency.Mean() / 1e3, Us(latency.Percentile(50)), Us(latency.Percentile(99)), Us(latency.Percentile(99.9)));
+    }
+
+    return opened == options.connections ? 0 : 1;
+}